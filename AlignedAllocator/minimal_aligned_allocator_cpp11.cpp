@@ -57,6 +57,12 @@ int main()
 
 	std::cout << ( dq.get_allocator() == v.get_allocator() ) << '\n';
 
+	aligned_vector<float, 64> avx512Data( 100, 1.0f );
+	std::cout << "64 byte aligned: "
+		<< isAligned( avx512Data.data(), 64 )
+		<< '\n';
+	std::cout << ( avx512Data.get_allocator() == AlignedAllocator<int, 32>{} ) << '\n';
+
 	std::system( "pause" );
 	return 0;
 }
\ No newline at end of file
@@ -2,39 +2,63 @@
 
 #include <type_traits>
 #include <cstddef>
+#include <new>
+#include <vector>
 #include "../allocator_utils.h"
 
 
 //======================================================================
 // minimal stateless aligned allocator C++11 compatible
-template <class T/*, std::size_t alignment = alignof( std::max_align_t )*/>
+//	every allocation starts on an `alignment` boundary (or `alignof( T )`, if stricter)
+//	so SIMD kernels can use aligned loads/stores on container data
+//	the alignment is part of the type: it survives rebinding, and allocators of
+//		different alignments don't compare equal as they can't free each other's memory
+template <class T, std::size_t alignment = alignof( std::max_align_t )>
 struct AlignedAllocator
 {
+	static_assert( isPowerOfTwo( alignment ),
+		"Alignment value must be a power of 2." );
+
 	using value_type = T;
+	using is_always_equal = std::true_type;
+
+	template<class U>
+	struct rebind
+	{
+		using other = AlignedAllocator<U, alignment>;
+	};
 
-	AlignedAllocator()
+	AlignedAllocator() noexcept
 	{
-		/*static_assert( isPowerOfTwo( alignment ),
-			"Alignment value must be a power of 2." );
-		*/
+
 	}
 
 	template<class U>
-	AlignedAllocator( const AlignedAllocator<U>& ) noexcept
+	AlignedAllocator( const AlignedAllocator<U, alignment>& ) noexcept
 	{
 
 	}
-	
+
+	// default-aligned types get plain malloc, see `alignedMalloc`
+	static constexpr std::size_t getAlignment() noexcept
+	{
+		constexpr std::size_t typeAlignment = alignof( T ) > alignment ?
+			alignof( T ) :
+			alignment;
+		return typeAlignment > sizeof( void* ) ?
+			typeAlignment :
+			sizeof( void* );
+	}
+
 	// allocates memory equal to count of objects of type T
-	template<std::size_t alignment = alignof( std::max_align_t )>
 	[[nodiscard]]
-	T* allocate( std::size_t n/*, std::size_t alignment = alignof(std::max_align_t)*/ )
+	T* allocate( std::size_t n )
 	{
 		if ( n > std::size_t( -1 ) / sizeof( T ) )
 		{
 			throw std::bad_alloc{};
 		}
-		if ( T* p = static_cast<T*>( alignedMalloc( sizeof( T ) * n, alignment ) ) )
+		if ( T* p = static_cast<T*>( alignedMalloc<getAlignment()>( sizeof( T ) * n ) ) )
 		{
 			return p;
 		}
@@ -44,20 +68,24 @@ struct AlignedAllocator
 	void deallocate( value_type* p,
 		[[maybe_unused]] std::size_t count ) noexcept
 	{
-		alignedFree( p );
+		alignedFree<getAlignment()>( p );
 	}
 };
 
-template<class T, class U>
-bool operator==( const AlignedAllocator<T>&,
-	const AlignedAllocator<U>& ) noexcept
+template<class T, std::size_t alignment1, class U, std::size_t alignment2>
+bool operator==( const AlignedAllocator<T, alignment1>&,
+	const AlignedAllocator<U, alignment2>& ) noexcept
 {
-	return true;
+	return alignment1 == alignment2;
 }
 
-template<class T, class U>
-bool operator!=( const AlignedAllocator<T>&,
-	const AlignedAllocator<U>& ) noexcept
+template<class T, std::size_t alignment1, class U, std::size_t alignment2>
+bool operator!=( const AlignedAllocator<T, alignment1>&,
+	const AlignedAllocator<U, alignment2>& ) noexcept
 {
-	return false;
-}
\ No newline at end of file
+	return alignment1 != alignment2;
+}
+
+// `data()` is `alignment` aligned, eg. aligned_vector<float, 32> for AVX2, aligned_vector<float, 64> for AVX-512
+template<class T, std::size_t alignment>
+using aligned_vector = std::vector<T, AlignedAllocator<T, alignment>>;
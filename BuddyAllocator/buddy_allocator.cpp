@@ -0,0 +1,97 @@
+#include <cstdlib>
+#include <iostream>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+#include "buddy_allocator.h"
+
+
+static void printStats( const char* name,
+	const BuddyHeap<>& heap )
+{
+	const AllocatorStats stats = heap.getStats();
+	std::cout << name
+		<< ": requested="
+		<< stats.requestedBytes
+		<< " rounding="
+		<< stats.paddingBytes
+		<< " free="
+		<< stats.freeBytes
+		<< " largest free block="
+		<< stats.largestFreeBlock
+		<< " internal fragmentation="
+		<< stats.getInternalFragmentation()
+		<< '\n';
+}
+
+int main()
+{
+	std::cout << std::boolalpha << '\n';
+
+	BuddyHeap<> heap{64 * 1024};
+
+	// raw blocks of assorted sizes, freed in a different order than they were allocated
+	const std::size_t sizes[] = {24, 100, 700, 64, 3000, 129, 1024, 40};
+	std::vector<void*> blocks;
+	for ( const std::size_t bytes : sizes )
+	{
+		blocks.push_back( heap.allocate( bytes ) );
+	}
+	printStats( "after 8 allocations",
+		heap );
+	for ( std::size_t i = 0; i < blocks.size(); i += 2 )
+	{
+		heap.deallocate( blocks[i],
+			sizes[i] );
+	}
+	printStats( "every other one freed",
+		heap );
+	for ( std::size_t i = 1; i < blocks.size(); i += 2 )
+	{
+		heap.deallocate( blocks[i],
+			sizes[i] );
+	}
+	// every buddy merged back: the heap is one free block again
+	printStats( "all freed",
+		heap );
+	std::cout << "whole heap free="
+		<< ( heap.getStats().largestFreeBlock == heap.getSize() )
+		<< '\n';
+
+	// std containers growing and shrinking through the same heap
+	using bstring = std::basic_string<char, std::char_traits<char>, BuddyAllocator<char>>;
+	BuddyAllocator<char> alloc{&heap};
+	{
+		std::vector<int, BuddyAllocator<int>> numbers{BuddyAllocator<int>{alloc}};
+		std::list<bstring, BuddyAllocator<bstring>> names{BuddyAllocator<bstring>{alloc}};
+		std::map<int, int, std::less<>, BuddyAllocator<std::pair<const int, int>>> squares{BuddyAllocator<std::pair<const int, int>>{alloc}};
+		for ( int i = 0; i < 200; ++i )
+		{
+			numbers.push_back( i );
+			squares.emplace( i,
+				i * i );
+			if ( i % 10 == 0 )
+			{
+				names.emplace_back( "a string long enough to leave the small buffer #" + std::to_string( i ),
+					alloc );
+			}
+		}
+		numbers.shrink_to_fit();
+		names.pop_front();
+		std::cout << "vector size="
+			<< numbers.size()
+			<< " list size="
+			<< names.size()
+			<< " squares[150]="
+			<< squares[150]
+			<< '\n';
+		printStats( "containers",
+			heap );
+	}
+	printStats( "containers destroyed",
+		heap );
+
+	std::system( "pause" );
+	return 0;
+}
@@ -0,0 +1,396 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <vector>
+#include "../allocator_stats.h"
+#include "../allocator_utils.h"
+#include "../assertions.h"
+
+
+//======================================================================
+// \class	BuddyHeap
+//
+// \brief	variable size allocations, freed in any order, inside one fixed block
+//			every allocation is rounded up to a power of 2 multiple of `minBlockSize`, its
+//				order; a block of order k splits into two "buddies" of order k - 1, whose
+//				addresses differ only in one bit, so a freed block finds its buddy with an
+//				xor and merges with it while it's free: splitting and merging are O(log n)
+//			a bitmap per order marks the free blocks, for the O(1) buddy check, and an
+//				intrusive doubly linked list per order holds them, for O(1) pops and removals;
+//				a bit per order in a mask skips the empty orders with one count trailing zeros
+//			no headers: the bitmaps are 2 bits per minimal block in total and the free list
+//				links live in the free blocks, so `deallocate()` needs the size that was
+//				allocated, as the std allocator interface passes it
+//			the heap size is rounded down to a power of 2; every block is aligned to
+//				`minBlockSize`
+//			internal fragmentation (the rounding) is reported as padding by `getStats()`
+//			not thread safe
+//======================================================================
+template<std::size_t minBlockSize = 64>
+class BuddyHeap
+{
+	static_assert( isPowerOfTwo( minBlockSize ),
+		"BuddyHeap minimal block size must be a power of 2." );
+
+	struct FreeBlock final
+	{
+		FreeBlock* pNext;
+		FreeBlock* pPrev;
+	};
+
+	static_assert( minBlockSize >= sizeof( FreeBlock ),
+		"BuddyHeap minimal block size must hold the free list links." );
+
+	static constexpr std::size_t m_minBlockLog2 = floorLog2( minBlockSize );
+	static constexpr std::size_t m_maxOrders = 64;
+
+	unsigned char* m_pData;
+	std::size_t m_size;
+	// the whole heap is the one block of the highest order
+	std::size_t m_maxOrder;
+	FreeBlock* m_freeLists[m_maxOrders];
+	// bit k is set while `m_freeLists[k]` isn't empty
+	std::uint64_t m_nonEmptyOrders;
+	std::vector<std::uint64_t> m_freeBits;
+	// where each order's bits start in `m_freeBits`
+	std::size_t m_orderBitOffsets[m_maxOrders];
+	std::size_t m_requestedBytes;
+	std::size_t m_allocatedBytes;
+public:
+	explicit BuddyHeap( const std::size_t size )
+		:
+		m_pData{nullptr},
+		m_size{std::size_t{1} << floorLog2( size )},
+		m_maxOrder{floorLog2( size ) - m_minBlockLog2},
+		m_freeLists{},
+		m_nonEmptyOrders{0},
+		m_freeBits{},
+		m_orderBitOffsets{},
+		m_requestedBytes{0},
+		m_allocatedBytes{0}
+	{
+		ASSERT( size >= minBlockSize,
+			"BuddyHeap smaller than its minimal block!" );
+		std::size_t nBits = 0;
+		for ( std::size_t order = 0; order <= m_maxOrder; ++order )
+		{
+			m_orderBitOffsets[order] = nBits;
+			nBits += getBlockCount( order );
+		}
+		m_freeBits.resize( ( nBits + 63 ) / 64 );
+		m_pData = static_cast<unsigned char*>( alignedMalloc<minBlockSize>( m_size ) );
+		reset();
+	}
+
+	~BuddyHeap() noexcept
+	{
+		alignedFree<minBlockSize>( m_pData );
+	}
+
+	BuddyHeap( const BuddyHeap& rhs ) = delete;
+	BuddyHeap& operator=( const BuddyHeap& rhs ) = delete;
+
+	// throws std::bad_alloc if no block of the needed order is free, even after splitting
+	[[nodiscard]]
+	void* allocate( const std::size_t bytes )
+	{
+		const std::size_t order = getOrder( bytes );
+		if ( order > m_maxOrder )
+		{
+			throw std::bad_alloc{};
+		}
+		const std::uint64_t candidates = m_nonEmptyOrders >> order;
+		if ( candidates == 0 )
+		{
+			throw std::bad_alloc{};
+		}
+		std::size_t blockOrder = order + countTrailingZeros( candidates );
+		FreeBlock* pBlock = m_freeLists[blockOrder];
+		removeFree( pBlock,
+			blockOrder );
+		// hand the upper halves back until the block is the size asked for
+		while ( blockOrder > order )
+		{
+			--blockOrder;
+			pushFree( reinterpret_cast<FreeBlock*>( reinterpret_cast<unsigned char*>( pBlock ) + getBlockSize( blockOrder ) ),
+				blockOrder );
+		}
+		m_requestedBytes += bytes;
+		m_allocatedBytes += getBlockSize( order );
+		return pBlock;
+	}
+
+	// `bytes` must be the size `p` was allocated with
+	void deallocate( void* p,
+		const std::size_t bytes ) noexcept
+	{
+		ASSERT( owns( p ),
+			"Pointer not from this BuddyHeap!" );
+		std::size_t order = getOrder( bytes );
+		std::size_t index = getOffset( p ) >> ( m_minBlockLog2 + order );
+		ASSERT( !isFree( order, index ),
+			"BuddyHeap block freed twice!" );
+		m_requestedBytes -= bytes;
+		m_allocatedBytes -= getBlockSize( order );
+		while ( order < m_maxOrder && isFree( order, index ^ 1 ) )
+		{
+			removeFree( getBlock( order, index ^ 1 ),
+				order );
+			index >>= 1;
+			++order;
+		}
+		pushFree( getBlock( order, index ),
+			order );
+	}
+
+	// frees everything at once: the heap is a single free block again
+	void reset() noexcept
+	{
+		std::fill( m_freeBits.begin(),
+			m_freeBits.end(),
+			std::uint64_t{0} );
+		std::fill( std::begin( m_freeLists ),
+			std::end( m_freeLists ),
+			nullptr );
+		m_nonEmptyOrders = 0;
+		m_requestedBytes = 0;
+		m_allocatedBytes = 0;
+		pushFree( reinterpret_cast<FreeBlock*>( m_pData ),
+			m_maxOrder );
+	}
+
+	// the bytes a request of `bytes` takes up
+	static constexpr std::size_t getAllocationSize( const std::size_t bytes ) noexcept
+	{
+		return getBlockSize( getOrder( bytes ) );
+	}
+
+	std::size_t getAvailableMemory() const noexcept
+	{
+		return m_size - m_allocatedBytes;
+	}
+
+	// the free memory is in blocks no larger than the largest free order
+	AllocatorStats getStats() const noexcept
+	{
+		AllocatorStats stats;
+		stats.requestedBytes = m_requestedBytes;
+		stats.paddingBytes = m_allocatedBytes - m_requestedBytes;
+		stats.freeBytes = m_size - m_allocatedBytes;
+		stats.largestFreeBlock = m_nonEmptyOrders == 0 ?
+			0 :
+			getBlockSize( floorLog2( m_nonEmptyOrders ) );
+		stats.totalBytes = m_size;
+		return stats;
+	}
+
+	bool owns( const void* p ) const noexcept
+	{
+		const std::size_t address = reinterpret_cast<std::size_t>( p );
+		return address >= reinterpret_cast<std::size_t>( m_pData )
+			&& address < reinterpret_cast<std::size_t>( m_pData ) + m_size;
+	}
+
+	// GETTERS
+	char* getStartAddress() const noexcept
+	{
+		return reinterpret_cast<char*>( m_pData );
+	}
+
+	std::size_t getSize() const noexcept
+	{
+		return m_size;
+	}
+
+	std::size_t getMaxOrder() const noexcept
+	{
+		return m_maxOrder;
+	}
+
+	static constexpr std::size_t getMinBlockSize() noexcept
+	{
+		return minBlockSize;
+	}
+
+	static constexpr std::size_t getAlignment() noexcept
+	{
+		return minBlockSize;
+	}
+private:
+	// the smallest order whose blocks hold `bytes`
+	static constexpr std::size_t getOrder( const std::size_t bytes ) noexcept
+	{
+		return bytes <= minBlockSize ?
+			0 :
+			floorLog2( bytes - 1 ) + 1 - m_minBlockLog2;
+	}
+
+	static constexpr std::size_t getBlockSize( const std::size_t order ) noexcept
+	{
+		return minBlockSize << order;
+	}
+
+	std::size_t getBlockCount( const std::size_t order ) const noexcept
+	{
+		return std::size_t{1} << ( m_maxOrder - order );
+	}
+
+	std::size_t getOffset( const void* p ) const noexcept
+	{
+		return static_cast<std::size_t>( static_cast<const unsigned char*>( p ) - m_pData );
+	}
+
+	FreeBlock* getBlock( const std::size_t order,
+		const std::size_t index ) const noexcept
+	{
+		return reinterpret_cast<FreeBlock*>( m_pData + ( index << ( m_minBlockLog2 + order ) ) );
+	}
+
+	bool isFree( const std::size_t order,
+		const std::size_t index ) const noexcept
+	{
+		const std::size_t bit = m_orderBitOffsets[order] + index;
+		return ( m_freeBits[bit / 64] >> ( bit % 64 ) ) & 1;
+	}
+
+	void toggleFree( const std::size_t order,
+		const std::size_t index ) noexcept
+	{
+		const std::size_t bit = m_orderBitOffsets[order] + index;
+		m_freeBits[bit / 64] ^= std::uint64_t{1} << ( bit % 64 );
+	}
+
+	void pushFree( FreeBlock* pBlock,
+		const std::size_t order ) noexcept
+	{
+		FreeBlock* pHead = m_freeLists[order];
+		pBlock->pNext = pHead;
+		pBlock->pPrev = nullptr;
+		if ( pHead != nullptr )
+		{
+			pHead->pPrev = pBlock;
+		}
+		m_freeLists[order] = pBlock;
+		m_nonEmptyOrders |= std::uint64_t{1} << order;
+		toggleFree( order,
+			getOffset( pBlock ) >> ( m_minBlockLog2 + order ) );
+	}
+
+	void removeFree( FreeBlock* pBlock,
+		const std::size_t order ) noexcept
+	{
+		if ( pBlock->pPrev != nullptr )
+		{
+			pBlock->pPrev->pNext = pBlock->pNext;
+		}
+		else
+		{
+			m_freeLists[order] = pBlock->pNext;
+			if ( pBlock->pNext == nullptr )
+			{
+				m_nonEmptyOrders &= ~( std::uint64_t{1} << order );
+			}
+		}
+		if ( pBlock->pNext != nullptr )
+		{
+			pBlock->pNext->pPrev = pBlock->pPrev;
+		}
+		toggleFree( order,
+			getOffset( pBlock ) >> ( m_minBlockLog2 + order ) );
+	}
+};
+
+
+//----------------------------------------------------------------------------------------
+// BuddyAllocator
+//
+// \brief	std allocator over a `BuddyHeap`, which it doesn't own
+//			unlike the arena allocators every deallocation gives the memory back, in any order
+//			as with `LinearAllocator`, a container keeps the heap it was constructed with
+//----------------------------------------------------------------------------------------
+template<typename T, std::size_t minBlockSize = 64>
+class BuddyAllocator
+{
+	using THeap = BuddyHeap<minBlockSize>;
+
+	THeap* m_pHeap;
+public:
+	using value_type = T;
+	using pointer = T*;
+
+	using propagate_on_container_copy_assignment = std::false_type;
+	using propagate_on_container_move_assignment = std::false_type;
+	using propagate_on_container_swap = std::false_type;
+	using is_always_equal = std::false_type;
+
+	explicit BuddyAllocator( THeap* pHeap ) noexcept
+		:
+		m_pHeap{pHeap}
+	{
+		static_assert( alignof( T ) <= minBlockSize,
+			"T is over-aligned for this BuddyHeap." );
+	}
+
+	BuddyAllocator( const BuddyAllocator& rhs ) noexcept
+		:
+		m_pHeap{rhs.getHeap()}
+	{
+
+	}
+
+	template<typename Other>
+	BuddyAllocator( const BuddyAllocator<Other, minBlockSize>& rhs ) noexcept
+		:
+		m_pHeap{rhs.getHeap()}
+	{
+
+	}
+
+	template<typename Other>
+	struct rebind
+	{
+		using other = BuddyAllocator<Other, minBlockSize>;
+	};
+
+	[[nodiscard]]
+	T* allocate( std::size_t count )
+	{
+		return static_cast<T*>( m_pHeap->allocate( count * sizeof( T ) ) );
+	}
+
+	void deallocate( T* p,
+		std::size_t count ) noexcept
+	{
+		m_pHeap->deallocate( p,
+			count * sizeof( T ) );
+	}
+
+	THeap* getHeap() const noexcept
+	{
+		return m_pHeap;
+	}
+
+	AllocatorStats getStats() const noexcept
+	{
+		return m_pHeap->getStats();
+	}
+};
+
+template<typename T, typename Other, std::size_t minBlockSize>
+inline bool operator==( const BuddyAllocator<T, minBlockSize>& lhs,
+	const BuddyAllocator<Other, minBlockSize>& rhs ) noexcept
+{
+	return lhs.getHeap() == rhs.getHeap();
+}
+
+template<typename T, typename Other, std::size_t minBlockSize>
+inline bool operator!=( const BuddyAllocator<T, minBlockSize>& lhs,
+	const BuddyAllocator<Other, minBlockSize>& rhs ) noexcept
+{
+	return lhs.getHeap() != rhs.getHeap();
+}
@@ -0,0 +1,460 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "../allocator_utils.h"
+#include "../assertions.h"
+
+
+//======================================================================
+// \class	ChunkedVector
+//
+// \brief	an append-only sequence that never moves its elements
+//			storage is a series of chunks, each twice the size of the previous one, the first
+//				holding `t_firstChunkCapacity` elements; growing allocates the next chunk and
+//				leaves the existing ones alone, so nothing is ever copied or reallocated and
+//				element addresses stay valid until `clear()`
+//			an arena backed std::vector abandons every outgrown buffer inside the arena; this
+//				uses exactly the memory of its chunks and at most half of it is unused
+//			indexing is O(1): the chunk of an index is the position of its highest set bit
+//			the chunk table lives in the object, so the chunks are the only allocations; they
+//				are released last to first, which suits `StackAllocator`'s LIFO order
+//======================================================================
+template<typename T, std::size_t t_firstChunkCapacity = 16, typename TAlloc = std::allocator<T>>
+class ChunkedVector
+{
+	static_assert( isPowerOfTwo( t_firstChunkCapacity ),
+		"ChunkedVector's first chunk capacity must be a power of 2." );
+
+	using TAllocTraits = std::allocator_traits<TAlloc>;
+
+	static constexpr std::size_t m_log2FirstChunk = floorLog2( t_firstChunkCapacity );
+	// enough chunks to address every index a std::size_t can hold
+	static constexpr std::size_t m_nMaxChunks = sizeof( std::size_t ) * 8 - m_log2FirstChunk;
+
+	T* m_chunks[m_nMaxChunks];
+	std::size_t m_nChunks;
+	std::size_t m_size;
+	TAlloc m_alloc;
+
+	template<bool isConst>
+	class Iterator final
+	{
+		using TOwner = std::conditional_t<isConst, const ChunkedVector, ChunkedVector>;
+
+		friend class ChunkedVector;
+
+		TOwner* m_pOwner;
+		std::size_t m_index;
+		std::size_t m_chunk;
+		T* m_p;
+		T* m_pChunkEnd;
+
+		Iterator( TOwner* pOwner,
+			const std::size_t index ) noexcept
+			:
+			m_pOwner{pOwner},
+			m_index{index},
+			m_chunk{getChunkIndex( index )},
+			m_p{nullptr},
+			m_pChunkEnd{nullptr}
+		{
+			if ( m_chunk < pOwner->m_nChunks )
+			{
+				m_p = pOwner->m_chunks[m_chunk] + getOffsetInChunk( index, m_chunk );
+				m_pChunkEnd = pOwner->m_chunks[m_chunk] + getChunkCapacity( m_chunk );
+			}
+		}
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = T;
+		using difference_type = std::ptrdiff_t;
+		using pointer = std::conditional_t<isConst, const T*, T*>;
+		using reference = std::conditional_t<isConst, const T&, T&>;
+
+		Iterator() noexcept
+			:
+			m_pOwner{nullptr},
+			m_index{0},
+			m_chunk{0},
+			m_p{nullptr},
+			m_pChunkEnd{nullptr}
+		{
+
+		}
+
+		// iterator -> const_iterator
+		operator Iterator<true>() const noexcept
+		{
+			return Iterator<true>{m_pOwner, m_index};
+		}
+
+		reference operator*() const noexcept
+		{
+			return *m_p;
+		}
+
+		pointer operator->() const noexcept
+		{
+			return m_p;
+		}
+
+		// walks the current chunk with a pointer; the chunk table is only read at chunk boundaries
+		Iterator& operator++() noexcept
+		{
+			++m_index;
+			if ( ++m_p == m_pChunkEnd )
+			{
+				++m_chunk;
+				if ( m_chunk < m_pOwner->m_nChunks )
+				{
+					m_p = m_pOwner->m_chunks[m_chunk];
+					m_pChunkEnd = m_p + getChunkCapacity( m_chunk );
+				}
+			}
+			return *this;
+		}
+
+		Iterator operator++( int ) noexcept
+		{
+			Iterator old = *this;
+			++( *this );
+			return old;
+		}
+
+		bool operator==( const Iterator& rhs ) const noexcept
+		{
+			return m_index == rhs.m_index;
+		}
+
+		bool operator!=( const Iterator& rhs ) const noexcept
+		{
+			return m_index != rhs.m_index;
+		}
+	};
+public:
+	using value_type = T;
+	using allocator_type = TAlloc;
+	using size_type = std::size_t;
+	using difference_type = std::ptrdiff_t;
+	using reference = T&;
+	using const_reference = const T&;
+	using iterator = Iterator<false>;
+	using const_iterator = Iterator<true>;
+
+	ChunkedVector() noexcept( std::is_nothrow_default_constructible_v<TAlloc> )
+		:
+		m_chunks{},
+		m_nChunks{0},
+		m_size{0},
+		m_alloc{}
+	{
+
+	}
+
+	explicit ChunkedVector( const TAlloc& alloc ) noexcept
+		:
+		m_chunks{},
+		m_nChunks{0},
+		m_size{0},
+		m_alloc(alloc)
+	{
+
+	}
+
+	ChunkedVector( const ChunkedVector& rhs )
+		:
+		ChunkedVector(TAllocTraits::select_on_container_copy_construction( rhs.m_alloc ))
+	{
+		reserve( rhs.m_size );
+		for ( const T& value : rhs )
+		{
+			emplace_back( value );
+		}
+	}
+
+	// allocator-extended copy, as used by std::scoped_allocator_adaptor for nested containers
+	ChunkedVector( const ChunkedVector& rhs,
+		const TAlloc& alloc )
+		:
+		ChunkedVector(alloc)
+	{
+		reserve( rhs.m_size );
+		for ( const T& value : rhs )
+		{
+			emplace_back( value );
+		}
+	}
+
+	// the chunks change hands; elements stay where they are
+	ChunkedVector( ChunkedVector&& rhs ) noexcept
+		:
+		m_chunks{},
+		m_nChunks{0},
+		m_size{0},
+		m_alloc(rhs.m_alloc)
+	{
+		stealChunks( rhs );
+	}
+
+	ChunkedVector( ChunkedVector&& rhs,
+		const TAlloc& alloc )
+		:
+		ChunkedVector(alloc)
+	{
+		moveFrom( rhs );
+	}
+
+	~ChunkedVector() noexcept
+	{
+		clear();
+		releaseChunks();
+	}
+
+	ChunkedVector& operator=( const ChunkedVector& rhs )
+	{
+		if ( this != &rhs )
+		{
+			clear();
+			if constexpr ( TAllocTraits::propagate_on_container_copy_assignment::value )
+			{
+				if ( m_alloc != rhs.m_alloc )
+				{
+					releaseChunks();
+				}
+				m_alloc = rhs.m_alloc;
+			}
+			reserve( rhs.m_size );
+			for ( const T& value : rhs )
+			{
+				emplace_back( value );
+			}
+		}
+		return *this;
+	}
+
+	// without propagation the elements are moved one by one unless both allocators are equal
+	ChunkedVector& operator=( ChunkedVector&& rhs ) noexcept( TAllocTraits::propagate_on_container_move_assignment::value
+		|| TAllocTraits::is_always_equal::value )
+	{
+		if ( this != &rhs )
+		{
+			clear();
+			if constexpr ( TAllocTraits::propagate_on_container_move_assignment::value )
+			{
+				releaseChunks();
+				m_alloc = rhs.m_alloc;
+			}
+			moveFrom( rhs );
+		}
+		return *this;
+	}
+
+	template<typename... TArgs>
+	T& emplace_back( TArgs&&... args )
+	{
+		const std::size_t chunk = getChunkIndex( m_size );
+		if ( chunk == m_nChunks )
+		{
+			allocateChunk();
+		}
+		T* p = m_chunks[chunk] + getOffsetInChunk( m_size, chunk );
+		TAllocTraits::construct( m_alloc,
+			p,
+			std::forward<TArgs>( args )... );
+		++m_size;
+		return *p;
+	}
+
+	void push_back( const T& value )
+	{
+		emplace_back( value );
+	}
+
+	void push_back( T&& value )
+	{
+		emplace_back( std::move( value ) );
+	}
+
+	// allocates the chunks for `count` elements up front
+	void reserve( const std::size_t count )
+	{
+		if ( count == 0 )
+		{
+			return;
+		}
+		const std::size_t lastChunk = getChunkIndex( count - 1 );
+		while ( m_nChunks <= lastChunk )
+		{
+			allocateChunk();
+		}
+	}
+
+	// destroys the elements, keeps the chunks
+	void clear() noexcept
+	{
+		if constexpr ( !std::is_trivially_destructible_v<T> )
+		{
+			for ( T& value : *this )
+			{
+				value.~T();
+			}
+		}
+		m_size = 0;
+	}
+
+	T& operator[]( const std::size_t index ) noexcept
+	{
+		ASSERT( index < m_size,
+			"ChunkedVector index out of range!" );
+		const std::size_t chunk = getChunkIndex( index );
+		return m_chunks[chunk][getOffsetInChunk( index, chunk )];
+	}
+
+	const T& operator[]( const std::size_t index ) const noexcept
+	{
+		ASSERT( index < m_size,
+			"ChunkedVector index out of range!" );
+		const std::size_t chunk = getChunkIndex( index );
+		return m_chunks[chunk][getOffsetInChunk( index, chunk )];
+	}
+
+	T& front() noexcept
+	{
+		return ( *this )[0];
+	}
+
+	const T& front() const noexcept
+	{
+		return ( *this )[0];
+	}
+
+	T& back() noexcept
+	{
+		return ( *this )[m_size - 1];
+	}
+
+	const T& back() const noexcept
+	{
+		return ( *this )[m_size - 1];
+	}
+
+	iterator begin() noexcept
+	{
+		return iterator{this, 0};
+	}
+
+	iterator end() noexcept
+	{
+		return iterator{this, m_size};
+	}
+
+	const_iterator begin() const noexcept
+	{
+		return const_iterator{this, 0};
+	}
+
+	const_iterator end() const noexcept
+	{
+		return const_iterator{this, m_size};
+	}
+
+	bool empty() const noexcept
+	{
+		return m_size == 0;
+	}
+
+	std::size_t size() const noexcept
+	{
+		return m_size;
+	}
+
+	// elements the allocated chunks hold
+	std::size_t capacity() const noexcept
+	{
+		return ( t_firstChunkCapacity << m_nChunks ) - t_firstChunkCapacity;
+	}
+
+	std::size_t getChunkCount() const noexcept
+	{
+		return m_nChunks;
+	}
+
+	TAlloc get_allocator() const noexcept
+	{
+		return m_alloc;
+	}
+
+	static constexpr std::size_t getChunkCapacity( const std::size_t chunk ) noexcept
+	{
+		return t_firstChunkCapacity << chunk;
+	}
+private:
+	// chunk c holds the indices [first * ( 2^c - 1 ), first * ( 2^( c + 1 ) - 1 ) )
+	static constexpr std::size_t getChunkIndex( const std::size_t index ) noexcept
+	{
+		return floorLog2( index + t_firstChunkCapacity ) - m_log2FirstChunk;
+	}
+
+	static constexpr std::size_t getOffsetInChunk( const std::size_t index,
+		const std::size_t chunk ) noexcept
+	{
+		return index + t_firstChunkCapacity - getChunkCapacity( chunk );
+	}
+
+	void allocateChunk()
+	{
+		ASSERT( m_nChunks < m_nMaxChunks,
+			"ChunkedVector out of chunks!" );
+		m_chunks[m_nChunks] = TAllocTraits::allocate( m_alloc,
+			getChunkCapacity( m_nChunks ) );
+		++m_nChunks;
+	}
+
+	// `this` is empty
+	void moveFrom( ChunkedVector& rhs )
+	{
+		if ( m_alloc == rhs.m_alloc )
+		{
+			releaseChunks();
+			stealChunks( rhs );
+			return;
+		}
+		reserve( rhs.m_size );
+		for ( T& value : rhs )
+		{
+			emplace_back( std::move( value ) );
+		}
+		rhs.clear();
+	}
+
+	// `this` has no chunks
+	void stealChunks( ChunkedVector& rhs ) noexcept
+	{
+		for ( std::size_t c = 0; c < m_nMaxChunks; ++c )
+		{
+			m_chunks[c] = rhs.m_chunks[c];
+			rhs.m_chunks[c] = nullptr;
+		}
+		m_nChunks = rhs.m_nChunks;
+		m_size = rhs.m_size;
+		rhs.m_nChunks = 0;
+		rhs.m_size = 0;
+	}
+
+	void releaseChunks() noexcept
+	{
+		while ( m_nChunks > 0 )
+		{
+			--m_nChunks;
+			TAllocTraits::deallocate( m_alloc,
+				m_chunks[m_nChunks],
+				getChunkCapacity( m_nChunks ) );
+			m_chunks[m_nChunks] = nullptr;
+		}
+	}
+};
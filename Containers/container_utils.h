@@ -0,0 +1,76 @@
+#pragma once
+
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+
+// whether `TAlloc` constructs elements itself, like std::scoped_allocator_adaptor, which hands
+//	its inner allocator down to allocator-aware elements
+template<typename TAlloc, typename T, typename TArg, typename = void>
+struct HasConstruct
+	: std::false_type
+{
+
+};
+
+template<typename TAlloc, typename T, typename TArg>
+struct HasConstruct<TAlloc,
+		T,
+		TArg,
+		std::void_t<decltype( std::declval<TAlloc&>().construct( std::declval<T*>(), std::declval<TArg>() ) )>>
+	: std::true_type
+{
+
+};
+
+// std::uninitialized_copy through `std::allocator_traits<TAlloc>::construct()`
+//	elements that come from another container have to be constructed by this container's
+//	allocator, or nested containers keep the allocator of the source
+//	plain allocators take the std algorithm, which becomes a memcpy for trivial types
+template<typename TAlloc, typename TInputIt, typename T>
+T* uninitializedCopyA( TInputIt first,
+	TInputIt last,
+	T* pDest,
+	TAlloc& alloc )
+{
+	if constexpr ( !HasConstruct<TAlloc, T, decltype( *first )>::value )
+	{
+		return std::uninitialized_copy( first,
+			last,
+			pDest );
+	}
+	else
+	{
+		T* p = pDest;
+		try
+		{
+			for ( ; first != last; ++first, ++p )
+			{
+				std::allocator_traits<TAlloc>::construct( alloc,
+					p,
+					*first );
+			}
+		}
+		catch ( ... )
+		{
+			std::destroy( pDest,
+				p );
+			throw;
+		}
+		return p;
+	}
+}
+
+template<typename TAlloc, typename TInputIt, typename T>
+T* uninitializedMoveA( TInputIt first,
+	TInputIt last,
+	T* pDest,
+	TAlloc& alloc )
+{
+	return uninitializedCopyA( std::make_move_iterator( first ),
+		std::make_move_iterator( last ),
+		pDest,
+		alloc );
+}
@@ -0,0 +1,186 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "../LinearAllocator/linear_allocator.h"
+#include "chunked_vector.h"
+#include "expanding_vector.h"
+#include "flat_map.h"
+#include "small_vector.h"
+#include "string_builder.h"
+#include "string_interner.h"
+
+
+struct GameObject
+{
+	int32_t x, y, z;
+	int32_t cost;
+};
+
+static void printArena( const char* name,
+	const Arena<>& arena )
+{
+	std::cout << name
+		<< ": "
+		<< arena.getOffset()
+		<< " B of "
+		<< arena.getSize()
+		<< " B used\n";
+}
+
+int main()
+{
+	std::cout << std::boolalpha << '\n';
+
+	// the std::map demo of linear_allocator.cpp, with one allocation instead of one per node
+	using Entry = std::pair<std::string, int>;
+	Arena<> mapArena{4096};
+	FlatMap<std::string, int, std::less<>, LinearAllocator<Entry>> map{std::less<>{}, LinearAllocator<Entry>{&mapArena}};
+	map.reserve( 8 );
+	map["foo"] = 10;
+	map["fooooooooooooooooooooooooooo"] = 20;
+	map["hidfsaf255555555555444444444"] = 200;
+	map["5444444444"] = 2;
+	map.try_emplace( "foo", 1000 );
+	for ( const auto& [key, value] : map )
+	{
+		std::cout << key
+			<< ' '
+			<< value
+			<< '\n';
+	}
+	std::cout << "find(\"foo\")->second="
+		<< map.find( "foo" )->second
+		<< " contains(\"bar\")="
+		<< map.contains( "bar" )
+		<< '\n';
+	map.erase( map.find( "5444444444" ) );
+	map.erase( map.begin() );
+	std::cout << "after erasing through iterators: size()="
+		<< map.size()
+		<< " begin()->first="
+		<< map.begin()->first
+		<< '\n';
+	printArena( "flat map arena",
+		mapArena );
+
+	const int primes[] = {13, 2, 7, 3, 5, 11, 7, 2};
+	Arena<> setArena{1024};
+	FlatSet<int, std::less<int>, LinearAllocator<int>> set{std::begin( primes ),
+		std::end( primes ),
+		LinearAllocator<int>{&setArena}};
+	for ( const int p : set )
+	{
+		std::cout << p
+			<< ' ';
+	}
+	std::cout << '\n';
+
+	// stays inside the object until the 5th element
+	Arena<> smallArena{1024};
+	SmallVector<GameObject, 4, LinearAllocator<GameObject>> objects{LinearAllocator<GameObject>{&smallArena}};
+	for ( int32_t i = 0; i < 6; ++i )
+	{
+		objects.push_back( GameObject{i, i + 1, i + 2, i + 3} );
+		std::cout << "size="
+			<< objects.size()
+			<< " inline="
+			<< objects.isInline()
+			<< '\n';
+	}
+	printArena( "small vector arena",
+		smallArena );
+
+	// elements never move, so the address taken first stays valid
+	Arena<> chunkArena{16384};
+	ChunkedVector<GameObject, 16, LinearAllocator<GameObject>> log{LinearAllocator<GameObject>{&chunkArena}};
+	const GameObject& first = log.emplace_back( GameObject{-1, -1, -1, -1} );
+	for ( int32_t i = 0; i < 500; ++i )
+	{
+		log.push_back( GameObject{i, i, i, i} );
+	}
+	std::cout << "first.cost="
+		<< first.cost
+		<< " log[500].cost="
+		<< log[500].cost
+		<< " chunks="
+		<< log.getChunkCount()
+		<< '\n';
+	printArena( "chunked vector arena",
+		chunkArena );
+
+	// grows in place while it's the arena's latest allocation
+	Arena<> growArena{16384};
+	ExpandingVector<int, LinearAllocator<int>> ints{LinearAllocator<int>{&growArena}};
+	for ( int i = 0; i < 1000; ++i )
+	{
+		ints.push_back( i );
+	}
+	ints.shrink_to_fit();
+	ExpandingString<LinearAllocator<char>> path{"/usr", LinearAllocator<char>{&growArena}};
+	path += "/local";
+	path += "/share";
+	std::cout << "ints.size()="
+		<< ints.size()
+		<< " path="
+		<< path.c_str()
+		<< '\n';
+	printArena( "expanding vector arena",
+		growArena );
+
+	// appending a container to itself; the source is copied before the old buffer is released
+	ExpandingString<> echo{"ab", std::allocator<char>{}};
+	for ( int i = 0; i < 4; ++i )
+	{
+		echo += echo;
+	}
+	ExpandingVector<int> twice;
+	twice.append( ints.begin(),
+		ints.begin() + 3 );
+	twice.shrink_to_fit();
+	twice.append( twice.begin(),
+		twice.end() );
+	std::cout << "echo.size()="
+		<< echo.size()
+		<< " twice.size()="
+		<< twice.size()
+		<< " twice.back()="
+		<< twice.back()
+		<< '\n';
+
+	// every distinct identifier is stored once; equal ones share the same bytes and id
+	Arena<1> symbolArena{4096};
+	StringInterner<Arena<1>> symbols{&symbolArena};
+	const char* tokens[] = {"x", "y", "foo", "x", "bar", "foo", "x"};
+	for ( const char* token : tokens )
+	{
+		std::cout << token
+			<< "->"
+			<< symbols.getId( token )
+			<< ' ';
+	}
+	std::cout << "\ndistinct="
+		<< symbols.size()
+		<< " stored bytes="
+		<< symbols.getStoredBytes()
+		<< " same view="
+		<< ( symbols.intern( "foo" ).data() == symbols.intern( std::string{"foo"} ).data() )
+		<< '\n';
+
+	StringBuilder<Arena<1>> builder{&symbolArena};
+	for ( int i = 0; i < 3; ++i )
+	{
+		builder.append( "item" )
+			.appendNumber( i )
+			.append( ';' );
+	}
+	const std::string_view built = builder.finish();
+	std::cout << built
+		<< " interned id="
+		<< symbols.getId( built )
+		<< " arena offset="
+		<< symbolArena.getOffset()
+		<< '\n';
+
+	std::system( "pause" );
+	return EXIT_SUCCESS;
+}
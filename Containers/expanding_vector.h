@@ -0,0 +1,755 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include "../assertions.h"
+#include "container_utils.h"
+
+
+// whether `TAlloc` can resize an allocation in place, like `LinearAllocator` and `StackAllocator`
+template<typename TAlloc, typename T, typename = void>
+struct HasTryExpand
+	: std::false_type
+{
+
+};
+
+template<typename TAlloc, typename T>
+struct HasTryExpand<TAlloc,
+		T,
+		std::void_t<decltype( std::declval<TAlloc&>().tryExpand( std::declval<T*>(), std::size_t{}, std::size_t{} ) )>>
+	: std::true_type
+{
+
+};
+
+//======================================================================
+// \class	ExpandingVector
+//
+// \brief	a vector that grows in place when its allocator can
+//			a std::vector on a `LinearAllocator` allocates a new buffer on every growth and
+//				abandons the old one in the arena, which never frees: appending n elements
+//				costs up to ~2n elements of arena; this asks the allocator to `tryExpand()`
+//				first, which succeeds as long as the buffer is the arena's latest allocation,
+//				so the elements are neither moved nor is anything left behind
+//			falls back to allocate, move and deallocate like std::vector otherwise, so it
+//				works with any allocator
+//			`shrink_to_fit()` hands the unused capacity back to the arena the same way
+//======================================================================
+template<typename T, typename TAlloc = std::allocator<T>>
+class ExpandingVector
+{
+	using TAllocTraits = std::allocator_traits<TAlloc>;
+
+	T* m_pData;
+	std::size_t m_size;
+	std::size_t m_capacity;
+	TAlloc m_alloc;
+public:
+	using value_type = T;
+	using allocator_type = TAlloc;
+	using size_type = std::size_t;
+	using difference_type = std::ptrdiff_t;
+	using reference = T&;
+	using const_reference = const T&;
+	using pointer = T*;
+	using const_pointer = const T*;
+	using iterator = T*;
+	using const_iterator = const T*;
+
+	ExpandingVector() noexcept( std::is_nothrow_default_constructible_v<TAlloc> )
+		:
+		m_pData{nullptr},
+		m_size{0},
+		m_capacity{0},
+		m_alloc{}
+	{
+
+	}
+
+	explicit ExpandingVector( const TAlloc& alloc ) noexcept
+		:
+		m_pData{nullptr},
+		m_size{0},
+		m_capacity{0},
+		m_alloc(alloc)
+	{
+
+	}
+
+	ExpandingVector( const ExpandingVector& rhs )
+		:
+		ExpandingVector(TAllocTraits::select_on_container_copy_construction( rhs.m_alloc ))
+	{
+		reserve( rhs.m_size );
+		uninitializedCopyA( rhs.begin(),
+			rhs.end(),
+			m_pData,
+			m_alloc );
+		m_size = rhs.m_size;
+	}
+
+	// allocator-extended copy, as used by std::scoped_allocator_adaptor for nested containers
+	ExpandingVector( const ExpandingVector& rhs,
+		const TAlloc& alloc )
+		:
+		ExpandingVector(alloc)
+	{
+		reserve( rhs.m_size );
+		uninitializedCopyA( rhs.begin(),
+			rhs.end(),
+			m_pData,
+			m_alloc );
+		m_size = rhs.m_size;
+	}
+
+	ExpandingVector( ExpandingVector&& rhs ) noexcept
+		:
+		m_pData{rhs.m_pData},
+		m_size{rhs.m_size},
+		m_capacity{rhs.m_capacity},
+		m_alloc(rhs.m_alloc)
+	{
+		rhs.m_pData = nullptr;
+		rhs.m_size = 0;
+		rhs.m_capacity = 0;
+	}
+
+	// takes over the buffer if `alloc` can free it, else moves the elements into a new one
+	ExpandingVector( ExpandingVector&& rhs,
+		const TAlloc& alloc )
+		:
+		ExpandingVector(alloc)
+	{
+		moveFrom( rhs );
+	}
+
+	~ExpandingVector() noexcept
+	{
+		clear();
+		releaseBuffer();
+	}
+
+	ExpandingVector& operator=( const ExpandingVector& rhs )
+	{
+		if ( this != &rhs )
+		{
+			clear();
+			if constexpr ( TAllocTraits::propagate_on_container_copy_assignment::value )
+			{
+				if ( m_alloc != rhs.m_alloc )
+				{
+					releaseBuffer();
+				}
+				m_alloc = rhs.m_alloc;
+			}
+			reserve( rhs.m_size );
+			uninitializedCopyA( rhs.begin(),
+				rhs.end(),
+				m_pData,
+				m_alloc );
+			m_size = rhs.m_size;
+		}
+		return *this;
+	}
+
+	// without propagation the elements are moved into this vector's own allocation unless
+	//	both allocators are equal, so an arena backed vector never ends up on another arena
+	ExpandingVector& operator=( ExpandingVector&& rhs ) noexcept( TAllocTraits::propagate_on_container_move_assignment::value
+		|| TAllocTraits::is_always_equal::value )
+	{
+		if ( this != &rhs )
+		{
+			clear();
+			if constexpr ( TAllocTraits::propagate_on_container_move_assignment::value )
+			{
+				releaseBuffer();
+				m_alloc = rhs.m_alloc;
+			}
+			moveFrom( rhs );
+		}
+		return *this;
+	}
+
+	template<typename... TArgs>
+	T& emplace_back( TArgs&&... args )
+	{
+		if ( m_size == m_capacity )
+		{
+			return growAndEmplaceBack( std::forward<TArgs>( args )... );
+		}
+		T* p = m_pData + m_size;
+		TAllocTraits::construct( m_alloc,
+			p,
+			std::forward<TArgs>( args )... );
+		++m_size;
+		return *p;
+	}
+
+	void push_back( const T& value )
+	{
+		emplace_back( value );
+	}
+
+	void push_back( T&& value )
+	{
+		emplace_back( std::move( value ) );
+	}
+
+	template<typename TInputIt>
+	void append( TInputIt first,
+		TInputIt last )
+	{
+		if constexpr ( std::is_base_of_v<std::forward_iterator_tag,
+			typename std::iterator_traits<TInputIt>::iterator_category> )
+		{
+			const std::size_t count = static_cast<std::size_t>( std::distance( first, last ) );
+			if ( m_size + count > m_capacity )
+			{
+				growAndAppend( first,
+					last,
+					count );
+				return;
+			}
+			uninitializedCopyA( first,
+				last,
+				m_pData + m_size,
+				m_alloc );
+			m_size += count;
+		}
+		else
+		{
+			for ( ; first != last; ++first )
+			{
+				emplace_back( *first );
+			}
+		}
+	}
+
+	void pop_back() noexcept
+	{
+		ASSERT( m_size > 0,
+			"pop_back() on an empty ExpandingVector!" );
+		--m_size;
+		m_pData[m_size].~T();
+	}
+
+	void resize( const std::size_t count )
+	{
+		reserve( count );
+		while ( m_size < count )
+		{
+			emplace_back();
+		}
+		while ( m_size > count )
+		{
+			pop_back();
+		}
+	}
+
+	// reserves exactly `count` elements
+	void reserve( const std::size_t count )
+	{
+		if ( count > m_capacity )
+		{
+			resizeBuffer( count );
+		}
+	}
+
+	// gives the capacity beyond `size()` back, in place if the allocator can
+	void shrink_to_fit()
+	{
+		if ( m_capacity == m_size )
+		{
+			return;
+		}
+		if constexpr ( HasTryExpand<TAlloc, T>::value )
+		{
+			if ( m_pData != nullptr && m_alloc.tryExpand( m_pData, m_capacity, m_size ) )
+			{
+				m_capacity = m_size;
+				return;
+			}
+		}
+		if ( m_size == 0 )
+		{
+			releaseBuffer();
+			return;
+		}
+		relocate( m_size );
+	}
+
+	// destroys the elements, keeps the capacity
+	void clear() noexcept
+	{
+		std::destroy( m_pData,
+			m_pData + m_size );
+		m_size = 0;
+	}
+
+	T& operator[]( const std::size_t index ) noexcept
+	{
+		ASSERT( index < m_size,
+			"ExpandingVector index out of range!" );
+		return m_pData[index];
+	}
+
+	const T& operator[]( const std::size_t index ) const noexcept
+	{
+		ASSERT( index < m_size,
+			"ExpandingVector index out of range!" );
+		return m_pData[index];
+	}
+
+	T& front() noexcept
+	{
+		return ( *this )[0];
+	}
+
+	const T& front() const noexcept
+	{
+		return ( *this )[0];
+	}
+
+	T& back() noexcept
+	{
+		return ( *this )[m_size - 1];
+	}
+
+	const T& back() const noexcept
+	{
+		return ( *this )[m_size - 1];
+	}
+
+	T* data() noexcept
+	{
+		return m_pData;
+	}
+
+	const T* data() const noexcept
+	{
+		return m_pData;
+	}
+
+	T* begin() noexcept
+	{
+		return m_pData;
+	}
+
+	T* end() noexcept
+	{
+		return m_pData + m_size;
+	}
+
+	const T* begin() const noexcept
+	{
+		return m_pData;
+	}
+
+	const T* end() const noexcept
+	{
+		return m_pData + m_size;
+	}
+
+	bool empty() const noexcept
+	{
+		return m_size == 0;
+	}
+
+	std::size_t size() const noexcept
+	{
+		return m_size;
+	}
+
+	std::size_t capacity() const noexcept
+	{
+		return m_capacity;
+	}
+
+	TAlloc get_allocator() const noexcept
+	{
+		return m_alloc;
+	}
+private:
+	// `this` is empty
+	void moveFrom( ExpandingVector& rhs )
+	{
+		if ( m_alloc == rhs.m_alloc )
+		{
+			releaseBuffer();
+			m_pData = rhs.m_pData;
+			m_size = rhs.m_size;
+			m_capacity = rhs.m_capacity;
+			rhs.m_pData = nullptr;
+			rhs.m_size = 0;
+			rhs.m_capacity = 0;
+			return;
+		}
+		reserve( rhs.m_size );
+		uninitializedMoveA( rhs.begin(),
+			rhs.end(),
+			m_pData,
+			m_alloc );
+		m_size = rhs.m_size;
+		rhs.clear();
+	}
+
+	void grow( const std::size_t minCapacity )
+	{
+		resizeBuffer( std::max( m_capacity * 2,
+			minCapacity ) );
+	}
+
+	// `args` may refer to an element, so on relocation the new element is constructed before
+	//	the old ones are moved
+	template<typename... TArgs>
+	T& growAndEmplaceBack( TArgs&&... args )
+	{
+		const std::size_t capacity = std::max( m_capacity * 2,
+			m_size + 1 );
+		if constexpr ( HasTryExpand<TAlloc, T>::value )
+		{
+			if ( m_pData != nullptr && m_alloc.tryExpand( m_pData, m_capacity, capacity ) )
+			{
+				m_capacity = capacity;
+				T* p = m_pData + m_size;
+				TAllocTraits::construct( m_alloc,
+					p,
+					std::forward<TArgs>( args )... );
+				++m_size;
+				return *p;
+			}
+		}
+		T* pNew = TAllocTraits::allocate( m_alloc,
+			capacity );
+		T* p = pNew + m_size;
+		try
+		{
+			TAllocTraits::construct( m_alloc,
+				p,
+				std::forward<TArgs>( args )... );
+		}
+		catch ( ... )
+		{
+			TAllocTraits::deallocate( m_alloc,
+				pNew,
+				capacity );
+			throw;
+		}
+		std::uninitialized_move( m_pData,
+			m_pData + m_size,
+			pNew );
+		std::destroy( m_pData,
+			m_pData + m_size );
+		releaseBuffer();
+		m_pData = pNew;
+		m_capacity = capacity;
+		++m_size;
+		return *p;
+	}
+
+	// the range may lie in this vector, so on relocation it is copied before the old elements
+	//	are moved, as in `growAndEmplaceBack()`
+	template<typename TForwardIt>
+	void growAndAppend( TForwardIt first,
+		TForwardIt last,
+		const std::size_t count )
+	{
+		const std::size_t capacity = std::max( m_capacity * 2,
+			m_size + count );
+		if constexpr ( HasTryExpand<TAlloc, T>::value )
+		{
+			if ( m_pData != nullptr && m_alloc.tryExpand( m_pData, m_capacity, capacity ) )
+			{
+				m_capacity = capacity;
+				uninitializedCopyA( first,
+					last,
+					m_pData + m_size,
+					m_alloc );
+				m_size += count;
+				return;
+			}
+		}
+		T* pNew = TAllocTraits::allocate( m_alloc,
+			capacity );
+		try
+		{
+			uninitializedCopyA( first,
+				last,
+				pNew + m_size,
+				m_alloc );
+		}
+		catch ( ... )
+		{
+			TAllocTraits::deallocate( m_alloc,
+				pNew,
+				capacity );
+			throw;
+		}
+		std::uninitialized_move( m_pData,
+			m_pData + m_size,
+			pNew );
+		std::destroy( m_pData,
+			m_pData + m_size );
+		releaseBuffer();
+		m_pData = pNew;
+		m_capacity = capacity;
+		m_size += count;
+	}
+
+	void resizeBuffer( const std::size_t capacity )
+	{
+		if constexpr ( HasTryExpand<TAlloc, T>::value )
+		{
+			if ( m_pData != nullptr && m_alloc.tryExpand( m_pData, m_capacity, capacity ) )
+			{
+				m_capacity = capacity;
+				return;
+			}
+		}
+		relocate( capacity );
+	}
+
+	void relocate( const std::size_t capacity )
+	{
+		T* pNew = TAllocTraits::allocate( m_alloc,
+			capacity );
+		std::uninitialized_move( m_pData,
+			m_pData + m_size,
+			pNew );
+		std::destroy( m_pData,
+			m_pData + m_size );
+		releaseBuffer();
+		m_pData = pNew;
+		m_capacity = capacity;
+	}
+
+	void releaseBuffer() noexcept
+	{
+		if ( m_pData != nullptr )
+		{
+			TAllocTraits::deallocate( m_alloc,
+				m_pData,
+				m_capacity );
+		}
+		m_pData = nullptr;
+		m_capacity = 0;
+	}
+};
+
+
+//======================================================================
+// \class	BasicExpandingString
+//
+// \brief	an append oriented string over an `ExpandingVector`, so a string built up piece by
+//				piece in an arena grows in place instead of leaving a trail of copies behind
+//			always null terminated; `view()` and the conversion to std::basic_string_view give
+//				access to the std string algorithms
+//======================================================================
+template<typename TChar, typename TAlloc = std::allocator<TChar>>
+class BasicExpandingString
+{
+	// the characters followed by the terminating null, or nothing at all while empty
+	ExpandingVector<TChar, TAlloc> m_chars;
+public:
+	using value_type = TChar;
+	using allocator_type = TAlloc;
+	using size_type = std::size_t;
+	using TView = std::basic_string_view<TChar>;
+
+	BasicExpandingString() = default;
+
+	explicit BasicExpandingString( const TAlloc& alloc ) noexcept
+		:
+		m_chars(alloc)
+	{
+
+	}
+
+	BasicExpandingString( const BasicExpandingString& rhs,
+		const TAlloc& alloc )
+		:
+		m_chars(rhs.m_chars, alloc)
+	{
+
+	}
+
+	BasicExpandingString( BasicExpandingString&& rhs,
+		const TAlloc& alloc )
+		:
+		m_chars(std::move( rhs.m_chars ), alloc)
+	{
+
+	}
+
+	BasicExpandingString( const TView str,
+		const TAlloc& alloc )
+		:
+		m_chars(alloc)
+	{
+		append( str );
+	}
+
+	BasicExpandingString& append( const TView str )
+	{
+		if ( str.empty() )
+		{
+			return *this;
+		}
+		const std::size_t length = size();
+		// `str` may be a view of this string, eg. `s += s`; the reserve can move the characters
+		const bool bAliased = !m_chars.empty()
+			&& std::less_equal<const TChar*>{}( m_chars.data(), str.data() )
+			&& std::less<const TChar*>{}( str.data(), m_chars.data() + length );
+		const std::size_t offset = bAliased ?
+			static_cast<std::size_t>( str.data() - m_chars.data() ) :
+			0;
+		reserveChars( length + str.size() + 1 );
+		const TChar* pSource = bAliased ?
+			m_chars.data() + offset :
+			str.data();
+		if ( !m_chars.empty() )
+		{
+			m_chars.pop_back();
+		}
+		m_chars.append( pSource,
+			pSource + str.size() );
+		m_chars.push_back( TChar{} );
+		return *this;
+	}
+
+	BasicExpandingString& operator+=( const TView str )
+	{
+		return append( str );
+	}
+
+	BasicExpandingString& operator+=( const TChar c )
+	{
+		push_back( c );
+		return *this;
+	}
+
+	void push_back( const TChar c )
+	{
+		if ( m_chars.empty() )
+		{
+			m_chars.push_back( c );
+		}
+		else
+		{
+			m_chars.back() = c;
+		}
+		m_chars.push_back( TChar{} );
+	}
+
+	void reserve( const std::size_t length )
+	{
+		reserveChars( length + 1 );
+	}
+
+	void clear() noexcept
+	{
+		m_chars.clear();
+	}
+
+	void shrink_to_fit()
+	{
+		m_chars.shrink_to_fit();
+	}
+
+	std::size_t size() const noexcept
+	{
+		return m_chars.empty() ?
+			0 :
+			m_chars.size() - 1;
+	}
+
+	std::size_t length() const noexcept
+	{
+		return size();
+	}
+
+	bool empty() const noexcept
+	{
+		return size() == 0;
+	}
+
+	std::size_t capacity() const noexcept
+	{
+		return m_chars.capacity() == 0 ?
+			0 :
+			m_chars.capacity() - 1;
+	}
+
+	const TChar* c_str() const noexcept
+	{
+		static constexpr TChar emptyString[1]{};
+		return m_chars.empty() ?
+			emptyString :
+			m_chars.data();
+	}
+
+	const TChar* data() const noexcept
+	{
+		return c_str();
+	}
+
+	TChar& operator[]( const std::size_t index ) noexcept
+	{
+		ASSERT( index < size(),
+			"BasicExpandingString index out of range!" );
+		return m_chars[index];
+	}
+
+	const TChar& operator[]( const std::size_t index ) const noexcept
+	{
+		ASSERT( index < size(),
+			"BasicExpandingString index out of range!" );
+		return m_chars[index];
+	}
+
+	const TChar* begin() const noexcept
+	{
+		return c_str();
+	}
+
+	const TChar* end() const noexcept
+	{
+		return c_str() + size();
+	}
+
+	TView view() const noexcept
+	{
+		return TView{c_str(), size()};
+	}
+
+	operator TView() const noexcept
+	{
+		return view();
+	}
+
+	TAlloc get_allocator() const noexcept
+	{
+		return m_chars.get_allocator();
+	}
+private:
+	// geometric growth, as `ExpandingVector::reserve()` reserves exactly
+	void reserveChars( const std::size_t count )
+	{
+		if ( count > m_chars.capacity() )
+		{
+			m_chars.reserve( std::max( m_chars.capacity() * 2,
+				count ) );
+		}
+	}
+};
+
+template<typename TAlloc = std::allocator<char>>
+using ExpandingString = BasicExpandingString<char, TAlloc>;
@@ -0,0 +1,559 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+//======================================================================
+// \class	FlatSorted
+//
+// \brief	sorted unique values in one contiguous buffer; the storage and lookup shared by
+//				`FlatMap` and `FlatSet`
+//			a lookup is a binary search over adjacent elements instead of a pointer chase
+//				through scattered nodes, and the container makes one allocation per growth
+//				instead of one per element, so it suits `LinearAllocator`'s never-freeing arena
+//			insertion shifts the elements after the insertion point: `reserve()` up front and
+//				prefer the range `insert()`, which appends, sorts and deduplicates once
+//			`TKeyOf::get( value )` extracts the key of a value
+//======================================================================
+template<typename TValue, typename TKey, typename TKeyOf, typename TCompare, typename TAlloc>
+class FlatSorted
+{
+protected:
+	using TStorage = std::vector<TValue, TAlloc>;
+
+	TStorage m_values;
+	TCompare m_compare;
+public:
+	using key_type = TKey;
+	using value_type = TValue;
+	using key_compare = TCompare;
+	using allocator_type = TAlloc;
+	using size_type = std::size_t;
+	using difference_type = std::ptrdiff_t;
+	using const_iterator = typename TStorage::const_iterator;
+
+	explicit FlatSorted( const TCompare& compare = TCompare{},
+		const TAlloc& alloc = TAlloc{} )
+		:
+		m_values(alloc),
+		m_compare(compare)
+	{
+
+	}
+
+	explicit FlatSorted( const TAlloc& alloc )
+		:
+		m_values(alloc),
+		m_compare{}
+	{
+
+	}
+
+	// allocator-extended copy and move, as used by std::scoped_allocator_adaptor for nested
+	//	containers
+	FlatSorted( const FlatSorted& rhs,
+		const TAlloc& alloc )
+		:
+		m_values(rhs.m_values, alloc),
+		m_compare(rhs.m_compare)
+	{
+
+	}
+
+	FlatSorted( FlatSorted&& rhs,
+		const TAlloc& alloc )
+		:
+		m_values(std::move( rhs.m_values ), alloc),
+		m_compare(rhs.m_compare)
+	{
+
+	}
+
+	FlatSorted( const FlatSorted& rhs ) = default;
+	FlatSorted( FlatSorted&& rhs ) = default;
+	FlatSorted& operator=( const FlatSorted& rhs ) = default;
+	FlatSorted& operator=( FlatSorted&& rhs ) = default;
+
+	const_iterator begin() const noexcept
+	{
+		return m_values.begin();
+	}
+
+	const_iterator end() const noexcept
+	{
+		return m_values.end();
+	}
+
+	const_iterator cbegin() const noexcept
+	{
+		return m_values.cbegin();
+	}
+
+	const_iterator cend() const noexcept
+	{
+		return m_values.cend();
+	}
+
+	bool empty() const noexcept
+	{
+		return m_values.empty();
+	}
+
+	std::size_t size() const noexcept
+	{
+		return m_values.size();
+	}
+
+	std::size_t capacity() const noexcept
+	{
+		return m_values.capacity();
+	}
+
+	// the only allocation the container needs for `count` elements
+	void reserve( const std::size_t count )
+	{
+		m_values.reserve( count );
+	}
+
+	void clear() noexcept
+	{
+		m_values.clear();
+	}
+
+	// the elements in ascending key order, contiguous
+	const TValue* data() const noexcept
+	{
+		return m_values.data();
+	}
+
+	TAlloc get_allocator() const noexcept
+	{
+		return m_values.get_allocator();
+	}
+
+	TCompare key_comp() const
+	{
+		return m_compare;
+	}
+
+	// `K` is `TKey`, or anything a transparent comparator (eg. std::less<>) compares with it
+	template<typename K>
+	const_iterator lower_bound( const K& key ) const
+	{
+		return m_values.begin() + lowerBoundIndex( key );
+	}
+
+	template<typename K>
+	const_iterator upper_bound( const K& key ) const
+	{
+		return m_values.begin() + upperBoundIndex( key );
+	}
+
+	template<typename K>
+	const_iterator find( const K& key ) const
+	{
+		return m_values.begin() + findIndex( key );
+	}
+
+	template<typename K>
+	bool contains( const K& key ) const
+	{
+		return findIndex( key ) != m_values.size();
+	}
+
+	template<typename K>
+	std::size_t count( const K& key ) const
+	{
+		return contains( key ) ?
+			1 :
+			0;
+	}
+
+	// not for iterators, which would otherwise pick this over `erase( const_iterator )`
+	template<typename K,
+		typename = std::enable_if_t<!std::is_convertible_v<const K&, const_iterator>>>
+	std::size_t erase( const K& key )
+	{
+		const std::size_t index = findIndex( key );
+		if ( index == m_values.size() )
+		{
+			return 0;
+		}
+		m_values.erase( m_values.begin() + index );
+		return 1;
+	}
+
+	const_iterator erase( const_iterator position )
+	{
+		return m_values.erase( position );
+	}
+
+	const_iterator erase( const_iterator first,
+		const_iterator last )
+	{
+		return m_values.erase( first,
+			last );
+	}
+protected:
+	template<typename K>
+	bool isValueLess( const TValue& value,
+		const K& key ) const
+	{
+		return m_compare( TKeyOf::get( value ),
+			key );
+	}
+
+	template<typename K>
+	bool isKeyLess( const K& key,
+		const TValue& value ) const
+	{
+		return m_compare( key,
+			TKeyOf::get( value ) );
+	}
+
+	// branch free binary search: each step is a compare and a conditional move, so the
+	//	unpredictable outcome of the compare costs no branch mispredictions
+	template<typename K>
+	std::size_t lowerBoundIndex( const K& key ) const
+	{
+		const TValue* pFirst = m_values.data();
+		std::size_t length = m_values.size();
+		if ( length == 0 )
+		{
+			return 0;
+		}
+		while ( length > 1 )
+		{
+			const std::size_t half = length / 2;
+			pFirst = isValueLess( pFirst[half - 1], key ) ?
+				pFirst + half :
+				pFirst;
+			length -= half;
+		}
+		pFirst += isValueLess( *pFirst, key );
+		return static_cast<std::size_t>( pFirst - m_values.data() );
+	}
+
+	template<typename K>
+	std::size_t upperBoundIndex( const K& key ) const
+	{
+		const auto it = std::upper_bound( m_values.begin(),
+			m_values.end(),
+			key,
+			[this] ( const K& k, const TValue& value )
+			{
+				return isKeyLess( k, value );
+			} );
+		return static_cast<std::size_t>( it - m_values.begin() );
+	}
+
+	// `size()` if not found
+	template<typename K>
+	std::size_t findIndex( const K& key ) const
+	{
+		const std::size_t index = lowerBoundIndex( key );
+		if ( index != m_values.size() && !isKeyLess( key, m_values[index] ) )
+		{
+			return index;
+		}
+		return m_values.size();
+	}
+
+	// inserts `value` unless its key is present; returns the index of the element with that key
+	template<typename V>
+	std::pair<std::size_t, bool> insertUnique( V&& value )
+	{
+		const std::size_t index = lowerBoundIndex( TKeyOf::get( value ) );
+		if ( index != m_values.size() && !isKeyLess( TKeyOf::get( value ), m_values[index] ) )
+		{
+			return {index, false};
+		}
+		m_values.insert( m_values.begin() + index,
+			std::forward<V>( value ) );
+		return {index, true};
+	}
+
+	// appends the range, then restores the order in one sort; the first of equal keys is kept
+	template<typename TInputIt>
+	void insertRange( TInputIt first,
+		TInputIt last )
+	{
+		const std::size_t oldSize = m_values.size();
+		m_values.insert( m_values.end(),
+			first,
+			last );
+		const auto isLessValue = [this] ( const TValue& lhs, const TValue& rhs )
+			{
+				return m_compare( TKeyOf::get( lhs ), TKeyOf::get( rhs ) );
+			};
+		std::stable_sort( m_values.begin() + oldSize,
+			m_values.end(),
+			isLessValue );
+		std::inplace_merge( m_values.begin(),
+			m_values.begin() + oldSize,
+			m_values.end(),
+			isLessValue );
+		const auto newEnd = std::unique( m_values.begin(),
+			m_values.end(),
+			[&isLessValue] ( const TValue& lhs, const TValue& rhs )
+			{
+				return !isLessValue( lhs, rhs ) && !isLessValue( rhs, lhs );
+			} );
+		m_values.erase( newEnd,
+			m_values.end() );
+	}
+};
+
+
+template<typename TKey>
+struct FlatSetKeyOf final
+{
+	static const TKey& get( const TKey& value ) noexcept
+	{
+		return value;
+	}
+};
+
+//======================================================================
+// \class	FlatSet
+//
+// \brief	a std::set replacement over a sorted contiguous buffer, see `FlatSorted`
+//			elements are immutable in place, as their position depends on them
+//======================================================================
+template<typename TKey,
+	typename TCompare = std::less<TKey>,
+	typename TAlloc = std::allocator<TKey>>
+class FlatSet
+	: public FlatSorted<TKey, TKey, FlatSetKeyOf<TKey>, TCompare, TAlloc>
+{
+	using TBase = FlatSorted<TKey, TKey, FlatSetKeyOf<TKey>, TCompare, TAlloc>;
+public:
+	using iterator = typename TBase::const_iterator;
+
+	using TBase::TBase;
+
+	template<typename TInputIt>
+	FlatSet( TInputIt first,
+		TInputIt last,
+		const TAlloc& alloc = TAlloc{} )
+		:
+		TBase(alloc)
+	{
+		insert( first,
+			last );
+	}
+
+	std::pair<iterator, bool> insert( const TKey& value )
+	{
+		const auto [index, bInserted] = this->insertUnique( value );
+		return {this->m_values.begin() + index, bInserted};
+	}
+
+	std::pair<iterator, bool> insert( TKey&& value )
+	{
+		const auto [index, bInserted] = this->insertUnique( std::move( value ) );
+		return {this->m_values.begin() + index, bInserted};
+	}
+
+	template<typename TInputIt>
+	void insert( TInputIt first,
+		TInputIt last )
+	{
+		this->insertRange( first,
+			last );
+	}
+
+	template<typename... TArgs>
+	std::pair<iterator, bool> emplace( TArgs&&... args )
+	{
+		return insert( TKey( std::forward<TArgs>( args )... ) );
+	}
+};
+
+
+template<typename TKey, typename T>
+struct FlatMapKeyOf final
+{
+	static const TKey& get( const std::pair<TKey, T>& value ) noexcept
+	{
+		return value.first;
+	}
+};
+
+//======================================================================
+// \class	FlatMap
+//
+// \brief	a std::map replacement over a sorted contiguous buffer, see `FlatSorted`
+//			`value_type` is `std::pair<TKey, T>`, not `std::pair<const TKey, T>`, so elements
+//				can be shifted by assignment; don't modify a key through an iterator
+//			insertion and erasure invalidate iterators and references, as for std::vector
+//======================================================================
+template<typename TKey,
+	typename T,
+	typename TCompare = std::less<TKey>,
+	typename TAlloc = std::allocator<std::pair<TKey, T>>>
+class FlatMap
+	: public FlatSorted<std::pair<TKey, T>, TKey, FlatMapKeyOf<TKey, T>, TCompare, TAlloc>
+{
+	using TBase = FlatSorted<std::pair<TKey, T>, TKey, FlatMapKeyOf<TKey, T>, TCompare, TAlloc>;
+public:
+	using mapped_type = T;
+	using iterator = typename TBase::TStorage::iterator;
+	using typename TBase::const_iterator;
+
+	using TBase::TBase;
+	using TBase::begin;
+	using TBase::end;
+	using TBase::erase;
+	using TBase::find;
+	using TBase::lower_bound;
+	using TBase::upper_bound;
+
+	template<typename TInputIt>
+	FlatMap( TInputIt first,
+		TInputIt last,
+		const TAlloc& alloc = TAlloc{} )
+		:
+		TBase(alloc)
+	{
+		insert( first,
+			last );
+	}
+
+	iterator begin() noexcept
+	{
+		return this->m_values.begin();
+	}
+
+	iterator end() noexcept
+	{
+		return this->m_values.end();
+	}
+
+	template<typename K>
+	iterator find( const K& key )
+	{
+		return this->m_values.begin() + this->findIndex( key );
+	}
+
+	template<typename K>
+	iterator lower_bound( const K& key )
+	{
+		return this->m_values.begin() + this->lowerBoundIndex( key );
+	}
+
+	template<typename K>
+	iterator upper_bound( const K& key )
+	{
+		return this->m_values.begin() + this->upperBoundIndex( key );
+	}
+
+	iterator erase( iterator position )
+	{
+		return this->m_values.erase( position );
+	}
+
+	iterator erase( iterator first,
+		iterator last )
+	{
+		return this->m_values.erase( first,
+			last );
+	}
+
+	std::pair<iterator, bool> insert( const std::pair<TKey, T>& value )
+	{
+		const auto [index, bInserted] = this->insertUnique( value );
+		return {this->m_values.begin() + index, bInserted};
+	}
+
+	std::pair<iterator, bool> insert( std::pair<TKey, T>&& value )
+	{
+		const auto [index, bInserted] = this->insertUnique( std::move( value ) );
+		return {this->m_values.begin() + index, bInserted};
+	}
+
+	template<typename TInputIt>
+	void insert( TInputIt first,
+		TInputIt last )
+	{
+		this->insertRange( first,
+			last );
+	}
+
+	template<typename... TArgs>
+	std::pair<iterator, bool> emplace( TArgs&&... args )
+	{
+		return insert( std::pair<TKey, T>( std::forward<TArgs>( args )... ) );
+	}
+
+	// constructs the mapped value only if `key` isn't present
+	template<typename K, typename... TArgs>
+	std::pair<iterator, bool> try_emplace( K&& key,
+		TArgs&&... args )
+	{
+		const std::size_t index = this->lowerBoundIndex( key );
+		if ( index != this->m_values.size() && !this->isKeyLess( key, this->m_values[index] ) )
+		{
+			return {this->m_values.begin() + index, false};
+		}
+		const auto it = this->m_values.emplace( this->m_values.begin() + index,
+			std::piecewise_construct,
+			std::forward_as_tuple( std::forward<K>( key ) ),
+			std::forward_as_tuple( std::forward<TArgs>( args )... ) );
+		return {it, true};
+	}
+
+	template<typename K, typename V>
+	std::pair<iterator, bool> insert_or_assign( K&& key,
+		V&& value )
+	{
+		auto result = try_emplace( std::forward<K>( key ),
+			std::forward<V>( value ) );
+		if ( !result.second )
+		{
+			result.first->second = std::forward<V>( value );
+		}
+		return result;
+	}
+
+	T& operator[]( const TKey& key )
+	{
+		return try_emplace( key ).first->second;
+	}
+
+	T& operator[]( TKey&& key )
+	{
+		return try_emplace( std::move( key ) ).first->second;
+	}
+
+	template<typename K>
+	T& at( const K& key )
+	{
+		const auto it = find( key );
+		if ( it == end() )
+		{
+			throw std::out_of_range{"FlatMap::at - key not found"};
+		}
+		return it->second;
+	}
+
+	template<typename K>
+	const T& at( const K& key ) const
+	{
+		const auto it = find( key );
+		if ( it == end() )
+		{
+			throw std::out_of_range{"FlatMap::at - key not found"};
+		}
+		return it->second;
+	}
+};
@@ -0,0 +1,441 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "../assertions.h"
+#include "container_utils.h"
+
+
+//======================================================================
+// \class	SmallVector
+//
+// \brief	a vector that keeps its first `t_inlineCapacity` elements inside the object itself
+//			only growing past that allocates, from `TAlloc`; the many short lived, mostly
+//				small sequences (eg. per frame or per request scratch lists) never touch the
+//				allocator at all, and those that spill do so once per doubling
+//			`clear()` keeps a spilled buffer for reuse; it is only given back on destruction
+//			unlike std::vector, moving a vector whose elements are inline moves the elements
+//				and invalidates iterators into it
+//======================================================================
+template<typename T, std::size_t t_inlineCapacity, typename TAlloc = std::allocator<T>>
+class SmallVector
+{
+	static_assert( t_inlineCapacity > 0,
+		"SmallVector needs inline room for at least one element; use std::vector otherwise." );
+
+	using TAllocTraits = std::allocator_traits<TAlloc>;
+
+	T* m_pData;
+	std::size_t m_size;
+	std::size_t m_capacity;
+	TAlloc m_alloc;
+	alignas( T ) unsigned char m_inline[t_inlineCapacity * sizeof( T )];
+public:
+	using value_type = T;
+	using allocator_type = TAlloc;
+	using size_type = std::size_t;
+	using difference_type = std::ptrdiff_t;
+	using reference = T&;
+	using const_reference = const T&;
+	using pointer = T*;
+	using const_pointer = const T*;
+	using iterator = T*;
+	using const_iterator = const T*;
+
+	SmallVector() noexcept( std::is_nothrow_default_constructible_v<TAlloc> )
+		:
+		m_pData{getInlineData()},
+		m_size{0},
+		m_capacity{t_inlineCapacity},
+		m_alloc{}
+	{
+
+	}
+
+	explicit SmallVector( const TAlloc& alloc ) noexcept
+		:
+		m_pData{getInlineData()},
+		m_size{0},
+		m_capacity{t_inlineCapacity},
+		m_alloc(alloc)
+	{
+
+	}
+
+	SmallVector( std::initializer_list<T> values,
+		const TAlloc& alloc = TAlloc{} )
+		:
+		SmallVector(alloc)
+	{
+		reserve( values.size() );
+		for ( const T& value : values )
+		{
+			emplace_back( value );
+		}
+	}
+
+	SmallVector( const SmallVector& rhs )
+		:
+		SmallVector(TAllocTraits::select_on_container_copy_construction( rhs.m_alloc ))
+	{
+		reserve( rhs.m_size );
+		for ( const T& value : rhs )
+		{
+			emplace_back( value );
+		}
+	}
+
+	// allocator-extended copy, as used by std::scoped_allocator_adaptor for nested containers
+	SmallVector( const SmallVector& rhs,
+		const TAlloc& alloc )
+		:
+		SmallVector(alloc)
+	{
+		reserve( rhs.m_size );
+		for ( const T& value : rhs )
+		{
+			emplace_back( value );
+		}
+	}
+
+	SmallVector( SmallVector&& rhs ) noexcept( std::is_nothrow_move_constructible_v<T> )
+		:
+		SmallVector(rhs.m_alloc)
+	{
+		moveFrom( rhs );
+	}
+
+	SmallVector( SmallVector&& rhs,
+		const TAlloc& alloc )
+		:
+		SmallVector(alloc)
+	{
+		moveFrom( rhs );
+	}
+
+	~SmallVector() noexcept
+	{
+		clear();
+		releaseBuffer();
+	}
+
+	SmallVector& operator=( const SmallVector& rhs )
+	{
+		if ( this != &rhs )
+		{
+			clear();
+			if constexpr ( TAllocTraits::propagate_on_container_copy_assignment::value )
+			{
+				if ( m_alloc != rhs.m_alloc )
+				{
+					releaseBuffer();
+				}
+				m_alloc = rhs.m_alloc;
+			}
+			reserve( rhs.m_size );
+			for ( const T& value : rhs )
+			{
+				emplace_back( value );
+			}
+		}
+		return *this;
+	}
+
+	// a spilled buffer is taken over when this vector's allocator can free it
+	SmallVector& operator=( SmallVector&& rhs )
+	{
+		if ( this == &rhs )
+		{
+			return *this;
+		}
+		clear();
+		if constexpr ( TAllocTraits::propagate_on_container_move_assignment::value )
+		{
+			releaseBuffer();
+			m_alloc = rhs.m_alloc;
+		}
+		moveFrom( rhs );
+		return *this;
+	}
+
+	template<typename... TArgs>
+	T& emplace_back( TArgs&&... args )
+	{
+		if ( m_size == m_capacity )
+		{
+			return growAndEmplaceBack( std::forward<TArgs>( args )... );
+		}
+		T* p = m_pData + m_size;
+		TAllocTraits::construct( m_alloc,
+			p,
+			std::forward<TArgs>( args )... );
+		++m_size;
+		return *p;
+	}
+
+	void push_back( const T& value )
+	{
+		emplace_back( value );
+	}
+
+	void push_back( T&& value )
+	{
+		emplace_back( std::move( value ) );
+	}
+
+	void pop_back() noexcept
+	{
+		ASSERT( m_size > 0,
+			"pop_back() on an empty SmallVector!" );
+		--m_size;
+		m_pData[m_size].~T();
+	}
+
+	void resize( const std::size_t count )
+	{
+		reserve( count );
+		while ( m_size < count )
+		{
+			emplace_back();
+		}
+		while ( m_size > count )
+		{
+			pop_back();
+		}
+	}
+
+	void resize( const std::size_t count,
+		const T& value )
+	{
+		reserve( count );
+		while ( m_size < count )
+		{
+			emplace_back( value );
+		}
+		while ( m_size > count )
+		{
+			pop_back();
+		}
+	}
+
+	void reserve( const std::size_t count )
+	{
+		if ( count > m_capacity )
+		{
+			reallocate( count );
+		}
+	}
+
+	// destroys the elements, keeps the capacity
+	void clear() noexcept
+	{
+		std::destroy( m_pData,
+			m_pData + m_size );
+		m_size = 0;
+	}
+
+	T& operator[]( const std::size_t index ) noexcept
+	{
+		ASSERT( index < m_size,
+			"SmallVector index out of range!" );
+		return m_pData[index];
+	}
+
+	const T& operator[]( const std::size_t index ) const noexcept
+	{
+		ASSERT( index < m_size,
+			"SmallVector index out of range!" );
+		return m_pData[index];
+	}
+
+	T& front() noexcept
+	{
+		return ( *this )[0];
+	}
+
+	const T& front() const noexcept
+	{
+		return ( *this )[0];
+	}
+
+	T& back() noexcept
+	{
+		return ( *this )[m_size - 1];
+	}
+
+	const T& back() const noexcept
+	{
+		return ( *this )[m_size - 1];
+	}
+
+	T* data() noexcept
+	{
+		return m_pData;
+	}
+
+	const T* data() const noexcept
+	{
+		return m_pData;
+	}
+
+	T* begin() noexcept
+	{
+		return m_pData;
+	}
+
+	T* end() noexcept
+	{
+		return m_pData + m_size;
+	}
+
+	const T* begin() const noexcept
+	{
+		return m_pData;
+	}
+
+	const T* end() const noexcept
+	{
+		return m_pData + m_size;
+	}
+
+	bool empty() const noexcept
+	{
+		return m_size == 0;
+	}
+
+	std::size_t size() const noexcept
+	{
+		return m_size;
+	}
+
+	std::size_t capacity() const noexcept
+	{
+		return m_capacity;
+	}
+
+	// whether the elements still live in the object itself
+	bool isInline() const noexcept
+	{
+		return m_pData == getInlineData();
+	}
+
+	static constexpr std::size_t getInlineCapacity() noexcept
+	{
+		return t_inlineCapacity;
+	}
+
+	TAlloc get_allocator() const noexcept
+	{
+		return m_alloc;
+	}
+private:
+	T* getInlineData() noexcept
+	{
+		return reinterpret_cast<T*>( m_inline );
+	}
+
+	const T* getInlineData() const noexcept
+	{
+		return reinterpret_cast<const T*>( m_inline );
+	}
+
+	std::size_t getGrownCapacity( const std::size_t minCapacity ) const noexcept
+	{
+		return std::max( m_capacity * 2,
+			minCapacity );
+	}
+
+	// moves the elements to a buffer of `capacity` elements
+	void reallocate( const std::size_t capacity )
+	{
+		T* pNew = TAllocTraits::allocate( m_alloc,
+			capacity );
+		std::uninitialized_move( m_pData,
+			m_pData + m_size,
+			pNew );
+		std::destroy( m_pData,
+			m_pData + m_size );
+		releaseBuffer();
+		m_pData = pNew;
+		m_capacity = capacity;
+	}
+
+	// constructs the new element before moving the old ones, as `args` may refer to one of them
+	template<typename... TArgs>
+	T& growAndEmplaceBack( TArgs&&... args )
+	{
+		const std::size_t capacity = getGrownCapacity( m_size + 1 );
+		T* pNew = TAllocTraits::allocate( m_alloc,
+			capacity );
+		T* p = pNew + m_size;
+		try
+		{
+			TAllocTraits::construct( m_alloc,
+				p,
+				std::forward<TArgs>( args )... );
+		}
+		catch ( ... )
+		{
+			TAllocTraits::deallocate( m_alloc,
+				pNew,
+				capacity );
+			throw;
+		}
+		std::uninitialized_move( m_pData,
+			m_pData + m_size,
+			pNew );
+		std::destroy( m_pData,
+			m_pData + m_size );
+		releaseBuffer();
+		m_pData = pNew;
+		m_capacity = capacity;
+		++m_size;
+		return *p;
+	}
+
+	void releaseBuffer() noexcept
+	{
+		if ( !isInline() )
+		{
+			TAllocTraits::deallocate( m_alloc,
+				m_pData,
+				m_capacity );
+		}
+		m_pData = getInlineData();
+		m_capacity = t_inlineCapacity;
+	}
+
+	// `this` is empty
+	void moveFrom( SmallVector& rhs )
+	{
+		if ( !rhs.isInline() && m_alloc == rhs.m_alloc )
+		{
+			releaseBuffer();
+			stealBuffer( rhs );
+			return;
+		}
+		reserve( rhs.m_size );
+		uninitializedMoveA( rhs.begin(),
+			rhs.end(),
+			m_pData,
+			m_alloc );
+		m_size = rhs.m_size;
+		rhs.clear();
+	}
+
+	void stealBuffer( SmallVector& rhs ) noexcept
+	{
+		m_pData = rhs.m_pData;
+		m_size = rhs.m_size;
+		m_capacity = rhs.m_capacity;
+		rhs.m_pData = rhs.getInlineData();
+		rhs.m_size = 0;
+		rhs.m_capacity = t_inlineCapacity;
+	}
+};
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include "../assertions.h"
+
+
+//======================================================================
+// \class	StringBuilder
+//
+// \brief	builds one string directly in an `Arena` or `SArena`
+//			the string is the arena's latest allocation while it's being built, so appending
+//				grows it in place with `tryExpand()` and nothing is copied or abandoned; only
+//				if something else allocates from the arena in between is it moved once to the top
+//			`finish()` null terminates it and hands it over as a view that lives as long as the
+//				arena's memory; `discard()` gives the bytes back instead
+//			one builder per arena at a time; an unfinished builder is discarded on destruction
+//======================================================================
+template<typename TArena>
+class StringBuilder
+{
+	// the first allocation; later ones double
+	static constexpr std::size_t m_initialCapacity = 64;
+
+	TArena* m_pArena;
+	char* m_pData;
+	std::size_t m_size;
+	std::size_t m_capacity;
+public:
+	explicit StringBuilder( TArena* pArena ) noexcept
+		:
+		m_pArena{pArena},
+		m_pData{nullptr},
+		m_size{0},
+		m_capacity{0}
+	{
+
+	}
+
+	~StringBuilder() noexcept
+	{
+		discard();
+	}
+
+	StringBuilder( const StringBuilder& rhs ) = delete;
+	StringBuilder& operator=( const StringBuilder& rhs ) = delete;
+
+	StringBuilder& append( const std::string_view str )
+	{
+		char* p = extend( str.size() );
+		if ( !str.empty() )
+		{
+			std::memcpy( p,
+				str.data(),
+				str.size() );
+		}
+		return *this;
+	}
+
+	StringBuilder& append( const char c )
+	{
+		*extend( 1 ) = c;
+		return *this;
+	}
+
+	// decimal, without going through a temporary std::string
+	template<typename TInteger,
+		typename = std::enable_if_t<std::is_integral_v<TInteger>>>
+	StringBuilder& appendNumber( const TInteger value )
+	{
+		char digits[24];
+		const auto result = std::to_chars( digits,
+			digits + sizeof( digits ),
+			value );
+		return append( std::string_view{digits, static_cast<std::size_t>( result.ptr - digits )} );
+	}
+
+	StringBuilder& operator+=( const std::string_view str )
+	{
+		return append( str );
+	}
+
+	StringBuilder& operator+=( const char c )
+	{
+		return append( c );
+	}
+
+	// the characters so far, not null terminated
+	std::string_view view() const noexcept
+	{
+		return std::string_view{m_pData, m_size};
+	}
+
+	std::size_t size() const noexcept
+	{
+		return m_size;
+	}
+
+	bool empty() const noexcept
+	{
+		return m_size == 0;
+	}
+
+	// null terminates the string, trims the spare capacity and gives up ownership
+	//	the builder can then start the next string
+	std::string_view finish()
+	{
+		*extend( 1 ) = '\0';
+		if ( m_capacity > m_size )
+		{
+			m_pArena->tryExpand( m_pData,
+				m_capacity,
+				m_size );
+		}
+		const std::string_view str{m_pData, m_size - 1};
+		m_pData = nullptr;
+		m_size = 0;
+		m_capacity = 0;
+		return str;
+	}
+
+	// drops the string; its bytes go back to the arena if it's still the latest allocation
+	void discard() noexcept
+	{
+		if ( m_pData != nullptr )
+		{
+			m_pArena->tryExpand( m_pData,
+				m_capacity,
+				0 );
+		}
+		m_pData = nullptr;
+		m_size = 0;
+		m_capacity = 0;
+	}
+private:
+	// makes room for `count` more characters and returns where they go
+	char* extend( const std::size_t count )
+	{
+		const std::size_t size = m_size + count;
+		if ( size > m_capacity )
+		{
+			std::size_t capacity = m_capacity == 0 ?
+				m_initialCapacity :
+				m_capacity * 2;
+			if ( capacity < size )
+			{
+				capacity = size;
+			}
+			reserve( capacity );
+		}
+		char* p = m_pData + m_size;
+		m_size = size;
+		return p;
+	}
+
+	void reserve( const std::size_t capacity )
+	{
+		if ( m_pData != nullptr && m_pArena->tryExpand( m_pData, m_capacity, capacity ) )
+		{
+			m_capacity = capacity;
+			return;
+		}
+		// the arena throws std::bad_alloc if it's out of space
+		char* pNew = static_cast<char*>( m_pArena->allocate( capacity ) );
+		if ( m_size != 0 )
+		{
+			std::memcpy( pNew,
+				m_pData,
+				m_size );
+		}
+		m_pData = pNew;
+		m_capacity = capacity;
+	}
+};
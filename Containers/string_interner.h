@@ -0,0 +1,269 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+#include "../allocator_utils.h"
+
+
+//======================================================================
+// \class	StringInterner
+//
+// \brief	stores every distinct string once, back to back in an `Arena` or `SArena`
+//			`intern()` returns a view of the stored copy and `getId()` a dense 32-bit id;
+//				both stay valid until the arena is reset, so equal strings compare by
+//				pointer or id instead of by content
+//			lookups go through an open addressing table of 8 byte slots holding 32 bits of
+//				the hash and the id; the string itself is only compared on a hash match
+//			the hash can be computed up front with `hash()` and passed in, eg. for keys that
+//				are looked up repeatedly
+//			stored strings are null terminated; the table and the id -> string index live on
+//				the heap, as they are rehashed and grown
+//			an `Arena<1>` packs the strings with no padding between them
+//			not thread safe
+//======================================================================
+template<typename TArena>
+class StringInterner
+{
+	struct Slot final
+	{
+		std::uint32_t hashTag;
+		// 0 marks an empty slot
+		std::uint32_t idPlusOne;
+	};
+
+	struct Entry final
+	{
+		const char* pChars;
+		std::uint32_t length;
+		// the table index is taken from these bits, the slot's tag from the low ones
+		std::uint32_t hashHigh;
+	};
+
+	static constexpr std::size_t m_initialSlots = 64;
+
+	TArena* m_pArena;
+	std::vector<Slot> m_slots;
+	std::vector<Entry> m_entries;
+	std::size_t m_storedBytes;
+	std::size_t m_nRequests;
+public:
+	static constexpr std::uint32_t invalidId = 0xFFFFFFFFu;
+
+	explicit StringInterner( TArena* pArena )
+		:
+		m_pArena{pArena},
+		m_slots(m_initialSlots),
+		m_entries{},
+		m_storedBytes{0},
+		m_nRequests{0}
+	{
+
+	}
+
+	StringInterner( const StringInterner& rhs ) = delete;
+	StringInterner& operator=( const StringInterner& rhs ) = delete;
+
+	// 8 bytes per multiply, with a final mix so both halves of the result are usable
+	//	the last word overlaps the one before it instead of looping over the tail bytes
+	static std::uint64_t hash( const std::string_view str ) noexcept
+	{
+		constexpr std::uint64_t k = 0x9E3779B97F4A7C15ull;
+		const char* p = str.data();
+		const std::size_t length = str.size();
+		std::uint64_t h = length * k;
+		if ( length >= 8 )
+		{
+			for ( std::size_t i = 0; i + 8 < length; i += 8 )
+			{
+				h = ( h ^ load<std::uint64_t>( p + i ) ) * k;
+				h ^= h >> 32;
+			}
+			h = ( h ^ load<std::uint64_t>( p + length - 8 ) ) * k;
+		}
+		else if ( length >= 4 )
+		{
+			h = ( h ^ ( std::uint64_t{load<std::uint32_t>( p )} << 32 | load<std::uint32_t>( p + length - 4 ) ) ) * k;
+		}
+		else if ( length > 0 )
+		{
+			h = ( h ^ ( std::uint64_t{static_cast<unsigned char>( p[0] )} << 16
+				| std::uint64_t{static_cast<unsigned char>( p[length / 2] )} << 8
+				| static_cast<unsigned char>( p[length - 1] ) ) ) * k;
+		}
+		h ^= h >> 29;
+		h *= 0xBF58476D1CE4E5B9ull;
+		return h ^ ( h >> 32 );
+	}
+
+	// the id of `str`, storing it on first sight
+	std::uint32_t getId( const std::string_view str )
+	{
+		return getId( str,
+			hash( str ) );
+	}
+
+	// `strHash` must be `hash( str )`
+	std::uint32_t getId( const std::string_view str,
+		const std::uint64_t strHash )
+	{
+		++m_nRequests;
+		std::size_t index = getSlotIndex( strHash );
+		const std::uint32_t hashTag = static_cast<std::uint32_t>( strHash );
+		while ( m_slots[index].idPlusOne != 0 )
+		{
+			const Slot slot = m_slots[index];
+			if ( slot.hashTag == hashTag && getString( slot.idPlusOne - 1 ) == str )
+			{
+				return slot.idPlusOne - 1;
+			}
+			index = ( index + 1 ) & ( m_slots.size() - 1 );
+		}
+		const std::uint32_t id = store( str,
+			strHash );
+		m_slots[index] = Slot{hashTag, id + 1};
+		// keep the load factor at most 3/4
+		if ( 4 * m_entries.size() > 3 * m_slots.size() )
+		{
+			rehash( 2 * m_slots.size() );
+		}
+		return id;
+	}
+
+	// the stored copy of `str`
+	std::string_view intern( const std::string_view str )
+	{
+		return getString( getId( str ) );
+	}
+
+	std::string_view intern( const std::string_view str,
+		const std::uint64_t strHash )
+	{
+		return getString( getId( str, strHash ) );
+	}
+
+	// the id of `str` if it has been interned, `invalidId` otherwise; never stores anything
+	std::uint32_t find( const std::string_view str ) const noexcept
+	{
+		const std::uint64_t strHash = hash( str );
+		std::size_t index = getSlotIndex( strHash );
+		const std::uint32_t hashTag = static_cast<std::uint32_t>( strHash );
+		while ( m_slots[index].idPlusOne != 0 )
+		{
+			const Slot slot = m_slots[index];
+			if ( slot.hashTag == hashTag && getString( slot.idPlusOne - 1 ) == str )
+			{
+				return slot.idPlusOne - 1;
+			}
+			index = ( index + 1 ) & ( m_slots.size() - 1 );
+		}
+		return invalidId;
+	}
+
+	std::string_view getString( const std::uint32_t id ) const noexcept
+	{
+		ASSERT( id < m_entries.size(),
+			"Invalid string id!" );
+		const Entry& entry = m_entries[id];
+		return std::string_view{entry.pChars, entry.length};
+	}
+
+	// null terminated
+	const char* c_str( const std::uint32_t id ) const noexcept
+	{
+		return getString( id ).data();
+	}
+
+	// distinct strings stored
+	std::size_t size() const noexcept
+	{
+		return m_entries.size();
+	}
+
+	// lookups so far, hits and misses
+	std::size_t getRequests() const noexcept
+	{
+		return m_nRequests;
+	}
+
+	// arena bytes holding the strings and their terminators
+	std::size_t getStoredBytes() const noexcept
+	{
+		return m_storedBytes;
+	}
+
+	// forgets every string, eg. before the arena is reset
+	void clear() noexcept
+	{
+		std::fill( m_slots.begin(),
+			m_slots.end(),
+			Slot{0, 0} );
+		m_entries.clear();
+		m_storedBytes = 0;
+	}
+
+	TArena* getArena() const noexcept
+	{
+		return m_pArena;
+	}
+private:
+	template<typename TWord>
+	static TWord load( const char* p ) noexcept
+	{
+		TWord word;
+		std::memcpy( &word,
+			p,
+			sizeof( TWord ) );
+		return word;
+	}
+
+	std::size_t getSlotIndex( const std::uint64_t strHash ) const noexcept
+	{
+		return static_cast<std::size_t>( strHash >> 32 ) & ( m_slots.size() - 1 );
+	}
+
+	std::uint32_t store( const std::string_view str,
+		const std::uint64_t strHash )
+	{
+		ASSERT( m_entries.size() < invalidId,
+			"StringInterner out of ids!" );
+		char* p = static_cast<char*>( m_pArena->allocate( str.size() + 1 ) );
+		if ( !str.empty() )
+		{
+			std::memcpy( p,
+				str.data(),
+				str.size() );
+		}
+		p[str.size()] = '\0';
+		m_storedBytes += str.size() + 1;
+		m_entries.push_back( Entry{p,
+			static_cast<std::uint32_t>( str.size() ),
+			static_cast<std::uint32_t>( strHash >> 32 )} );
+		return static_cast<std::uint32_t>( m_entries.size() - 1 );
+	}
+
+	void rehash( const std::size_t nSlots )
+	{
+		ASSERT( isPowerOfTwo( nSlots ),
+			"StringInterner table size must be a power of 2." );
+		std::vector<Slot> slots(nSlots);
+		for ( const Slot& slot : m_slots )
+		{
+			if ( slot.idPlusOne == 0 )
+			{
+				continue;
+			}
+			const std::uint64_t strHash = ( std::uint64_t{m_entries[slot.idPlusOne - 1].hashHigh} << 32 ) | slot.hashTag;
+			std::size_t index = static_cast<std::size_t>( strHash >> 32 ) & ( nSlots - 1 );
+			while ( slots[index].idPlusOne != 0 )
+			{
+				index = ( index + 1 ) & ( nSlots - 1 );
+			}
+			slots[index] = slot;
+		}
+		m_slots.swap( slots );
+	}
+};
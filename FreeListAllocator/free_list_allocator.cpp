@@ -0,0 +1,112 @@
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+#include "free_list_allocator.h"
+
+
+template<FitPolicy fitPolicy>
+static void printStats( const char* name,
+	const FreeListArena<fitPolicy>& arena )
+{
+	const AllocatorStats stats = arena.getStats();
+	std::cout << name
+		<< ": requested="
+		<< stats.requestedBytes
+		<< " headers="
+		<< stats.headerBytes
+		<< " free="
+		<< stats.freeBytes
+		<< " in "
+		<< arena.getFreeBlockCount()
+		<< " blocks, largest="
+		<< stats.largestFreeBlock
+		<< '\n';
+}
+
+// the same out of order frees on each placement policy
+template<FitPolicy fitPolicy>
+static void freeOutOfOrder( const char* name )
+{
+	FreeListArena<fitPolicy> arena{16 * 1024};
+	std::vector<void*> blocks;
+	for ( std::size_t i = 0; i < 32; ++i )
+	{
+		blocks.push_back( arena.allocate( 24 + ( i % 5 ) * 100 ) );
+	}
+	// free every third block, leaving holes of different sizes
+	for ( std::size_t i = 0; i < blocks.size(); i += 3 )
+	{
+		arena.deallocate( blocks[i] );
+		blocks[i] = nullptr;
+	}
+	// then fill some of the holes
+	for ( std::size_t i = 0; i < 6; ++i )
+	{
+		blocks.push_back( arena.allocate( 90 ) );
+	}
+	printStats( name,
+		arena );
+	for ( void* p : blocks )
+	{
+		arena.deallocate( p );
+	}
+	std::cout << "  all freed, merged into one block="
+		<< ( arena.getFreeBlockCount() == 1 )
+		<< '\n';
+}
+
+int main()
+{
+	std::cout << std::boolalpha << '\n';
+
+	freeOutOfOrder<FitPolicy::FirstFit>( "first fit" );
+	freeOutOfOrder<FitPolicy::NextFit>( "next fit" );
+	freeOutOfOrder<FitPolicy::BestFit>( "best fit" );
+
+	// containers that free in no particular order, which a StackAllocator can't take
+	FreeListArena<FitPolicy::BestFit> arena{64 * 1024};
+	{
+		using fstring = std::basic_string<char, std::char_traits<char>, FreeListAllocator<char, FitPolicy::BestFit>>;
+		FreeListAllocator<char, FitPolicy::BestFit> alloc{&arena};
+		std::list<fstring, FreeListAllocator<fstring, FitPolicy::BestFit>> names{FreeListAllocator<fstring, FitPolicy::BestFit>{alloc}};
+		std::map<int, int, std::less<>, FreeListAllocator<std::pair<const int, int>, FitPolicy::BestFit>> squares{FreeListAllocator<std::pair<const int, int>, FitPolicy::BestFit>{alloc}};
+		for ( int i = 0; i < 100; ++i )
+		{
+			names.emplace_back( "a name long enough to need the arena, number " + std::to_string( i ),
+				alloc );
+			squares.emplace( i,
+				i * i );
+		}
+		// erase from the middle and the front, reinsert, and let everything go in destruction order
+		for ( auto it = names.begin(); it != names.end(); )
+		{
+			it = it->back() % 3 == 0 ?
+				names.erase( it ) :
+				std::next( it );
+		}
+		for ( int i = 0; i < 100; i += 2 )
+		{
+			squares.erase( i );
+		}
+		names.emplace_front( "reinserted into a hole",
+			alloc );
+		std::cout << "names="
+			<< names.size()
+			<< " squares="
+			<< squares.size()
+			<< " squares[51]="
+			<< squares.at( 51 )
+			<< '\n';
+		printStats( "containers",
+			arena );
+	}
+	printStats( "containers destroyed",
+		arena );
+
+	std::system( "pause" );
+	return 0;
+}
@@ -0,0 +1,494 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include "../allocator_stats.h"
+#include "../allocator_utils.h"
+#include "../assertions.h"
+
+
+// where `FreeListArena` places an allocation among the free blocks that fit it
+enum class FitPolicy
+{
+	// the lowest addressed block; quick, and keeps the high addresses free for large requests
+	FirstFit,
+	// the first block from where the previous search stopped; spreads allocations over the arena
+	NextFit,
+	// the smallest block; least waste per allocation, but always walks the whole free list
+	BestFit
+};
+
+//======================================================================
+// \class	FreeListArena
+//
+// \brief	variable size allocations freed in any order within one fixed block, which
+//				`SArena` can't do: it only takes back its latest allocation
+//			the free blocks form a list in address order; `FitPolicy` picks the block an
+//				allocation goes to, and the rest of that block stays free
+//			as in `SArena`, each allocation has a `Header` right in front of it, recording the
+//				block it took up, so `deallocate()` needs only the pointer
+//			a freed block is put back in address order and merged with the free blocks right
+//				before and after it, so free space never stays split at a boundary
+//			allocating is O(free blocks) (O(1) when first/next fit find one near the start),
+//				freeing is O(free blocks) to find its place in the list
+//			not thread safe
+//======================================================================
+template<FitPolicy fitPolicy = FitPolicy::FirstFit, std::size_t t_alignment = alignof( std::max_align_t )>
+class FreeListArena
+{
+	static_assert( isPowerOfTwo( t_alignment ),
+		"FreeListArena alignment value must be a power of 2." );
+
+	static inline constexpr std::size_t m_alignment = t_alignment;
+
+	struct Header final
+	{
+		// the whole block, from its start (which may be before the alignment padding) to its end
+		std::size_t blockSize;
+		// from the block's start to the allocation
+		std::size_t padding;
+	};
+
+	struct FreeBlock final
+	{
+		std::size_t size;
+		FreeBlock* pNext;
+		FreeBlock* pPrev;
+	};
+
+	// blocks are multiples of this, so every block can hold the free list links once freed
+	static constexpr std::size_t m_blockGranularity = alignof( FreeBlock );
+	static constexpr std::size_t m_minBlockSize = sizeof( FreeBlock );
+
+	char* m_pData;
+	std::size_t m_maxSize;
+	FreeBlock* m_pFreeList;
+	// where `FitPolicy::NextFit` resumes; any free block, or null for the head
+	FreeBlock* m_pRover;
+	std::size_t m_freeBytes;
+	std::size_t m_requestedBytes;
+	std::size_t m_paddingBytes;
+	std::size_t m_nAllocations;
+public:
+	explicit FreeListArena( const std::size_t size )
+		:
+		m_pData{static_cast<char*>( alignedMalloc<m_alignment>( size ) )},
+		m_maxSize{size & ~( m_blockGranularity - 1 )},
+		m_pFreeList{nullptr},
+		m_pRover{nullptr},
+		m_freeBytes{0},
+		m_requestedBytes{0},
+		m_paddingBytes{0},
+		m_nAllocations{0}
+	{
+		ASSERT( m_maxSize >= m_minBlockSize,
+			"Invalid size!" );
+		reset();
+	}
+
+	~FreeListArena() noexcept
+	{
+		alignedFree<m_alignment>( m_pData );
+	}
+
+	FreeListArena( const FreeListArena& rhs ) = delete;
+	FreeListArena& operator=( const FreeListArena& rhs ) = delete;
+
+	// throws std::bad_alloc if no free block fits `bytes` with its header and padding
+	[[nodiscard]]
+	void* allocate( const std::size_t bytes )
+	{
+		// more than the arena holds, and the block size could wrap when rounded up
+		if ( bytes > m_maxSize )
+		{
+			throw std::bad_alloc{};
+		}
+		std::size_t blockSize = 0;
+		std::size_t padding = 0;
+		FreeBlock* pBlock = findBlock( bytes,
+			blockSize,
+			padding );
+		if ( pBlock == nullptr )
+		{
+			throw std::bad_alloc{};
+		}
+		// a remainder too small to hold the free list links goes with the allocation
+		if ( pBlock->size - blockSize >= m_minBlockSize )
+		{
+			FreeBlock* pRest = reinterpret_cast<FreeBlock*>( reinterpret_cast<char*>( pBlock ) + blockSize );
+			pRest->size = pBlock->size - blockSize;
+			replaceFree( pBlock,
+				pRest );
+		}
+		else
+		{
+			blockSize = pBlock->size;
+			removeFree( pBlock );
+			if constexpr ( fitPolicy == FitPolicy::NextFit )
+			{
+				m_pRover = pBlock->pNext;
+			}
+		}
+		m_freeBytes -= blockSize;
+		m_requestedBytes += blockSize - padding;
+		m_paddingBytes += padding - sizeof( Header );
+		++m_nAllocations;
+
+		char* p = reinterpret_cast<char*>( pBlock ) + padding;
+		Header* pHeader = reinterpret_cast<Header*>( p - sizeof( Header ) );
+		pHeader->blockSize = blockSize;
+		pHeader->padding = padding;
+		return p;
+	}
+
+	// in any order; `count` is ignored, the header has the block size
+	void deallocate( void* p,
+		[[maybe_unused]] std::size_t count = 0 ) noexcept
+	{
+		if ( p == nullptr )
+		{
+			return;
+		}
+		ASSERT( owns( p ),
+			"Pointer not from this FreeListArena!" );
+		const Header header = *reinterpret_cast<const Header*>( static_cast<char*>( p ) - sizeof( Header ) );
+		FreeBlock* pBlock = reinterpret_cast<FreeBlock*>( static_cast<char*>( p ) - header.padding );
+		pBlock->size = header.blockSize;
+		m_freeBytes += header.blockSize;
+		m_requestedBytes -= header.blockSize - header.padding;
+		m_paddingBytes -= header.padding - sizeof( Header );
+		--m_nAllocations;
+
+		// the free block right before `pBlock` in memory, if any
+		FreeBlock* pPrev = nullptr;
+		FreeBlock* pNext = m_pFreeList;
+		while ( pNext != nullptr && pNext < pBlock )
+		{
+			pPrev = pNext;
+			pNext = pNext->pNext;
+		}
+		ASSERT( pNext != pBlock && ( pPrev == nullptr || getEnd( pPrev ) <= reinterpret_cast<char*>( pBlock ) ),
+			"FreeListArena block freed twice!" );
+		insertFree( pBlock,
+			pPrev,
+			pNext );
+		if ( pNext != nullptr && getEnd( pBlock ) == reinterpret_cast<char*>( pNext ) )
+		{
+			pBlock->size += pNext->size;
+			removeFree( pNext );
+		}
+		if ( pPrev != nullptr && getEnd( pPrev ) == reinterpret_cast<char*>( pBlock ) )
+		{
+			pPrev->size += pBlock->size;
+			removeFree( pBlock );
+		}
+	}
+
+	// frees everything at once: the arena is one free block again
+	void reset() noexcept
+	{
+		m_pFreeList = reinterpret_cast<FreeBlock*>( m_pData );
+		m_pFreeList->size = m_maxSize;
+		m_pFreeList->pNext = nullptr;
+		m_pFreeList->pPrev = nullptr;
+		m_pRover = nullptr;
+		m_freeBytes = m_maxSize;
+		m_requestedBytes = 0;
+		m_paddingBytes = 0;
+		m_nAllocations = 0;
+	}
+
+	std::size_t getAvailableMemory() const noexcept
+	{
+		return m_freeBytes;
+	}
+
+	// the largest free block is found by walking the free list
+	//	the header doesn't keep the size asked for, so the rounding of the block to
+	//	`m_blockGranularity` and any remainder too small to split off count as requested bytes;
+	//	padding is the alignment padding in front of the header
+	AllocatorStats getStats() const noexcept
+	{
+		AllocatorStats stats;
+		stats.requestedBytes = m_requestedBytes;
+		stats.paddingBytes = m_paddingBytes;
+		stats.headerBytes = m_nAllocations * sizeof( Header );
+		stats.freeBytes = m_freeBytes;
+		for ( const FreeBlock* pBlock = m_pFreeList; pBlock != nullptr; pBlock = pBlock->pNext )
+		{
+			if ( pBlock->size > stats.largestFreeBlock )
+			{
+				stats.largestFreeBlock = pBlock->size;
+			}
+		}
+		stats.totalBytes = m_maxSize;
+		return stats;
+	}
+
+	std::size_t getFreeBlockCount() const noexcept
+	{
+		std::size_t count = 0;
+		for ( const FreeBlock* pBlock = m_pFreeList; pBlock != nullptr; pBlock = pBlock->pNext )
+		{
+			++count;
+		}
+		return count;
+	}
+
+	bool owns( const void* p ) const noexcept
+	{
+		const std::size_t address = reinterpret_cast<std::size_t>( p );
+		return address >= reinterpret_cast<std::size_t>( m_pData ) && address < getEndAddress();
+	}
+
+	// GETTERS
+	char* getStartAddress() const noexcept
+	{
+		return m_pData;
+	}
+
+	std::size_t getEndAddress() const noexcept
+	{
+		return reinterpret_cast<std::size_t>( m_pData ) + m_maxSize;
+	}
+
+	std::size_t getMaxSize() const noexcept
+	{
+		return m_maxSize;
+	}
+
+	static constexpr std::size_t getAlignment() noexcept
+	{
+		return m_alignment;
+	}
+
+	static constexpr FitPolicy getFitPolicy() noexcept
+	{
+		return fitPolicy;
+	}
+private:
+	static char* getEnd( FreeBlock* pBlock ) noexcept
+	{
+		return reinterpret_cast<char*>( pBlock ) + pBlock->size;
+	}
+
+	// the size of the block `bytes` takes up if placed at `pBlock`, and the padding in front
+	static std::size_t getBlockSize( const FreeBlock* pBlock,
+		const std::size_t bytes,
+		std::size_t& padding ) noexcept
+	{
+		padding = getForwardPaddingWithHeader<m_alignment>( reinterpret_cast<std::size_t>( pBlock ),
+			sizeof( Header ) );
+		const std::size_t blockSize = calcAlignedSize( padding + bytes,
+			m_blockGranularity );
+		return blockSize < m_minBlockSize ?
+			m_minBlockSize :
+			blockSize;
+	}
+
+	FreeBlock* findBlock( const std::size_t bytes,
+		std::size_t& blockSize,
+		std::size_t& padding ) noexcept
+	{
+		if constexpr ( fitPolicy == FitPolicy::BestFit )
+		{
+			FreeBlock* pBest = nullptr;
+			for ( FreeBlock* pBlock = m_pFreeList; pBlock != nullptr; pBlock = pBlock->pNext )
+			{
+				std::size_t blockPadding;
+				const std::size_t size = getBlockSize( pBlock,
+					bytes,
+					blockPadding );
+				if ( pBlock->size >= size && ( pBest == nullptr || pBlock->size < pBest->size ) )
+				{
+					pBest = pBlock;
+					blockSize = size;
+					padding = blockPadding;
+					if ( pBlock->size == size )
+					{
+						break;
+					}
+				}
+			}
+			return pBest;
+		}
+		else
+		{
+			FreeBlock* pStart = fitPolicy == FitPolicy::NextFit && m_pRover != nullptr ?
+				m_pRover :
+				m_pFreeList;
+			FreeBlock* pBlock = pStart;
+			do
+			{
+				if ( pBlock == nullptr )
+				{
+					// next fit wraps around to the head; first fit is done
+					if ( pStart == m_pFreeList )
+					{
+						return nullptr;
+					}
+					pBlock = m_pFreeList;
+					continue;
+				}
+				blockSize = getBlockSize( pBlock,
+					bytes,
+					padding );
+				if ( pBlock->size >= blockSize )
+				{
+					return pBlock;
+				}
+				pBlock = pBlock->pNext;
+			} while ( pBlock != pStart );
+			return nullptr;
+		}
+	}
+
+	void insertFree( FreeBlock* pBlock,
+		FreeBlock* pPrev,
+		FreeBlock* pNext ) noexcept
+	{
+		pBlock->pPrev = pPrev;
+		pBlock->pNext = pNext;
+		if ( pPrev != nullptr )
+		{
+			pPrev->pNext = pBlock;
+		}
+		else
+		{
+			m_pFreeList = pBlock;
+		}
+		if ( pNext != nullptr )
+		{
+			pNext->pPrev = pBlock;
+		}
+	}
+
+	void removeFree( FreeBlock* pBlock ) noexcept
+	{
+		if ( pBlock->pPrev != nullptr )
+		{
+			pBlock->pPrev->pNext = pBlock->pNext;
+		}
+		else
+		{
+			m_pFreeList = pBlock->pNext;
+		}
+		if ( pBlock->pNext != nullptr )
+		{
+			pBlock->pNext->pPrev = pBlock->pPrev;
+		}
+		if ( m_pRover == pBlock )
+		{
+			m_pRover = pBlock->pNext;
+		}
+	}
+
+	// `pNew` takes the place of `pOld` in the list, eg. the rest of a block that was split
+	void replaceFree( FreeBlock* pOld,
+		FreeBlock* pNew ) noexcept
+	{
+		insertFree( pNew,
+			pOld->pPrev,
+			pOld->pNext );
+		if ( fitPolicy == FitPolicy::NextFit || m_pRover == pOld )
+		{
+			m_pRover = pNew;
+		}
+	}
+};
+
+
+//----------------------------------------------------------------------------------------
+// FreeListAllocator
+//
+// \brief	std allocator over a `FreeListArena`, which it doesn't own
+//			unlike `StackAllocator`, containers may free in any order
+//			as with `StackAllocator`, a container keeps the arena it was constructed with
+//----------------------------------------------------------------------------------------
+template<typename T, FitPolicy fitPolicy = FitPolicy::FirstFit, std::size_t t_alignment = alignof( std::max_align_t )>
+class FreeListAllocator
+{
+	using TArena = FreeListArena<fitPolicy, t_alignment>;
+
+	TArena* m_pArena;
+public:
+	using value_type = T;
+	using pointer = T*;
+
+	using propagate_on_container_copy_assignment = std::false_type;
+	using propagate_on_container_move_assignment = std::false_type;
+	using propagate_on_container_swap = std::false_type;
+	using is_always_equal = std::false_type;
+
+	explicit FreeListAllocator( TArena* pArena ) noexcept
+		:
+		m_pArena{pArena}
+	{
+		static_assert( alignof( T ) <= t_alignment,
+			"T is over-aligned for this FreeListArena." );
+	}
+
+	FreeListAllocator( const FreeListAllocator& rhs ) noexcept
+		:
+		m_pArena{rhs.getArena()}
+	{
+
+	}
+
+	template<typename Other>
+	FreeListAllocator( const FreeListAllocator<Other, fitPolicy, t_alignment>& rhs ) noexcept
+		:
+		m_pArena{rhs.getArena()}
+	{
+
+	}
+
+	template<typename Other>
+	struct rebind
+	{
+		using other = FreeListAllocator<Other, fitPolicy, t_alignment>;
+	};
+
+	[[nodiscard]]
+	T* allocate( std::size_t count )
+	{
+		if ( count > ~std::size_t{0} / sizeof( T ) )
+		{
+			throw std::bad_alloc{};
+		}
+		return static_cast<T*>( m_pArena->allocate( count * sizeof( T ) ) );
+	}
+
+	void deallocate( T* p,
+		std::size_t count ) noexcept
+	{
+		m_pArena->deallocate( p,
+			count );
+	}
+
+	TArena* getArena() const noexcept
+	{
+		return m_pArena;
+	}
+
+	AllocatorStats getStats() const noexcept
+	{
+		return m_pArena->getStats();
+	}
+};
+
+template<typename T, typename Other, FitPolicy fitPolicy, std::size_t t_alignment>
+inline bool operator==( const FreeListAllocator<T, fitPolicy, t_alignment>& lhs,
+	const FreeListAllocator<Other, fitPolicy, t_alignment>& rhs ) noexcept
+{
+	return lhs.getArena() == rhs.getArena();
+}
+
+template<typename T, typename Other, FitPolicy fitPolicy, std::size_t t_alignment>
+inline bool operator!=( const FreeListAllocator<T, fitPolicy, t_alignment>& lhs,
+	const FreeListAllocator<Other, fitPolicy, t_alignment>& rhs ) noexcept
+{
+	return lhs.getArena() != rhs.getArena();
+}
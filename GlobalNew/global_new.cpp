@@ -0,0 +1,696 @@
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#if defined(_MSC_VER) || defined(_WIN32) || defined(_WIN64)
+#	ifndef NOMINMAX
+#		define NOMINMAX
+#	endif
+#	include <windows.h>
+#else
+#	include <sys/mman.h>
+#	include <unistd.h>
+#endif
+#include "../allocator_utils.h"
+#include "../size_classes.h"
+
+
+//======================================================================
+// \file	global_new.cpp
+//
+// \brief	Drop-in replacement of every global operator new/delete overload.
+//			Link this translation unit (the `GlobalNew` object library) into an executable
+//				and all its `new`s, including those made by std containers, go through it:
+//			small		size <= smallMaxSize, default alignment
+//							per-thread free lists of `SizeClasses` slots (ObjectPool style),
+//							carved out of chunks shared by all threads of a class
+//			medium		size <= mediumMaxSize, or small with extended alignment
+//							bump allocation in a thread-local chunk (Arena style); a chunk is
+//							reset when all its blocks are freed or released when it is retired
+//							and its last block is freed, by whichever thread frees it
+//			large		everything else, in pages mapped for the block alone, placed so that
+//							their first bytes are a chunkSize aligned ChunkHeader
+//
+//			Every block belongs to a `chunkSize` aligned region whose first bytes are a ChunkHeader,
+//				so `delete` finds the owner of any pointer by masking it; no per-block headers.
+//			Chunks and large blocks are page mappings of their own (mmap / VirtualAlloc), so
+//				the alignment costs address space only while mapping, never memory.
+//			Small slots are never returned to the system; they are recycled across threads
+//				via a central free list when a thread exits.
+//======================================================================
+namespace
+{
+
+constexpr std::size_t chunkSize = 64 * 1024;
+constexpr std::size_t chunkHeaderSize = 64;
+constexpr std::size_t smallGranularity = 16;
+constexpr std::size_t smallMaxSize = 256;
+using TSmallClasses = SizeClasses<smallMaxSize, smallGranularity>;
+constexpr std::size_t nSmallClasses = TSmallClasses::getClassCount();
+constexpr std::size_t mediumMaxSize = 8 * 1024;
+constexpr std::size_t mediumMaxAlignment = 4096;
+constexpr std::size_t defaultAlignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+static_assert( isPowerOfTwo( chunkSize ),
+	"chunkSize must be a power of 2." );
+static_assert( smallGranularity >= defaultAlignment && smallGranularity % defaultAlignment == 0,
+	"small slots must keep the default new alignment." );
+
+enum class ChunkKind : std::uint32_t
+{
+	Small,
+	Medium,
+	Large
+};
+
+struct alignas( chunkHeaderSize ) ChunkHeader final
+{
+	ChunkKind kind;
+	// Small: size class index of every slot in the chunk
+	std::uint32_t sizeClass;
+	// Medium: live blocks, plus one while the owning thread still bumps from the chunk
+	std::atomic<std::size_t> refs;
+	// the mapping the chunk or the large block lives in and its length
+	void* pRawBlock;
+	std::size_t rawSize;
+};
+static_assert( sizeof( ChunkHeader ) == chunkHeaderSize,
+	"ChunkHeader must fit its reserved space." );
+
+struct FreeSlot final
+{
+	FreeSlot* pNext;
+};
+
+// constant-initialized so that it is usable before main() and after the thread's TLS destructors ran
+struct ThreadCache final
+{
+	FreeSlot* freeLists[nSmallClasses];
+	unsigned char* bump[nSmallClasses];
+	unsigned char* bumpEnd[nSmallClasses];
+	ChunkHeader* pMediumChunk;
+	std::size_t mediumOffset;
+	bool bRegistered;
+	bool bDead;
+};
+
+thread_local ThreadCache tCache{};
+
+std::mutex centralMutex;
+FreeSlot* centralFreeLists[nSmallClasses]{};
+
+constexpr std::size_t getSmallClass( const std::size_t size ) noexcept
+{
+	return TSmallClasses::getClassIndex( size );
+}
+
+constexpr std::size_t getSmallSlotSize( const std::size_t sizeClass ) noexcept
+{
+	return TSmallClasses::getSlotSize( sizeClass );
+}
+
+ChunkHeader* getChunk( void* p ) noexcept
+{
+	// -1: a block never starts at its chunk's base, but a large block aligned to chunkSize
+	//	keeps its header in the chunkSize bytes right below it
+	return reinterpret_cast<ChunkHeader*>( ( reinterpret_cast<std::uintptr_t>( p ) - 1 )
+		& ~( chunkSize - 1 ) );
+}
+
+std::size_t getPageSize() noexcept
+{
+#if defined(_MSC_VER) || defined(_WIN32) || defined(_WIN64)
+	SYSTEM_INFO info;
+	GetSystemInfo( &info );
+	return info.dwPageSize;
+#else
+	return static_cast<std::size_t>( sysconf( _SC_PAGESIZE ) );
+#endif
+}
+
+void unmapPages( void* p,
+	[[maybe_unused]] const std::size_t bytes ) noexcept
+{
+#if defined(_MSC_VER) || defined(_WIN32) || defined(_WIN64)
+	VirtualFree( p,
+		0,
+		MEM_RELEASE );
+#else
+	munmap( p,
+		bytes );
+#endif
+}
+
+// maps `bytes`, a multiple of the page size, `lead` bytes before an `alignment` boundary
+//	`alignment` is at least chunkSize and `lead` is a multiple of it, so the mapping starts on
+//	a chunkSize boundary; over-maps by `alignment` and gives back the misaligned head and tail
+//	returns nullptr if it can't
+unsigned char* tryMapAligned( const std::size_t bytes,
+	const std::size_t alignment,
+	const std::size_t lead ) noexcept
+{
+	const std::size_t reserveBytes = bytes + alignment;
+#if defined(_MSC_VER) || defined(_WIN32) || defined(_WIN64)
+	// VirtualFree can't release part of a reservation: find an aligned spot, free the whole
+	//	reservation and map the spot alone, unless another thread took it in between
+	for ( int attempt = 0; attempt < 8; ++attempt )
+	{
+		void* pReserved = VirtualAlloc( nullptr,
+			reserveBytes,
+			MEM_RESERVE,
+			PAGE_NOACCESS );
+		if ( pReserved == nullptr )
+		{
+			return nullptr;
+		}
+		const std::uintptr_t base = alignForward( reinterpret_cast<std::uintptr_t>( pReserved ) + lead,
+			alignment ) - lead;
+		VirtualFree( pReserved,
+			0,
+			MEM_RELEASE );
+		if ( void* p = VirtualAlloc( reinterpret_cast<void*>( base ),
+			bytes,
+			MEM_RESERVE | MEM_COMMIT,
+			PAGE_READWRITE ) )
+		{
+			return static_cast<unsigned char*>( p );
+		}
+	}
+	return nullptr;
+#else
+	void* pMapped = mmap( nullptr,
+		reserveBytes,
+		PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS,
+		-1,
+		0 );
+	if ( pMapped == MAP_FAILED )
+	{
+		return nullptr;
+	}
+	unsigned char* pRaw = static_cast<unsigned char*>( pMapped );
+	unsigned char* pBase = reinterpret_cast<unsigned char*>( alignForward( reinterpret_cast<std::uintptr_t>( pRaw ) + lead,
+		alignment ) - lead );
+	if ( pBase != pRaw )
+	{
+		munmap( pRaw,
+			pBase - pRaw );
+	}
+	if ( pBase + bytes != pRaw + reserveBytes )
+	{
+		munmap( pBase + bytes,
+			pRaw + reserveBytes - ( pBase + bytes ) );
+	}
+	return pBase;
+#endif
+}
+
+ChunkHeader* tryAllocateChunk( const ChunkKind kind,
+	const std::uint32_t sizeClass ) noexcept
+{
+	unsigned char* p = tryMapAligned( chunkSize,
+		chunkSize,
+		0 );
+	if ( p == nullptr )
+	{
+		return nullptr;
+	}
+	ChunkHeader* pChunk = ::new( p ) ChunkHeader;
+	pChunk->kind = kind;
+	pChunk->sizeClass = sizeClass;
+	pChunk->refs.store( 1,
+		std::memory_order_relaxed );
+	pChunk->pRawBlock = p;
+	pChunk->rawSize = chunkSize;
+	return pChunk;
+}
+
+void releaseMediumChunk( ChunkHeader* pChunk ) noexcept
+{
+	if ( pChunk->refs.fetch_sub( 1, std::memory_order_acq_rel ) == 1 )
+	{
+		pChunk->~ChunkHeader();
+		unmapPages( pChunk,
+			chunkSize );
+	}
+}
+
+// hands this thread's small slots to the central lists and drops its medium chunk
+void flushThreadCache() noexcept
+{
+	ThreadCache& cache = tCache;
+	{
+		std::lock_guard<std::mutex> lock{centralMutex};
+		for ( std::size_t c = 0; c < nSmallClasses; ++c )
+		{
+			// the unused tail of the class's chunk becomes free slots too
+			const std::size_t slotSize = getSmallSlotSize( c );
+			while ( cache.bump[c] != nullptr && cache.bump[c] + slotSize <= cache.bumpEnd[c] )
+			{
+				FreeSlot* pSlot = reinterpret_cast<FreeSlot*>( cache.bump[c] );
+				cache.bump[c] += slotSize;
+				pSlot->pNext = cache.freeLists[c];
+				cache.freeLists[c] = pSlot;
+			}
+			while ( cache.freeLists[c] != nullptr )
+			{
+				FreeSlot* pSlot = cache.freeLists[c];
+				cache.freeLists[c] = pSlot->pNext;
+				pSlot->pNext = centralFreeLists[c];
+				centralFreeLists[c] = pSlot;
+			}
+			cache.bump[c] = nullptr;
+			cache.bumpEnd[c] = nullptr;
+		}
+	}
+	if ( cache.pMediumChunk != nullptr )
+	{
+		releaseMediumChunk( cache.pMediumChunk );
+		cache.pMediumChunk = nullptr;
+	}
+	cache.bDead = true;
+}
+
+struct ThreadCacheReaper final
+{
+	~ThreadCacheReaper() noexcept
+	{
+		flushThreadCache();
+	}
+};
+
+void registerThreadCache() noexcept
+{
+	tCache.bRegistered = true;
+	thread_local ThreadCacheReaper reaper;
+	(void) reaper;
+}
+
+// a block of its own pages; the ChunkHeader sits at the start of the mapping, right below
+//	the block, in the chunkSize bytes `getChunk()` masks the block's address down to
+//	up to chunkSize alignment the mapping starts on a chunkSize boundary and the block follows
+//	the header; beyond it the block is aligned and the header is chunkSize bytes below it
+void* tryAllocateLarge( const std::size_t size,
+	const std::size_t alignment ) noexcept
+{
+	const std::size_t offset = alignment < chunkSize ?
+		alignForward( chunkHeaderSize, alignment ) :
+		chunkSize;
+	const std::size_t regionAlignment = alignment < chunkSize ?
+		chunkSize :
+		alignment;
+	const std::size_t pageSize = getPageSize();
+	if ( size > std::size_t( -1 ) - offset - regionAlignment - pageSize )
+	{
+		return nullptr;
+	}
+	const std::size_t bytes = calcAlignedSize( offset + size,
+		pageSize );
+	unsigned char* pBase = tryMapAligned( bytes,
+		regionAlignment,
+		alignment < chunkSize ? 0 : chunkSize );
+	if ( pBase == nullptr )
+	{
+		return nullptr;
+	}
+	ChunkHeader* pChunk = ::new( pBase ) ChunkHeader;
+	pChunk->kind = ChunkKind::Large;
+	pChunk->pRawBlock = pBase;
+	pChunk->rawSize = bytes;
+	return pBase + offset;
+}
+
+void* tryAllocateSmallSlow( const std::size_t sizeClass ) noexcept
+{
+	ThreadCache& cache = tCache;
+	if ( !cache.bRegistered )
+	{
+		registerThreadCache();
+	}
+	{
+		std::lock_guard<std::mutex> lock{centralMutex};
+		if ( centralFreeLists[sizeClass] != nullptr )
+		{
+			cache.freeLists[sizeClass] = centralFreeLists[sizeClass];
+			centralFreeLists[sizeClass] = nullptr;
+		}
+	}
+	if ( cache.freeLists[sizeClass] == nullptr )
+	{
+		ChunkHeader* pChunk = tryAllocateChunk( ChunkKind::Small,
+			static_cast<std::uint32_t>( sizeClass ) );
+		if ( pChunk == nullptr )
+		{
+			return nullptr;
+		}
+		cache.bump[sizeClass] = reinterpret_cast<unsigned char*>( pChunk ) + chunkHeaderSize;
+		cache.bumpEnd[sizeClass] = reinterpret_cast<unsigned char*>( pChunk ) + chunkSize;
+		void* p = cache.bump[sizeClass];
+		cache.bump[sizeClass] += getSmallSlotSize( sizeClass );
+		return p;
+	}
+	FreeSlot* pSlot = cache.freeLists[sizeClass];
+	cache.freeLists[sizeClass] = pSlot->pNext;
+	return pSlot;
+}
+
+// for a thread whose cache is gone: a slot straight from the central list, refilled with a
+//	whole fresh chunk when empty
+void* tryAllocateSmallCentral( const std::size_t sizeClass ) noexcept
+{
+	std::lock_guard<std::mutex> lock{centralMutex};
+	if ( centralFreeLists[sizeClass] == nullptr )
+	{
+		ChunkHeader* pChunk = tryAllocateChunk( ChunkKind::Small,
+			static_cast<std::uint32_t>( sizeClass ) );
+		if ( pChunk == nullptr )
+		{
+			return nullptr;
+		}
+		const std::size_t slotSize = getSmallSlotSize( sizeClass );
+		unsigned char* pEnd = reinterpret_cast<unsigned char*>( pChunk ) + chunkSize;
+		for ( unsigned char* p = reinterpret_cast<unsigned char*>( pChunk ) + chunkHeaderSize; p + slotSize <= pEnd; p += slotSize )
+		{
+			FreeSlot* pSlot = reinterpret_cast<FreeSlot*>( p );
+			pSlot->pNext = centralFreeLists[sizeClass];
+			centralFreeLists[sizeClass] = pSlot;
+		}
+	}
+	FreeSlot* pSlot = centralFreeLists[sizeClass];
+	centralFreeLists[sizeClass] = pSlot->pNext;
+	return pSlot;
+}
+
+void* tryAllocateSmall( const std::size_t size ) noexcept
+{
+	const std::size_t sizeClass = getSmallClass( size );
+	ThreadCache& cache = tCache;
+	if ( FreeSlot* pSlot = cache.freeLists[sizeClass] )
+	{
+		cache.freeLists[sizeClass] = pSlot->pNext;
+		return pSlot;
+	}
+	const std::size_t slotSize = getSmallSlotSize( sizeClass );
+	if ( cache.bump[sizeClass] != nullptr && cache.bump[sizeClass] + slotSize <= cache.bumpEnd[sizeClass] )
+	{
+		void* p = cache.bump[sizeClass];
+		cache.bump[sizeClass] += slotSize;
+		return p;
+	}
+	return tryAllocateSmallSlow( sizeClass );
+}
+
+void* tryAllocateMedium( const std::size_t size,
+	const std::size_t alignment ) noexcept
+{
+	ThreadCache& cache = tCache;
+	ChunkHeader* pChunk = cache.pMediumChunk;
+	if ( pChunk != nullptr )
+	{
+		std::size_t offset = alignForward( cache.mediumOffset,
+			alignment );
+		if ( offset + size > chunkSize
+			&& pChunk->refs.load( std::memory_order_acquire ) == 1 )
+		{
+			// every block handed out from the chunk is already freed; start over
+			offset = alignForward( chunkHeaderSize,
+				alignment );
+		}
+		if ( offset + size <= chunkSize )
+		{
+			pChunk->refs.fetch_add( 1,
+				std::memory_order_relaxed );
+			cache.mediumOffset = offset + size;
+			return reinterpret_cast<unsigned char*>( pChunk ) + offset;
+		}
+		// retire it; the last free releases it
+		cache.pMediumChunk = nullptr;
+		releaseMediumChunk( pChunk );
+	}
+	if ( !cache.bRegistered )
+	{
+		registerThreadCache();
+	}
+	pChunk = tryAllocateChunk( ChunkKind::Medium,
+		0 );
+	if ( pChunk == nullptr )
+	{
+		return nullptr;
+	}
+	const std::size_t offset = alignForward( chunkHeaderSize,
+		alignment );
+	pChunk->refs.fetch_add( 1,
+		std::memory_order_relaxed );
+	cache.pMediumChunk = pChunk;
+	cache.mediumOffset = offset + size;
+	return reinterpret_cast<unsigned char*>( pChunk ) + offset;
+}
+
+void* tryAllocate( const std::size_t size,
+	const std::size_t alignment ) noexcept
+{
+	if ( tCache.bDead )
+	{
+		// this thread's cache is gone (we're in a late TLS destructor); play it safe, but
+		//	keep every default aligned small block in a Small chunk: a sized delete of one,
+		//	from this or any other thread, frees it as a small slot without a look at its chunk
+		if ( alignment <= defaultAlignment && size <= smallMaxSize )
+		{
+			return tryAllocateSmallCentral( getSmallClass( size ) );
+		}
+		return tryAllocateLarge( size,
+			alignment );
+	}
+	if ( alignment <= defaultAlignment && size <= smallMaxSize )
+	{
+		return tryAllocateSmall( size );
+	}
+	if ( size <= mediumMaxSize && alignment <= mediumMaxAlignment )
+	{
+		return tryAllocateMedium( size,
+			alignment );
+	}
+	return tryAllocateLarge( size,
+		alignment );
+}
+
+void* allocate( const std::size_t size,
+	const std::size_t alignment )
+{
+	for ( ;; )
+	{
+		if ( void* p = tryAllocate( size, alignment ) )
+		{
+			return p;
+		}
+		const std::new_handler handler = std::get_new_handler();
+		if ( handler == nullptr )
+		{
+			throw std::bad_alloc{};
+		}
+		handler();
+	}
+}
+
+void* allocateNoThrow( const std::size_t size,
+	const std::size_t alignment ) noexcept
+{
+	try
+	{
+		return allocate( size,
+			alignment );
+	}
+	catch ( ... )
+	{
+		return nullptr;
+	}
+}
+
+void deallocateSmall( void* p,
+	const std::size_t sizeClass ) noexcept
+{
+	FreeSlot* pSlot = static_cast<FreeSlot*>( p );
+	ThreadCache& cache = tCache;
+	if ( cache.bDead )
+	{
+		std::lock_guard<std::mutex> lock{centralMutex};
+		pSlot->pNext = centralFreeLists[sizeClass];
+		centralFreeLists[sizeClass] = pSlot;
+		return;
+	}
+	pSlot->pNext = cache.freeLists[sizeClass];
+	cache.freeLists[sizeClass] = pSlot;
+}
+
+void deallocate( void* p ) noexcept
+{
+	if ( p == nullptr )
+	{
+		return;
+	}
+	ChunkHeader* pChunk = getChunk( p );
+	switch ( pChunk->kind )
+	{
+	case ChunkKind::Small:
+		deallocateSmall( p,
+			pChunk->sizeClass );
+		break;
+	case ChunkKind::Medium:
+		releaseMediumChunk( pChunk );
+		break;
+	case ChunkKind::Large:
+		unmapPages( pChunk->pRawBlock,
+			pChunk->rawSize );
+		break;
+	}
+}
+
+// the size tells a default aligned small block without touching its chunk header; every
+//	such block is a small slot, even one allocated after its thread's cache was flushed
+void deallocateSized( void* p,
+	const std::size_t size ) noexcept
+{
+	if ( p != nullptr && size <= smallMaxSize )
+	{
+		deallocateSmall( p,
+			getSmallClass( size ) );
+		return;
+	}
+	deallocate( p );
+}
+
+}// namespace
+
+
+void* operator new( std::size_t size )
+{
+	return allocate( size,
+		defaultAlignment );
+}
+
+void* operator new[]( std::size_t size )
+{
+	return allocate( size,
+		defaultAlignment );
+}
+
+void* operator new( std::size_t size,
+	const std::nothrow_t& ) noexcept
+{
+	return allocateNoThrow( size,
+		defaultAlignment );
+}
+
+void* operator new[]( std::size_t size,
+	const std::nothrow_t& ) noexcept
+{
+	return allocateNoThrow( size,
+		defaultAlignment );
+}
+
+void* operator new( std::size_t size,
+	std::align_val_t alignment )
+{
+	return allocate( size,
+		static_cast<std::size_t>( alignment ) );
+}
+
+void* operator new[]( std::size_t size,
+	std::align_val_t alignment )
+{
+	return allocate( size,
+		static_cast<std::size_t>( alignment ) );
+}
+
+void* operator new( std::size_t size,
+	std::align_val_t alignment,
+	const std::nothrow_t& ) noexcept
+{
+	return allocateNoThrow( size,
+		static_cast<std::size_t>( alignment ) );
+}
+
+void* operator new[]( std::size_t size,
+	std::align_val_t alignment,
+	const std::nothrow_t& ) noexcept
+{
+	return allocateNoThrow( size,
+		static_cast<std::size_t>( alignment ) );
+}
+
+void operator delete( void* p ) noexcept
+{
+	deallocate( p );
+}
+
+void operator delete[]( void* p ) noexcept
+{
+	deallocate( p );
+}
+
+void operator delete( void* p,
+	const std::nothrow_t& ) noexcept
+{
+	deallocate( p );
+}
+
+void operator delete[]( void* p,
+	const std::nothrow_t& ) noexcept
+{
+	deallocate( p );
+}
+
+void operator delete( void* p,
+	std::size_t size ) noexcept
+{
+	deallocateSized( p,
+		size );
+}
+
+void operator delete[]( void* p,
+	std::size_t size ) noexcept
+{
+	deallocateSized( p,
+		size );
+}
+
+void operator delete( void* p,
+	std::align_val_t ) noexcept
+{
+	deallocate( p );
+}
+
+void operator delete[]( void* p,
+	std::align_val_t ) noexcept
+{
+	deallocate( p );
+}
+
+void operator delete( void* p,
+	std::align_val_t,
+	const std::nothrow_t& ) noexcept
+{
+	deallocate( p );
+}
+
+void operator delete[]( void* p,
+	std::align_val_t,
+	const std::nothrow_t& ) noexcept
+{
+	deallocate( p );
+}
+
+void operator delete( void* p,
+	std::size_t,
+	std::align_val_t ) noexcept
+{
+	deallocate( p );
+}
+
+void operator delete[]( void* p,
+	std::size_t,
+	std::align_val_t ) noexcept
+{
+	deallocate( p );
+}
@@ -0,0 +1,94 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include "large_block_allocator.h"
+
+
+static constexpr std::size_t kiB = 1024;
+static constexpr std::size_t miB = 1024 * kiB;
+
+static void printStats( const char* name,
+	const LargeBlockHeap& heap )
+{
+	const AllocatorStats stats = heap.getStats();
+	std::cout << name
+		<< ": allocated="
+		<< stats.requestedBytes
+		<< " padding="
+		<< stats.paddingBytes
+		<< " free blocks="
+		<< heap.getFreeBlockCount()
+		<< " ("
+		<< heap.getFreeBlockBytes()
+		<< " bytes) top="
+		<< heap.getTopOffset()
+		<< " committed="
+		<< heap.getCommittedBytes()
+		<< '\n';
+}
+
+int main()
+{
+	std::cout << std::boolalpha << '\n';
+
+	// address space is cheap: reserve far more than the buffers will ever need
+	LargeBlockHeap heap{4096 * miB};
+	printStats( "empty",
+		heap );
+
+	// read buffers of a few sizes, as an I/O layer would
+	std::vector<void*> buffers;
+	for ( std::size_t i = 0; i < 16; ++i )
+	{
+		const std::size_t bytes = ( i % 4 + 1 ) * 64 * kiB;
+		buffers.push_back( heap.allocate( bytes ) );
+		std::memset( buffers.back(),
+			static_cast<int>( i ),
+			bytes );
+	}
+	printStats( "16 buffers",
+		heap );
+
+	// every other one freed leaves holes; none is next to another, so none merge
+	for ( std::size_t i = 0; i < buffers.size(); i += 2 )
+	{
+		heap.deallocate( buffers[i] );
+		buffers[i] = nullptr;
+	}
+	printStats( "every other buffer freed",
+		heap );
+
+	// the holes are 64KB and 192KB: 100KB goes to the lowest 192KB one, and the rest of it
+	//	stays a free block
+	void* pScratch = heap.allocate( 100 * kiB );
+	std::cout << "100KB scratch placed at offset "
+		<< static_cast<char*>( pScratch ) - heap.getStartAddress()
+		<< ", usable size "
+		<< heap.getUsableSize( pScratch )
+		<< '\n';
+	printStats( "scratch allocated",
+		heap );
+
+	// a decode buffer bigger than any hole comes from the top
+	void* pDecode = heap.allocate( 48 * miB );
+	printStats( "48MB decode buffer",
+		heap );
+	heap.deallocate( pDecode );
+	printStats( "decode buffer freed, the top shrinks",
+		heap );
+	// its pages stay committed below `trimThreshold`, ready for the next decode
+	heap.trim();
+	printStats( "trimmed",
+		heap );
+
+	heap.deallocate( pScratch );
+	for ( void* p : buffers )
+	{
+		heap.deallocate( p );
+	}
+	printStats( "all freed",
+		heap );
+
+	return EXIT_SUCCESS;
+}
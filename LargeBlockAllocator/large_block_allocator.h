@@ -0,0 +1,747 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#if defined(_MSC_VER) || defined(_WIN32) || defined(_WIN64)
+#	ifndef NOMINMAX
+#		define NOMINMAX
+#	endif
+#	include <windows.h>
+#else
+#	include <sys/mman.h>
+#	include <unistd.h>
+#endif
+#include "../allocator_stats.h"
+#include "../allocator_utils.h"
+#include "../assertions.h"
+
+
+//======================================================================
+// \class	LargeBlockHeap
+//
+// \brief	variable size blocks of roughly 4KB to 64MB, eg. I/O buffers and decode scratch,
+//				where a linear free list scan is too slow
+//			works inside one reserved range of address space, committed `commitChunk` bytes at a
+//				time as the top of the heap grows; once more than `trimThreshold` committed bytes
+//				lie above the top, all but `commitChunk` of them are decommitted
+//			free blocks below the top are indexed in an intrusive red-black tree ordered by
+//				size, then address: the best fit is the smallest block that fits, the lowest
+//				addressed among equal sizes, found in O(log n)
+//			every block starts with a 64 byte header holding the previous block in memory and
+//				the tree links, so a freed block merges with both free neighbours in O(1)
+//				and a free block that reaches the top is given back to the top
+//			payloads are 64 byte aligned; a remainder below `m_minSplitSize` is not split off
+//			free blocks below the top stay committed
+//			not thread safe
+//======================================================================
+class LargeBlockHeap
+{
+	struct Block final
+	{
+		// the block right before this one in memory
+		Block* pPrevPhys;
+		// block bytes, header included; the lowest bit is set while the block is free
+		std::size_t sizeAndFree;
+		// bytes asked for, while allocated
+		std::size_t requested;
+		// tree links, while free
+		Block* pLeft;
+		Block* pRight;
+		Block* pParent;
+		bool bRed;
+
+		std::size_t getSize() const noexcept
+		{
+			return sizeAndFree & ~std::size_t{1};
+		}
+
+		bool isFree() const noexcept
+		{
+			return ( sizeAndFree & 1 ) != 0;
+		}
+
+		void setSize( const std::size_t size ) noexcept
+		{
+			sizeAndFree = size | ( sizeAndFree & 1 );
+		}
+
+		void setFree( const bool bFree ) noexcept
+		{
+			sizeAndFree = getSize() | static_cast<std::size_t>( bFree );
+		}
+
+		void* getPayload() noexcept
+		{
+			return reinterpret_cast<unsigned char*>( this ) + m_headerSize;
+		}
+
+		Block* getNextPhys() noexcept
+		{
+			return reinterpret_cast<Block*>( reinterpret_cast<unsigned char*>( this ) + getSize() );
+		}
+	};
+
+	static constexpr std::size_t m_alignment = 64;
+	static constexpr std::size_t m_headerSize = 64;
+	// smaller remainders stay with the allocated block; slivers are of no use at these sizes
+	static constexpr std::size_t m_minSplitSize = 4096;
+
+	static_assert( sizeof( Block ) <= m_headerSize,
+		"LargeBlockHeap::Block must fit its header." );
+
+	unsigned char* m_pBase;
+	unsigned char* m_pEnd;
+	// blocks live in [m_pBase, m_pTop); pages are committed in [m_pBase, m_pCommitEnd)
+	unsigned char* m_pTop;
+	unsigned char* m_pCommitEnd;
+	Block* m_pLastBlock;
+	std::size_t m_commitChunk;
+	std::size_t m_trimThreshold;
+	// the tree's leaves and the root's parent; always black
+	Block m_nil;
+	Block* m_pRoot;
+	std::size_t m_freeBlockBytes;
+	std::size_t m_nFreeBlocks;
+	// block bytes of the allocated blocks
+	std::size_t m_usedBytes;
+	std::size_t m_requestedBytes;
+	std::size_t m_nAllocations;
+public:
+	// reserves `reserveBytes` of address space; throws std::bad_alloc if it can't
+	//	the default `trimThreshold` keeps a heap that grows and shrinks by up to one 64MB buffer
+	//	from committing and decommitting on every call
+	explicit LargeBlockHeap( const std::size_t reserveBytes,
+		const std::size_t commitChunk = 1024 * 1024,
+		const std::size_t trimThreshold = 128 * 1024 * 1024 )
+		:
+		m_pBase{nullptr},
+		m_pEnd{nullptr},
+		m_pTop{nullptr},
+		m_pCommitEnd{nullptr},
+		m_pLastBlock{nullptr},
+		m_commitChunk{calcAlignedSize( commitChunk, getPageSize() )},
+		m_trimThreshold{trimThreshold},
+		m_nil{},
+		m_pRoot{&m_nil},
+		m_freeBlockBytes{0},
+		m_nFreeBlocks{0},
+		m_usedBytes{0},
+		m_requestedBytes{0},
+		m_nAllocations{0}
+	{
+		const std::size_t size = calcAlignedSize( reserveBytes,
+			getPageSize() );
+		m_pBase = static_cast<unsigned char*>( reserve( size ) );
+		m_pEnd = m_pBase + size;
+		m_pTop = m_pBase;
+		m_pCommitEnd = m_pBase;
+	}
+
+	~LargeBlockHeap() noexcept
+	{
+		release( m_pBase,
+			m_pEnd - m_pBase );
+	}
+
+	LargeBlockHeap( const LargeBlockHeap& rhs ) = delete;
+	LargeBlockHeap& operator=( const LargeBlockHeap& rhs ) = delete;
+
+	// 64 byte aligned; throws std::bad_alloc if neither a free block nor the reserve fits
+	[[nodiscard]]
+	void* allocate( const std::size_t bytes )
+	{
+		if ( bytes > static_cast<std::size_t>( m_pEnd - m_pBase ) )
+		{
+			throw std::bad_alloc{};
+		}
+		const std::size_t size = calcAlignedSize( bytes,
+			m_alignment ) + m_headerSize;
+		Block* pBlock = findBestFit( size );
+		if ( pBlock != &m_nil )
+		{
+			removeFree( pBlock );
+			pBlock->setFree( false );
+			split( pBlock,
+				size );
+		}
+		else
+		{
+			pBlock = extendTop( size );
+		}
+		pBlock->requested = bytes;
+		m_usedBytes += pBlock->getSize();
+		m_requestedBytes += bytes;
+		++m_nAllocations;
+		return pBlock->getPayload();
+	}
+
+	void deallocate( void* p ) noexcept
+	{
+		if ( p == nullptr )
+		{
+			return;
+		}
+		ASSERT( owns( p ),
+			"Pointer not from this LargeBlockHeap!" );
+		Block* pBlock = getBlock( p );
+		ASSERT( !pBlock->isFree(),
+			"LargeBlockHeap block freed twice!" );
+		m_usedBytes -= pBlock->getSize();
+		m_requestedBytes -= pBlock->requested;
+		--m_nAllocations;
+		pBlock->setFree( true );
+
+		Block* pPrev = pBlock->pPrevPhys;
+		if ( pPrev != nullptr && pPrev->isFree() )
+		{
+			removeFree( pPrev );
+			pPrev->setSize( pPrev->getSize() + pBlock->getSize() );
+			pBlock = pPrev;
+		}
+		Block* pNext = pBlock->getNextPhys();
+		if ( reinterpret_cast<unsigned char*>( pNext ) != m_pTop && pNext->isFree() )
+		{
+			removeFree( pNext );
+			pBlock->setSize( pBlock->getSize() + pNext->getSize() );
+			pNext = pBlock->getNextPhys();
+		}
+
+		if ( reinterpret_cast<unsigned char*>( pNext ) == m_pTop )
+		{
+			// the block before the top is never free, so the top only ever shrinks by one block
+			m_pTop = reinterpret_cast<unsigned char*>( pBlock );
+			m_pLastBlock = pBlock->pPrevPhys;
+			if ( static_cast<std::size_t>( m_pCommitEnd - m_pTop ) > m_trimThreshold )
+			{
+				trim();
+			}
+		}
+		else
+		{
+			pNext->pPrevPhys = pBlock;
+			insertFree( pBlock );
+		}
+	}
+
+	// the payload bytes of the block `p` points to, at least what was asked for
+	std::size_t getUsableSize( const void* p ) const noexcept
+	{
+		return getBlock( p )->getSize() - m_headerSize;
+	}
+
+	// frees everything at once and decommits all but `commitChunk` bytes, as `trim()`
+	void reset() noexcept
+	{
+		m_pTop = m_pBase;
+		m_pLastBlock = nullptr;
+		m_pRoot = &m_nil;
+		m_freeBlockBytes = 0;
+		m_nFreeBlocks = 0;
+		m_usedBytes = 0;
+		m_requestedBytes = 0;
+		m_nAllocations = 0;
+		trim();
+	}
+
+	// decommits the pages above the top but `commitChunk` bytes, whatever `trimThreshold` is
+	void trim() noexcept
+	{
+		unsigned char* pKeep = m_pBase + calcAlignedSize( m_pTop - m_pBase,
+			getPageSize() ) + m_commitChunk;
+		if ( pKeep < m_pCommitEnd )
+		{
+			decommit( pKeep,
+				m_pCommitEnd - pKeep );
+			m_pCommitEnd = pKeep;
+		}
+	}
+
+	// the reserve above the top counts as free memory and as a free block,
+	//	as it can still be handed out in one piece
+	AllocatorStats getStats() const noexcept
+	{
+		AllocatorStats stats;
+		stats.requestedBytes = m_requestedBytes;
+		stats.headerBytes = m_nAllocations * m_headerSize;
+		stats.paddingBytes = m_usedBytes - m_requestedBytes - stats.headerBytes;
+		stats.freeBytes = getReservedBytes() - m_usedBytes;
+		std::size_t largestFreeBlock = static_cast<std::size_t>( m_pEnd - m_pTop );
+		if ( m_pRoot != &m_nil && getMaximum( m_pRoot )->getSize() > largestFreeBlock )
+		{
+			largestFreeBlock = getMaximum( m_pRoot )->getSize();
+		}
+		stats.largestFreeBlock = largestFreeBlock > m_headerSize ?
+			largestFreeBlock - m_headerSize :
+			0;
+		stats.totalBytes = getReservedBytes();
+		return stats;
+	}
+
+	bool owns( const void* p ) const noexcept
+	{
+		const std::size_t address = reinterpret_cast<std::size_t>( p );
+		return address >= reinterpret_cast<std::size_t>( m_pBase )
+			&& address < reinterpret_cast<std::size_t>( m_pTop );
+	}
+
+	// GETTERS
+	// the free blocks below the top, the holes a best fit has to fill
+	std::size_t getFreeBlockCount() const noexcept
+	{
+		return m_nFreeBlocks;
+	}
+
+	std::size_t getFreeBlockBytes() const noexcept
+	{
+		return m_freeBlockBytes;
+	}
+
+	// the high water mark of the blocks, from the start of the reserve
+	std::size_t getTopOffset() const noexcept
+	{
+		return m_pTop - m_pBase;
+	}
+
+	std::size_t getCommittedBytes() const noexcept
+	{
+		return m_pCommitEnd - m_pBase;
+	}
+
+	std::size_t getReservedBytes() const noexcept
+	{
+		return m_pEnd - m_pBase;
+	}
+
+	char* getStartAddress() const noexcept
+	{
+		return reinterpret_cast<char*>( m_pBase );
+	}
+
+	static constexpr std::size_t getAlignment() noexcept
+	{
+		return m_alignment;
+	}
+
+	static constexpr std::size_t getHeaderSize() noexcept
+	{
+		return m_headerSize;
+	}
+
+	static std::size_t getPageSize() noexcept
+	{
+#if defined(_MSC_VER) || defined(_WIN32) || defined(_WIN64)
+		SYSTEM_INFO info;
+		GetSystemInfo( &info );
+		return info.dwPageSize;
+#else
+		return static_cast<std::size_t>( sysconf( _SC_PAGESIZE ) );
+#endif
+	}
+private:
+	static void* reserve( const std::size_t bytes )
+	{
+#if defined(_MSC_VER) || defined(_WIN32) || defined(_WIN64)
+		void* p = VirtualAlloc( nullptr,
+			bytes,
+			MEM_RESERVE,
+			PAGE_NOACCESS );
+		if ( p == nullptr )
+		{
+			throw std::bad_alloc{};
+		}
+#else
+		void* p = mmap( nullptr,
+			bytes,
+			PROT_NONE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+			-1,
+			0 );
+		if ( p == MAP_FAILED )
+		{
+			throw std::bad_alloc{};
+		}
+#endif
+		return p;
+	}
+
+	static void commit( void* p,
+		const std::size_t bytes )
+	{
+#if defined(_MSC_VER) || defined(_WIN32) || defined(_WIN64)
+		if ( VirtualAlloc( p, bytes, MEM_COMMIT, PAGE_READWRITE ) == nullptr )
+		{
+			throw std::bad_alloc{};
+		}
+#else
+		if ( mprotect( p, bytes, PROT_READ | PROT_WRITE ) != 0 )
+		{
+			throw std::bad_alloc{};
+		}
+#endif
+	}
+
+	// the pages go back to the OS; they read as zeros once committed again
+	static void decommit( void* p,
+		const std::size_t bytes ) noexcept
+	{
+#if defined(_MSC_VER) || defined(_WIN32) || defined(_WIN64)
+		VirtualFree( p,
+			bytes,
+			MEM_DECOMMIT );
+#else
+		madvise( p,
+			bytes,
+			MADV_DONTNEED );
+		mprotect( p,
+			bytes,
+			PROT_NONE );
+#endif
+	}
+
+	static void release( void* p,
+		[[maybe_unused]] const std::size_t bytes ) noexcept
+	{
+#if defined(_MSC_VER) || defined(_WIN32) || defined(_WIN64)
+		VirtualFree( p,
+			0,
+			MEM_RELEASE );
+#else
+		munmap( p,
+			bytes );
+#endif
+	}
+
+	static Block* getBlock( const void* p ) noexcept
+	{
+		return reinterpret_cast<Block*>( const_cast<unsigned char*>( static_cast<const unsigned char*>( p ) ) - m_headerSize );
+	}
+
+	// blocks are ordered by size, then by address, so every key is unique
+	static bool isLess( const Block* pLhs,
+		const Block* pRhs ) noexcept
+	{
+		return pLhs->getSize() < pRhs->getSize()
+			|| ( pLhs->getSize() == pRhs->getSize() && pLhs < pRhs );
+	}
+
+	Block* extendTop( const std::size_t size )
+	{
+		if ( size > static_cast<std::size_t>( m_pEnd - m_pTop ) )
+		{
+			throw std::bad_alloc{};
+		}
+		unsigned char* pNewTop = m_pTop + size;
+		if ( pNewTop > m_pCommitEnd )
+		{
+			std::size_t commitBytes = calcAlignedSize( pNewTop - m_pCommitEnd,
+				m_commitChunk );
+			if ( commitBytes > static_cast<std::size_t>( m_pEnd - m_pCommitEnd ) )
+			{
+				commitBytes = m_pEnd - m_pCommitEnd;
+			}
+			commit( m_pCommitEnd,
+				commitBytes );
+			m_pCommitEnd += commitBytes;
+		}
+		Block* pBlock = reinterpret_cast<Block*>( m_pTop );
+		pBlock->pPrevPhys = m_pLastBlock;
+		pBlock->sizeAndFree = size;
+		m_pTop = pNewTop;
+		m_pLastBlock = pBlock;
+		return pBlock;
+	}
+
+	// the allocated `pBlock` keeps `size` bytes; the rest becomes a free block
+	//	its next neighbour is allocated or the top, or the free block would have merged with it
+	void split( Block* pBlock,
+		const std::size_t size ) noexcept
+	{
+		const std::size_t remainder = pBlock->getSize() - size;
+		if ( remainder < m_minSplitSize )
+		{
+			return;
+		}
+		pBlock->setSize( size );
+		Block* pRemainder = pBlock->getNextPhys();
+		pRemainder->pPrevPhys = pBlock;
+		pRemainder->sizeAndFree = remainder | 1;
+		pRemainder->getNextPhys()->pPrevPhys = pRemainder;
+		insertFree( pRemainder );
+	}
+
+	// the smallest free block of at least `size` bytes, or `&m_nil`
+	Block* findBestFit( const std::size_t size ) noexcept
+	{
+		Block* pFit = &m_nil;
+		Block* pNode = m_pRoot;
+		while ( pNode != &m_nil )
+		{
+			if ( pNode->getSize() >= size )
+			{
+				pFit = pNode;
+				pNode = pNode->pLeft;
+			}
+			else
+			{
+				pNode = pNode->pRight;
+			}
+		}
+		return pFit;
+	}
+
+	Block* getMinimum( Block* pNode ) const noexcept
+	{
+		while ( pNode->pLeft != &m_nil )
+		{
+			pNode = pNode->pLeft;
+		}
+		return pNode;
+	}
+
+	Block* getMaximum( Block* pNode ) const noexcept
+	{
+		while ( pNode->pRight != &m_nil )
+		{
+			pNode = pNode->pRight;
+		}
+		return pNode;
+	}
+
+	void rotateLeft( Block* pNode ) noexcept
+	{
+		Block* pChild = pNode->pRight;
+		pNode->pRight = pChild->pLeft;
+		if ( pChild->pLeft != &m_nil )
+		{
+			pChild->pLeft->pParent = pNode;
+		}
+		replaceChild( pNode,
+			pChild );
+		pChild->pLeft = pNode;
+		pNode->pParent = pChild;
+	}
+
+	void rotateRight( Block* pNode ) noexcept
+	{
+		Block* pChild = pNode->pLeft;
+		pNode->pLeft = pChild->pRight;
+		if ( pChild->pRight != &m_nil )
+		{
+			pChild->pRight->pParent = pNode;
+		}
+		replaceChild( pNode,
+			pChild );
+		pChild->pRight = pNode;
+		pNode->pParent = pChild;
+	}
+
+	// puts `pNew` where `pOld` hangs in the tree; `pNew` may be `&m_nil`
+	void replaceChild( Block* pOld,
+		Block* pNew ) noexcept
+	{
+		if ( pOld->pParent == &m_nil )
+		{
+			m_pRoot = pNew;
+		}
+		else if ( pOld == pOld->pParent->pLeft )
+		{
+			pOld->pParent->pLeft = pNew;
+		}
+		else
+		{
+			pOld->pParent->pRight = pNew;
+		}
+		pNew->pParent = pOld->pParent;
+	}
+
+	void insertFree( Block* pBlock ) noexcept
+	{
+		m_freeBlockBytes += pBlock->getSize();
+		++m_nFreeBlocks;
+		Block* pParent = &m_nil;
+		Block* pNode = m_pRoot;
+		while ( pNode != &m_nil )
+		{
+			pParent = pNode;
+			pNode = isLess( pBlock, pNode ) ?
+				pNode->pLeft :
+				pNode->pRight;
+		}
+		pBlock->pParent = pParent;
+		if ( pParent == &m_nil )
+		{
+			m_pRoot = pBlock;
+		}
+		else if ( isLess( pBlock, pParent ) )
+		{
+			pParent->pLeft = pBlock;
+		}
+		else
+		{
+			pParent->pRight = pBlock;
+		}
+		pBlock->pLeft = &m_nil;
+		pBlock->pRight = &m_nil;
+		pBlock->bRed = true;
+
+		// a red node's parent must be black: recolour while the uncle is red, otherwise
+		//	rotate once or twice
+		while ( pBlock->pParent->bRed )
+		{
+			Block* pGrandparent = pBlock->pParent->pParent;
+			if ( pBlock->pParent == pGrandparent->pLeft )
+			{
+				Block* pUncle = pGrandparent->pRight;
+				if ( pUncle->bRed )
+				{
+					pBlock->pParent->bRed = false;
+					pUncle->bRed = false;
+					pGrandparent->bRed = true;
+					pBlock = pGrandparent;
+					continue;
+				}
+				if ( pBlock == pBlock->pParent->pRight )
+				{
+					pBlock = pBlock->pParent;
+					rotateLeft( pBlock );
+				}
+				pBlock->pParent->bRed = false;
+				pGrandparent->bRed = true;
+				rotateRight( pGrandparent );
+			}
+			else
+			{
+				Block* pUncle = pGrandparent->pLeft;
+				if ( pUncle->bRed )
+				{
+					pBlock->pParent->bRed = false;
+					pUncle->bRed = false;
+					pGrandparent->bRed = true;
+					pBlock = pGrandparent;
+					continue;
+				}
+				if ( pBlock == pBlock->pParent->pLeft )
+				{
+					pBlock = pBlock->pParent;
+					rotateRight( pBlock );
+				}
+				pBlock->pParent->bRed = false;
+				pGrandparent->bRed = true;
+				rotateLeft( pGrandparent );
+			}
+		}
+		m_pRoot->bRed = false;
+	}
+
+	void removeFree( Block* pBlock ) noexcept
+	{
+		m_freeBlockBytes -= pBlock->getSize();
+		--m_nFreeBlocks;
+		// `pFixup` takes the place of the node that's gone; if that was black, one path
+		//	is a black node short
+		Block* pFixup;
+		bool bRemovedRed = pBlock->bRed;
+		if ( pBlock->pLeft == &m_nil )
+		{
+			pFixup = pBlock->pRight;
+			replaceChild( pBlock,
+				pBlock->pRight );
+		}
+		else if ( pBlock->pRight == &m_nil )
+		{
+			pFixup = pBlock->pLeft;
+			replaceChild( pBlock,
+				pBlock->pLeft );
+		}
+		else
+		{
+			// two children: the successor takes its place
+			Block* pSuccessor = getMinimum( pBlock->pRight );
+			bRemovedRed = pSuccessor->bRed;
+			pFixup = pSuccessor->pRight;
+			if ( pSuccessor->pParent == pBlock )
+			{
+				pFixup->pParent = pSuccessor;
+			}
+			else
+			{
+				replaceChild( pSuccessor,
+					pSuccessor->pRight );
+				pSuccessor->pRight = pBlock->pRight;
+				pSuccessor->pRight->pParent = pSuccessor;
+			}
+			replaceChild( pBlock,
+				pSuccessor );
+			pSuccessor->pLeft = pBlock->pLeft;
+			pSuccessor->pLeft->pParent = pSuccessor;
+			pSuccessor->bRed = pBlock->bRed;
+		}
+		if ( bRemovedRed )
+		{
+			return;
+		}
+
+		while ( pFixup != m_pRoot && !pFixup->bRed )
+		{
+			if ( pFixup == pFixup->pParent->pLeft )
+			{
+				Block* pSibling = pFixup->pParent->pRight;
+				if ( pSibling->bRed )
+				{
+					pSibling->bRed = false;
+					pFixup->pParent->bRed = true;
+					rotateLeft( pFixup->pParent );
+					pSibling = pFixup->pParent->pRight;
+				}
+				if ( !pSibling->pLeft->bRed && !pSibling->pRight->bRed )
+				{
+					pSibling->bRed = true;
+					pFixup = pFixup->pParent;
+					continue;
+				}
+				if ( !pSibling->pRight->bRed )
+				{
+					pSibling->pLeft->bRed = false;
+					pSibling->bRed = true;
+					rotateRight( pSibling );
+					pSibling = pFixup->pParent->pRight;
+				}
+				pSibling->bRed = pFixup->pParent->bRed;
+				pFixup->pParent->bRed = false;
+				pSibling->pRight->bRed = false;
+				rotateLeft( pFixup->pParent );
+			}
+			else
+			{
+				Block* pSibling = pFixup->pParent->pLeft;
+				if ( pSibling->bRed )
+				{
+					pSibling->bRed = false;
+					pFixup->pParent->bRed = true;
+					rotateRight( pFixup->pParent );
+					pSibling = pFixup->pParent->pLeft;
+				}
+				if ( !pSibling->pLeft->bRed && !pSibling->pRight->bRed )
+				{
+					pSibling->bRed = true;
+					pFixup = pFixup->pParent;
+					continue;
+				}
+				if ( !pSibling->pLeft->bRed )
+				{
+					pSibling->pRight->bRed = false;
+					pSibling->bRed = true;
+					rotateLeft( pSibling );
+					pSibling = pFixup->pParent->pLeft;
+				}
+				pSibling->bRed = pFixup->pParent->bRed;
+				pFixup->pParent->bRed = false;
+				pSibling->pLeft->bRed = false;
+				rotateRight( pFixup->pParent );
+			}
+			pFixup = m_pRoot;
+		}
+		pFixup->bRed = false;
+	}
+};
@@ -0,0 +1,229 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <thread>
+#include "linear_allocator.h"
+
+
+//======================================================================
+// \class	EpochArenas
+//
+// \brief	epoch based reclamation with an arena per epoch instead of a free per object
+//			for read-mostly data such as configuration or routing tables, replaced as a whole
+//				copy-on-write style: readers follow a published pointer without locks, and
+//				the writer builds every new version in a fresh arena
+//			writer: `advance()` to a new epoch, build the new version from `getArena()` or
+//				`getAllocator<T>()`, then publish it with an atomic pointer store; each epoch's
+//				arena holds the version of that epoch, copied forward, not patched in place
+//			readers: `registerReader()` once per thread for a slot, then wrap every access in
+//				`ReadGuard guard = read( slot );`, which is a store to the slot on entry and
+//				one on exit; pointers loaded inside the guard are valid until it ends
+//			a reader that entered at epoch e may hold the version of e or e - 1, so advancing
+//				from E to E + 1 is allowed once no reader is inside an epoch before E; the
+//				arena of E + 1 held version E + 1 - `nEpochs`, which is then unreachable and
+//				is reset in O(1); with 3 epochs a writer only waits for readers that are still
+//				on the previous version
+//			destructors of what's in a recycled arena are not run: store trivially destructible
+//				data, or containers whose allocator is the arena's
+//			`advance()`/`tryAdvance()` must be called by one thread at a time; allocating
+//				from the current arena is thread safe
+//======================================================================
+template<std::size_t alignment = alignof( std::max_align_t ), std::size_t nEpochs = 3>
+class EpochArenas
+{
+	static_assert( nEpochs >= 3,
+		"Readers may hold the current and the previous version, so a third epoch is needed to advance." );
+
+	using TArena = ConcurrentArena<alignment>;
+
+	// the epoch a reader entered at, or `m_quiescent` outside of a read
+	struct alignas( cacheLineSize ) ReaderSlot final
+	{
+		std::atomic<std::uint64_t> epoch{m_quiescent};
+		std::atomic<bool> bInUse{false};
+	};
+
+	static constexpr std::uint64_t m_quiescent = ~std::uint64_t{0};
+
+	// `TArena` has no default constructor and isn't copyable, so the arenas are built in place
+	alignas( TArena ) unsigned char m_arenaStorage[nEpochs][sizeof( TArena )];
+	std::unique_ptr<ReaderSlot[]> m_pReaders;
+	std::size_t m_maxReaders;
+	alignas( cacheLineSize ) std::atomic<std::uint64_t> m_epoch;
+public:
+	//======================================================================
+	// \class	ReadGuard
+	//
+	// \brief	marks its reader slot as inside the epoch it started in, until destruction
+	//======================================================================
+	class ReadGuard final
+	{
+		ReaderSlot* m_pSlot;
+	public:
+		explicit ReadGuard( ReaderSlot* pSlot ) noexcept
+			:
+			m_pSlot{pSlot}
+		{
+
+		}
+
+		~ReadGuard() noexcept
+		{
+			if ( m_pSlot != nullptr )
+			{
+				m_pSlot->epoch.store( m_quiescent,
+					std::memory_order_release );
+			}
+		}
+
+		ReadGuard( const ReadGuard& rhs ) = delete;
+		ReadGuard& operator=( const ReadGuard& rhs ) = delete;
+
+		ReadGuard( ReadGuard&& rhs ) noexcept
+			:
+			m_pSlot{rhs.m_pSlot}
+		{
+			rhs.m_pSlot = nullptr;
+		}
+
+		ReadGuard& operator=( ReadGuard&& rhs ) = delete;
+	};
+
+	// `arenaSize` bytes per epoch; up to `maxReaders` threads registered at a time
+	EpochArenas( const std::size_t arenaSize,
+		const std::size_t maxReaders )
+		:
+		m_pReaders{std::make_unique<ReaderSlot[]>( maxReaders )},
+		m_maxReaders{maxReaders},
+		m_epoch{0}
+	{
+		std::size_t nConstructed = 0;
+		try
+		{
+			for ( ; nConstructed < nEpochs; ++nConstructed )
+			{
+				::new( static_cast<void*>( m_arenaStorage[nConstructed] ) ) TArena{arenaSize};
+			}
+		}
+		catch ( ... )
+		{
+			while ( nConstructed != 0 )
+			{
+				getArena( --nConstructed ).~TArena();
+			}
+			throw;
+		}
+	}
+
+	~EpochArenas() noexcept
+	{
+		for ( std::size_t i = 0; i < nEpochs; ++i )
+		{
+			getArena( i ).~TArena();
+		}
+	}
+
+	EpochArenas( const EpochArenas& rhs ) = delete;
+	EpochArenas& operator=( const EpochArenas& rhs ) = delete;
+
+	// claims a reader slot for the calling thread; throws std::bad_alloc if all are taken
+	std::size_t registerReader()
+	{
+		for ( std::size_t slot = 0; slot < m_maxReaders; ++slot )
+		{
+			bool bInUse = false;
+			if ( m_pReaders[slot].bInUse.compare_exchange_strong( bInUse,
+				true,
+				std::memory_order_acquire ) )
+			{
+				return slot;
+			}
+		}
+		throw std::bad_alloc{};
+	}
+
+	void unregisterReader( const std::size_t slot ) noexcept
+	{
+		ASSERT( slot < m_maxReaders && m_pReaders[slot].epoch.load( std::memory_order_relaxed ) == m_quiescent,
+			"Reader slot unregistered inside a read!" );
+		m_pReaders[slot].bInUse.store( false,
+			std::memory_order_release );
+	}
+
+	// enters the current epoch; the published pointers may be loaded until the guard ends
+	//	the store has to be visible to the writer before those loads happen, hence seq_cst
+	[[nodiscard]]
+	ReadGuard read( const std::size_t slot ) noexcept
+	{
+		ASSERT( slot < m_maxReaders && m_pReaders[slot].bInUse.load( std::memory_order_relaxed ),
+			"Reading through an unregistered slot!" );
+		ReaderSlot& reader = m_pReaders[slot];
+		reader.epoch.store( m_epoch.load( std::memory_order_relaxed ),
+			std::memory_order_seq_cst );
+		return ReadGuard{&reader};
+	}
+
+	// moves to the next epoch and resets its arena, unless a reader is still inside an epoch
+	//	before the current one
+	bool tryAdvance() noexcept
+	{
+		const std::uint64_t epoch = m_epoch.load( std::memory_order_relaxed );
+		for ( std::size_t slot = 0; slot < m_maxReaders; ++slot )
+		{
+			const std::uint64_t readerEpoch = m_pReaders[slot].epoch.load( std::memory_order_seq_cst );
+			if ( readerEpoch != m_quiescent && readerEpoch < epoch )
+			{
+				return false;
+			}
+		}
+		getArena( ( epoch + 1 ) % nEpochs ).reset();
+		m_epoch.store( epoch + 1,
+			std::memory_order_seq_cst );
+		return true;
+	}
+
+	// `tryAdvance()` until it succeeds, yielding to the readers in between
+	void advance() noexcept
+	{
+		while ( !tryAdvance() )
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	// the arena new versions are built in
+	TArena& getArena() noexcept
+	{
+		return getArena( m_epoch.load( std::memory_order_relaxed ) % nEpochs );
+	}
+
+	template<typename T>
+	ConcurrentLinearAllocator<T, alignment> getAllocator() noexcept
+	{
+		return ConcurrentLinearAllocator<T, alignment>{&getArena()};
+	}
+
+	std::uint64_t getEpoch() const noexcept
+	{
+		return m_epoch.load( std::memory_order_relaxed );
+	}
+
+	std::size_t getMaxReaders() const noexcept
+	{
+		return m_maxReaders;
+	}
+
+	static constexpr std::size_t getEpochCount() noexcept
+	{
+		return nEpochs;
+	}
+private:
+	TArena& getArena( const std::size_t index ) noexcept
+	{
+		return *std::launder( reinterpret_cast<TArena*>( m_arenaStorage[index] ) );
+	}
+};
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "linear_allocator.h"
+
+
+//======================================================================
+// \class	FrameAllocator
+//
+// \brief	memory that lives for exactly `nFrames` frames, eg. render or simulation data
+//				handed from one frame to the next
+//			rotates `nFrames` arenas, an `Arena` or `SArena` each; `beginFrame()` resets the
+//				oldest and makes it current, so what was allocated in frame f is reclaimed when
+//				frame f + `nFrames` begins; nothing is freed individually
+//			`create()` returns a `Ptr`, which in debug builds remembers its frame and asserts
+//				on every access once that frame's arena has been reset; in release it's a
+//				plain pointer; debug builds also overwrite a reset arena with 0xDD, so stale
+//				raw pointers read garbage instead of what looks like valid data
+//			destructors are not run, so `create()` only takes trivially destructible types
+//			not thread safe
+//======================================================================
+template<std::size_t nFrames = 2, typename TArena = Arena<>>
+class FrameAllocator
+{
+	static_assert( nFrames >= 1,
+		"FrameAllocator needs at least one frame." );
+
+	std::array<TArena, nFrames> m_arenas;
+	std::uint64_t m_frame;
+public:
+	//======================================================================
+	// \class	Ptr
+	//
+	// \brief	a pointer to frame memory, checked against its frame in debug builds
+	//======================================================================
+	template<typename T>
+	class Ptr final
+	{
+		T* m_p;
+#if defined _DEBUG && !defined NDEBUG
+		const FrameAllocator* m_pFrameAllocator;
+		std::uint64_t m_frame;
+#endif // _DEBUG
+	public:
+		Ptr() noexcept
+			:
+			m_p{nullptr}
+#if defined _DEBUG && !defined NDEBUG
+			,
+			m_pFrameAllocator{nullptr},
+			m_frame{0}
+#endif // _DEBUG
+		{
+
+		}
+
+		Ptr( T* p,
+			[[maybe_unused]] const FrameAllocator* pFrameAllocator ) noexcept
+			:
+			m_p{p}
+#if defined _DEBUG && !defined NDEBUG
+			,
+			m_pFrameAllocator{pFrameAllocator},
+			m_frame{pFrameAllocator->getFrame()}
+#endif // _DEBUG
+		{
+
+		}
+
+		T* get() const noexcept
+		{
+#if defined _DEBUG && !defined NDEBUG
+			ASSERT( m_p == nullptr || m_pFrameAllocator->isLive( m_frame ),
+				"Pointer used after its frame was reset!" );
+#endif // _DEBUG
+			return m_p;
+		}
+
+		T& operator*() const noexcept
+		{
+			return *get();
+		}
+
+		T* operator->() const noexcept
+		{
+			return get();
+		}
+
+		explicit operator bool() const noexcept
+		{
+			return m_p != nullptr;
+		}
+	};
+
+	// `bytesPerFrame` for each of the `nFrames` arenas
+	explicit FrameAllocator( const std::size_t bytesPerFrame )
+		:
+		m_arenas{makeArenas( bytesPerFrame,
+			std::make_index_sequence<nFrames>{} )},
+		m_frame{0}
+	{
+
+	}
+
+	FrameAllocator( const FrameAllocator& rhs ) = delete;
+	FrameAllocator& operator=( const FrameAllocator& rhs ) = delete;
+
+	// starts the next frame, reclaiming everything from `nFrames` frames ago
+	void beginFrame() noexcept
+	{
+		++m_frame;
+		TArena& arena = getArena();
+#if defined _DEBUG && !defined NDEBUG
+		const AllocatorStats stats = arena.getStats();
+		// clamped, so an arena whose offset ran past its end can't take the fill with it
+		std::memset( arena.getStartAddress(),
+			0xDD,
+			std::min( stats.totalBytes - stats.freeBytes,
+				stats.totalBytes ) );
+#endif // _DEBUG
+		arena.reset();
+	}
+
+	// throws std::bad_alloc if the current frame's arena is full
+	[[nodiscard]]
+	void* allocate( const std::size_t bytes )
+	{
+		return getArena().allocate( bytes );
+	}
+
+	template<typename T, typename... TArgs>
+	Ptr<T> create( TArgs&&... args )
+	{
+		static_assert( std::is_trivially_destructible_v<T>,
+			"Frame memory is reset without running destructors." );
+		static_assert( alignof( T ) <= TArena::getAlignment(),
+			"T is over-aligned for this FrameAllocator's arenas." );
+		void* p = allocate( sizeof( T ) );
+		return Ptr<T>{::new( p ) T( std::forward<TArgs>( args )... ),
+			this};
+	}
+
+	// `count` default initialized elements
+	template<typename T>
+	Ptr<T> createArray( const std::size_t count )
+	{
+		static_assert( std::is_trivially_destructible_v<T>,
+			"Frame memory is reset without running destructors." );
+		static_assert( alignof( T ) <= TArena::getAlignment(),
+			"T is over-aligned for this FrameAllocator's arenas." );
+		T* p = static_cast<T*>( allocate( sizeof( T ) * count ) );
+		for ( std::size_t i = 0; i < count; ++i )
+		{
+			::new( static_cast<void*>( p + i ) ) T;
+		}
+		return Ptr<T>{p,
+			this};
+	}
+
+	// whether memory allocated in `frame` is still valid
+	bool isLive( const std::uint64_t frame ) const noexcept
+	{
+		return frame <= m_frame && m_frame - frame < nFrames;
+	}
+
+	std::uint64_t getFrame() const noexcept
+	{
+		return m_frame;
+	}
+
+	// the current frame's arena
+	TArena& getArena() noexcept
+	{
+		return m_arenas[m_frame % nFrames];
+	}
+
+	const TArena& getArena() const noexcept
+	{
+		return m_arenas[m_frame % nFrames];
+	}
+
+	// the current frame's usage
+	AllocatorStats getStats() const noexcept
+	{
+		return getArena().getStats();
+	}
+
+	static constexpr std::size_t getFrameCount() noexcept
+	{
+		return nFrames;
+	}
+private:
+	template<std::size_t... indices>
+	static std::array<TArena, nFrames> makeArenas( const std::size_t bytesPerFrame,
+		std::index_sequence<indices...> )
+	{
+		return {{makeArena( bytesPerFrame, indices )...}};
+	}
+
+	// arenas are neither default constructible nor copyable; a prvalue per element is built in place
+	static TArena makeArena( const std::size_t bytesPerFrame,
+		std::size_t )
+	{
+		return TArena{bytesPerFrame};
+	}
+};
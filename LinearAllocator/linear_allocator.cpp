@@ -1,16 +1,72 @@
 #include <algorithm>
+#include <atomic>
 #include <deque>
+#include <iostream>
 #include <map>
 #include <scoped_allocator>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 #include "linear_allocator.h"
+#include "epoch_arenas.h"
+#include "frame_allocator.h"
+#include "../ObjectPool/object_pool.h"
+#include "../StackAllocator/stack_allocator.h"
 
 
+struct Route final
+{
+	int prefix;
+	int port;
+	int version;
+};
+
+struct Particle final
+{
+	float x;
+	float velocity;
+};
+
+// one version of a read-mostly table, built whole in an epoch's arena
+struct RoutingTable final
+{
+	const Route* pRoutes;
+	int nRoutes;
+	int version;
+};
+
 template<typename T, std::size_t TAlignment = alignof( std::max_align_t )>
 using SA = std::scoped_allocator_adaptor<LinearAllocator<T, TAlignment>>;
 
+static void printBudget( const MemoryBudget& budget,
+	const int depth = 0 )
+{
+	std::cout << std::string( 2 * depth, ' ' )
+		<< budget.getName()
+		<< ": usage="
+		<< budget.getUsage()
+		<< " peak="
+		<< budget.getPeak()
+		<< " limit=";
+	if ( budget.getLimit() == MemoryBudget::unlimited )
+	{
+		std::cout << "none";
+	}
+	else
+	{
+		std::cout << budget.getLimit();
+	}
+	std::cout << " failed charges="
+		<< budget.getFailedCharges()
+		<< '\n';
+	for ( const MemoryBudget* pChild = budget.getFirstChild(); pChild != nullptr; pChild = pChild->getNextSibling() )
+	{
+		printBudget( *pChild,
+			depth + 1 );
+	}
+}
+
 int main()
 {
 	std::cout << std::boolalpha << '\n';
@@ -70,7 +126,7 @@ int main()
 	}
 
 
-	Arena arena3{1024};
+	Arena arena3{4096};
 	LinearAllocator<void> la3{&arena3};
 	std::cout << la3.getAvailableMemory() << '\n';
 	LinearAllocator<void> la4 = std::move(la3);
@@ -110,6 +166,49 @@ int main()
 		<< '\n';
 
 
+	std::cout << "Nested containers" << '\n';
+	// the outer allocator reaches every string and vector of the tree, whatever allocator the
+	//	inserted values came with, so the whole tree is freed by resetting one arena
+	using nstring = std::basic_string<char, std::char_traits<char>, SA<char>>;
+	using nvector = std::vector<nstring, SA<nstring>>;
+	using ntree = std::map<nstring, nvector, std::less<>, SA<std::pair<const nstring, nvector>>>;
+	Arena treeArena{8192};
+	Arena otherArena{8192};
+	LinearAllocator<void> treeAlloc{&treeArena};
+	LinearAllocator<void> otherAlloc{&otherArena};
+	const auto isInArena = []( const ntree& tree, const Arena<>& arena )
+	{
+		return std::all_of( tree.begin(),
+			tree.end(),
+			[&arena]( const auto& node )
+			{
+				return arena.owns( node.first.data() )
+					&& arena.owns( node.second.data() )
+					&& std::all_of( node.second.begin(),
+						node.second.end(),
+						[&arena]( const nstring& s )
+						{
+							return arena.owns( s.data() );
+						} );
+			} );
+	};
+	ntree tree{treeAlloc};
+	for ( int i = 0; i < 4; ++i )
+	{
+		nvector& values = tree[nstring{"a key long enough to be on the heap " + std::to_string( i ), otherAlloc}];
+		values.emplace_back( "emplaced from a literal, too long for the small string buffer" );
+		values.push_back( nstring{"pushed, allocated on the other arena at first", otherAlloc} );
+	}
+	std::cout << "tree in its arena: "
+		<< isInArena( tree, treeArena )
+		<< '\n';
+	// the allocators don't propagate on assignment: the copy stays on the target's arena
+	ntree copy{otherAlloc};
+	copy = tree;
+	std::cout << "copy in its arena: "
+		<< isInArena( copy, otherArena )
+		<< '\n';
+
 	std::cout << "Individual allocations" << '\n';
 	Arena<256> arena4{1024};
 	LinearAllocator<int, 256> la6{&arena4};
@@ -122,6 +221,11 @@ int main()
 	*pint = 1453;
 	std::cout << *pint << '\n';
 	std::cout << "isAligned(pint, 256)=" << isAligned( pint, 256 ) << '\n';
+	const AllocatorStats stats = arena4.getStats();
+	std::cout << "requested=" << stats.requestedBytes
+		<< " padding=" << stats.paddingBytes
+		<< " internal fragmentation=" << stats.getInternalFragmentation()
+		<< '\n';
 
 
 
@@ -234,6 +338,177 @@ int main()
 			<< '\n';
 	}
 
+	std::cout << "Concurrent arena" << '\n';
+	// four threads fill their own vectors from one arena; each allocation is one fetch_add
+	ConcurrentArena<16> sharedArena{64 * 1024};
+	std::vector<std::thread> workers;
+	for ( int t = 0; t < 4; ++t )
+	{
+		workers.emplace_back( [&sharedArena, t]
+			{
+				std::vector<int, ConcurrentLinearAllocator<int, 16>> values{ConcurrentLinearAllocator<int, 16>{&sharedArena}};
+				values.reserve( 1000 );
+				for ( int i = 0; i < 1000; ++i )
+				{
+					values.push_back( t * 1000 + i );
+				}
+			} );
+	}
+	for ( std::thread& worker : workers )
+	{
+		worker.join();
+	}
+	std::cout << "shared arena offset="
+		<< sharedArena.getOffset()
+		<< '\n';
+
+	std::cout << "Frame allocator" << '\n';
+	// each frame's particles are computed from the previous frame's, which stay valid for 2 frames
+	FrameAllocator<2> frames{4 * 1024};
+	constexpr std::size_t nParticles = 100;
+	FrameAllocator<2>::Ptr<Particle> pPrevious = frames.createArray<Particle>( nParticles );
+	for ( std::size_t i = 0; i < nParticles; ++i )
+	{
+		pPrevious.get()[i] = Particle{0.0f, static_cast<float>( i )};
+	}
+	for ( int frame = 0; frame < 60; ++frame )
+	{
+		frames.beginFrame();
+		FrameAllocator<2>::Ptr<Particle> pCurrent = frames.createArray<Particle>( nParticles );
+		for ( std::size_t i = 0; i < nParticles; ++i )
+		{
+			const Particle& previous = pPrevious.get()[i];
+			pCurrent.get()[i] = Particle{previous.x + previous.velocity / 60.0f, previous.velocity};
+		}
+		pPrevious = pCurrent;
+	}
+	std::cout << "frame="
+		<< frames.getFrame()
+		<< " particle[10].x="
+		<< pPrevious.get()[10].x
+		<< " frame bytes="
+		<< frames.getStats().requestedBytes
+		<< '\n';
+
+	// a frame whose allocation didn't fit is still reset and rotated as usual
+	FrameAllocator<2, SArena<>> smallFrames{256};
+	try
+	{
+		(void) smallFrames.allocate( 1000 );
+	}
+	catch ( const std::bad_alloc& )
+	{
+		std::cout << "frame allocation of 1000 B failed\n";
+	}
+	smallFrames.beginFrame();
+	smallFrames.beginFrame();
+	std::cout << "after 2 frames: "
+		<< smallFrames.getStats().freeBytes
+		<< " B free\n";
+
+	std::cout << "Epoch arenas" << '\n';
+	// a writer republishes the routing table while readers look routes up without locking
+	EpochArenas<16> epochArenas{16 * 1024, 4};
+	std::atomic<const RoutingTable*> pTable{nullptr};
+	auto publishTable = [&epochArenas, &pTable] ( const int version )
+		{
+			epochArenas.advance();
+			ConcurrentArena<16>& tableArena = epochArenas.getArena();
+			constexpr int nRoutes = 64;
+			Route* pRoutes = static_cast<Route*>( tableArena.allocate( nRoutes * sizeof( Route ) ) );
+			for ( int i = 0; i < nRoutes; ++i )
+			{
+				pRoutes[i] = Route{i * 16, 8000 + ( i + version ) % 100, version};
+			}
+			RoutingTable* pNew = static_cast<RoutingTable*>( tableArena.allocate( sizeof( RoutingTable ) ) );
+			*pNew = RoutingTable{pRoutes, nRoutes, version};
+			pTable.store( pNew,
+				std::memory_order_release );
+		};
+	publishTable( 0 );
+	std::atomic<bool> bDone{false};
+	std::atomic<int> nTornReads{0};
+	std::vector<std::thread> readers;
+	for ( int t = 0; t < 3; ++t )
+	{
+		readers.emplace_back( [&epochArenas, &pTable, &bDone, &nTornReads]
+			{
+				const std::size_t slot = epochArenas.registerReader();
+				while ( !bDone.load( std::memory_order_relaxed ) )
+				{
+					EpochArenas<16>::ReadGuard guard = epochArenas.read( slot );
+					const RoutingTable* pCurrent = pTable.load( std::memory_order_acquire );
+					for ( int i = 0; i < pCurrent->nRoutes; ++i )
+					{
+						if ( pCurrent->pRoutes[i].version != pCurrent->version )
+						{
+							nTornReads.fetch_add( 1,
+								std::memory_order_relaxed );
+						}
+					}
+				}
+				epochArenas.unregisterReader( slot );
+			} );
+	}
+	for ( int version = 1; version <= 100; ++version )
+	{
+		publishTable( version );
+	}
+	bDone.store( true,
+		std::memory_order_relaxed );
+	for ( std::thread& reader : readers )
+	{
+		reader.join();
+	}
+	std::cout << "epoch="
+		<< epochArenas.getEpoch()
+		<< " version="
+		<< pTable.load()->version
+		<< " torn reads="
+		<< nTornReads.load()
+		<< '\n';
+
+	std::cout << "Memory budgets" << '\n';
+	{
+		MemoryBudget game{"game", 64 * 1024};
+		MemoryBudget render{"render", 32 * 1024, &game};
+		MemoryBudget audio{"audio", 16 * 1024, &game};
+		// no limit of its own; the game's still applies
+		MemoryBudget network{"network", MemoryBudget::unlimited, &game};
+
+		Arena<> frameArena{24 * 1024, &render};
+		ObjectPool<Particle> voices{512, &audio};
+		{
+			// render's 32KB can't take another 16KB; the arena is never created
+			try
+			{
+				Arena<> textureArena{16 * 1024, &render};
+			}
+			catch ( const std::bad_alloc& )
+			{
+				std::cout << "render over budget\n";
+			}
+			std::vector<Arena<>> packetArenas;
+			try
+			{
+				for ( ;; )
+				{
+					packetArenas.emplace_back( 8 * 1024,
+						&network );
+				}
+			}
+			catch ( const std::bad_alloc& )
+			{
+				std::cout << "network stopped by the game budget at "
+					<< packetArenas.size()
+					<< " packet arenas\n";
+			}
+			printBudget( game );
+		}
+		// the packet arenas are gone, their peak stays
+		printBudget( game );
+	}
+
 	std::system( "pause" );
 	return 0;
 }
@@ -1,9 +1,13 @@
 #pragma once
 
+#include <atomic>
 #include <cstddef>
-#include <iostream>
+#include <new>
+#include <type_traits>
+#include "../allocator_stats.h"
 #include "../allocator_utils.h"
 #include "../assertions.h"
+#include "../memory_budget.h"
 
 
 //======================================================================
@@ -17,42 +21,39 @@
 //			`allocate()` throws exception if there is no more space in the arena
 //			you can't use the same arena for different types (at least not for different
 //				types that have different alignment requirements).
+//			created against a `MemoryBudget`, its buffer is charged to the budget for its lifetime
 //======================================================================
 template<std::size_t alignment = alignof( std::max_align_t )>
 class Arena
 {
 	inline static constexpr std::size_t m_alignment = alignment;
-	unsigned char* const m_pData;
-	std::size_t const m_maxSize;
+	unsigned char* m_pData;
+	std::size_t m_maxSize;
 	std::size_t m_offset;
+	std::size_t m_requestedBytes;
+	std::size_t m_paddingBytes;
+	MemoryBudget* m_pBudget;
 public:
-	Arena( std::size_t size )
+	// throws std::bad_alloc if `pBudget` (optional) can't take `size` more bytes
+	Arena( std::size_t size,
+		MemoryBudget* pBudget = nullptr )
 		:
-		m_pData{static_cast<unsigned char*>( alignedMalloc( size, m_alignment ) )},
+		m_pData{static_cast<unsigned char*>( budgetedAlignedMalloc<m_alignment>( pBudget, size ) )},
 		m_maxSize{size},
-		m_offset{0}
+		m_offset{0},
+		m_requestedBytes{0},
+		m_paddingBytes{0},
+		m_pBudget{pBudget}
 	{
 		static_assert( isPowerOfTwo( alignment ),
 			"Arena alignment value must be a power of 2." );
-#if defined _DEBUG && !defined NDEBUG
-		std::cout << "arena["
-			<< this
-			<< "] of size "
-			<< size
-			<< " created.\n";
-#endif // _DEBUG
 	}
 
 	~Arena() noexcept
 	{
-#if defined _DEBUG && !defined NDEBUG
-		std::cout << "arena["
-			<< this
-			<< "] destroyed; final offset was: "
-			<< m_offset
-			<< '\n';
-#endif // _DEBUG
-		alignedFree( m_pData );
+		budgetedAlignedFree<m_alignment>( m_pBudget,
+			m_pData,
+			m_maxSize );
 	}
 
 	Arena( const Arena& rhs ) = delete;
@@ -62,9 +63,17 @@ public:
 		:
 		m_pData{rhs.m_pData},
 		m_maxSize{rhs.m_maxSize},
-		m_offset{rhs.m_offset}
+		m_offset{rhs.m_offset},
+		m_requestedBytes{rhs.m_requestedBytes},
+		m_paddingBytes{rhs.m_paddingBytes},
+		m_pBudget{rhs.m_pBudget}
 	{
-
+		rhs.m_pData = nullptr;
+		rhs.m_maxSize = 0;
+		rhs.m_offset = 0;
+		rhs.m_requestedBytes = 0;
+		rhs.m_paddingBytes = 0;
+		rhs.m_pBudget = nullptr;
 	}
 
 	Arena& operator=( Arena&& rhs ) noexcept
@@ -75,31 +84,31 @@ public:
 			rhs.m_maxSize );
 		std::swap( m_offset,
 			rhs.m_offset );
+		std::swap( m_requestedBytes,
+			rhs.m_requestedBytes );
+		std::swap( m_paddingBytes,
+			rhs.m_paddingBytes );
+		std::swap( m_pBudget,
+			rhs.m_pBudget );
 		return *this;
 	}
 
 	[[nodiscard]]
 	void* allocate( std::size_t bytes )
 	{
-		m_offset = alignForward( m_offset,
-			m_alignment );
-		ASSERT( isAligned( m_offset, m_alignment ),
+		const std::size_t alignedOffset = alignForward<m_alignment>( m_offset );
+		ASSERT( isAligned( alignedOffset, m_alignment ),
 			"Not aligned!" );
-		std::size_t currentAllocationStartAddress = getCurrentAddress();
 
 		// check if there is enough memory available
-		if ( m_offset + bytes > m_maxSize )
+		if ( alignedOffset + bytes > m_maxSize )
 		{
 			throw std::bad_alloc{};
 		}
-#if defined _DEBUG && !defined NDEBUG
-		std::cout << "arena["
-			<< this
-			<< "] allocating "
-			<< bytes
-			<< " bytes at offset "
-			<< m_offset << '\n';
-#endif // _DEBUG
+		m_paddingBytes += alignedOffset - m_offset;
+		m_requestedBytes += bytes;
+		m_offset = alignedOffset;
+		std::size_t currentAllocationStartAddress = getCurrentAddress();
 		m_offset += bytes;
 		return reinterpret_cast<void*>( currentAllocationStartAddress );
 	}
@@ -107,20 +116,63 @@ public:
 	// may be called for temporaries, but nothing gets deallocated in an arena ever,
 	//	but the arena itself!
 	void deallocate( void*,
-		std::size_t count )
+		std::size_t ) noexcept
 	{
-#if defined _DEBUG && !defined NDEBUG
-		std::cout << "arena["
-			<< this
-			<< "] may deallocate "
-			<< count
-			<< " bytes.\n";
-#endif // _DEBUG
+
 	}
 
-	constexpr std::size_t getAvailableMemory() const noexcept
+	// resizes the allocation at `p` of `oldSize` bytes to `newSize` bytes without moving it
+	//	only possible for the most recent allocation, which has nothing after it but free space
+	//	shrinking it hands the bytes back to the arena
+	bool tryExpand( void* p,
+		const std::size_t oldSize,
+		const std::size_t newSize ) noexcept
+	{
+		const std::size_t offset = static_cast<std::size_t>( static_cast<unsigned char*>( p ) - m_pData );
+		if ( offset + oldSize != m_offset || newSize > m_maxSize - offset )
+		{
+			return false;
+		}
+		m_offset = offset + newSize;
+		m_requestedBytes = m_requestedBytes - oldSize + newSize;
+		return true;
+	}
+
+	// reset the arena. All existing allocated memory will be lost
+	void reset() noexcept
+	{
+		m_offset = 0;
+		m_requestedBytes = 0;
+		m_paddingBytes = 0;
+	}
+
+	// the largest allocation that can still succeed, after aligning the offset
+	std::size_t getAvailableMemory() const noexcept
+	{
+		const std::size_t alignedOffset = alignForward<m_alignment>( m_offset );
+		return alignedOffset < m_maxSize ?
+			m_maxSize - alignedOffset :
+			0;
+	}
+
+	// nothing is freed individually, so the free memory is always one contiguous block
+	AllocatorStats getStats() const noexcept
 	{
-		return m_maxSize - m_offset;
+		AllocatorStats stats;
+		stats.requestedBytes = m_requestedBytes;
+		stats.paddingBytes = m_paddingBytes;
+		stats.freeBytes = m_maxSize - m_offset;
+		stats.largestFreeBlock = getAvailableMemory();
+		stats.totalBytes = m_maxSize;
+		return stats;
+	}
+
+	// whether `p` points into this arena's memory; lets containers built through nested
+	//	allocators be checked to live entirely in one arena
+	bool owns( const void* p ) const noexcept
+	{
+		const std::size_t address = reinterpret_cast<std::size_t>( p );
+		return address >= reinterpret_cast<std::size_t>( m_pData ) && address < getEndAddress();
 	}
 
 	std::size_t getTotalMemory() const noexcept
@@ -143,7 +195,7 @@ public:
 	// GETTERS
 	char* getStartAddress() const noexcept
 	{
-		return m_pData;
+		return reinterpret_cast<char*>( m_pData );
 	}
 
 	std::size_t getOffset() const noexcept
@@ -160,8 +212,191 @@ public:
 	{
 		return m_alignment;
 	}
+
+	// nullptr if unbudgeted
+	MemoryBudget* getBudget() const noexcept
+	{
+		return m_pBudget;
+	}
 };
 
+
+//======================================================================
+// \class	ConcurrentArena
+//
+// \brief	an `Arena` that any number of threads can allocate from at once
+//			nothing is freed individually, so allocating is only moving the offset forward:
+//				every size is rounded up to the alignment, which keeps every offset aligned,
+//				and a single `fetch_add` hands out the block; no locks, no retries
+//			an allocation that doesn't fit throws std::bad_alloc, and so does every later one
+//				until `reset()`; the offset may overshoot the end meanwhile
+//			`reset()`, moving and destruction must not race with allocations
+//			the offset has a cache line of its own, so the threads only contend on the one
+//				atomic and not on the arena's other members
+//			`getStats()` can't tell the rounding apart from the requested bytes; counting it
+//				would take a second atomic per allocation
+//======================================================================
+template<std::size_t alignment = alignof( std::max_align_t )>
+class ConcurrentArena
+{
+	inline static constexpr std::size_t m_alignment = alignment;
+	unsigned char* m_pData;
+	std::size_t m_maxSize;
+	// the alignment also rounds the arena's size up to whole cache lines, so nothing placed
+	//	after it shares the offset's line either
+	alignas( cacheLineSize ) std::atomic<std::size_t> m_offset;
+public:
+	ConcurrentArena( std::size_t size )
+		:
+		m_pData{static_cast<unsigned char*>( alignedMalloc<m_alignment>( size ) )},
+		m_maxSize{size},
+		m_offset{0}
+	{
+		static_assert( isPowerOfTwo( alignment ),
+			"Arena alignment value must be a power of 2." );
+	}
+
+	~ConcurrentArena() noexcept
+	{
+		alignedFree<m_alignment>( m_pData );
+	}
+
+	ConcurrentArena( const ConcurrentArena& rhs ) = delete;
+	ConcurrentArena& operator=( const ConcurrentArena& rhs ) = delete;
+
+	ConcurrentArena( ConcurrentArena&& rhs ) noexcept
+		:
+		m_pData{rhs.m_pData},
+		m_maxSize{rhs.m_maxSize},
+		m_offset{rhs.m_offset.load( std::memory_order_relaxed )}
+	{
+		rhs.m_pData = nullptr;
+		rhs.m_maxSize = 0;
+		rhs.m_offset.store( 0,
+			std::memory_order_relaxed );
+	}
+
+	ConcurrentArena& operator=( ConcurrentArena&& rhs ) noexcept
+	{
+		std::swap( m_pData,
+			rhs.m_pData );
+		std::swap( m_maxSize,
+			rhs.m_maxSize );
+		const std::size_t offset = m_offset.load( std::memory_order_relaxed );
+		m_offset.store( rhs.m_offset.load( std::memory_order_relaxed ),
+			std::memory_order_relaxed );
+		rhs.m_offset.store( offset,
+			std::memory_order_relaxed );
+		return *this;
+	}
+
+	[[nodiscard]]
+	void* allocate( std::size_t bytes )
+	{
+		// more than the arena holds, and rounding up could wrap to 0
+		if ( bytes > m_maxSize )
+		{
+			throw std::bad_alloc{};
+		}
+		const std::size_t size = alignForward<m_alignment>( bytes );
+		// relaxed: the block is handed to this thread only; publishing what gets written into
+		//	it is up to the caller, as with any allocator
+		const std::size_t offset = m_offset.fetch_add( size,
+			std::memory_order_relaxed );
+		if ( size > m_maxSize || offset > m_maxSize - size )
+		{
+			throw std::bad_alloc{};
+		}
+		return m_pData + offset;
+	}
+
+	// nothing gets deallocated in an arena but the arena itself
+	void deallocate( void*,
+		std::size_t ) noexcept
+	{
+
+	}
+
+	// resizes the allocation at `p` of `oldSize` bytes to `newSize` bytes without moving it
+	//	only possible while it's the latest allocation; another thread's allocation in between
+	//	makes it fail, like with `Arena::tryExpand()`
+	bool tryExpand( void* p,
+		const std::size_t oldSize,
+		const std::size_t newSize ) noexcept
+	{
+		const std::size_t offset = static_cast<std::size_t>( static_cast<unsigned char*>( p ) - m_pData );
+		if ( newSize > m_maxSize - offset )
+		{
+			return false;
+		}
+		const std::size_t newEnd = offset + alignForward<m_alignment>( newSize );
+		if ( newEnd > m_maxSize )
+		{
+			return false;
+		}
+		std::size_t end = offset + alignForward<m_alignment>( oldSize );
+		return m_offset.compare_exchange_strong( end,
+			newEnd,
+			std::memory_order_relaxed );
+	}
+
+	// all existing allocated memory will be lost
+	void reset() noexcept
+	{
+		m_offset.store( 0,
+			std::memory_order_relaxed );
+	}
+
+	std::size_t getAvailableMemory() const noexcept
+	{
+		const std::size_t offset = getOffset();
+		return m_maxSize - offset;
+	}
+
+	// a snapshot; other threads may be allocating
+	AllocatorStats getStats() const noexcept
+	{
+		AllocatorStats stats;
+		stats.requestedBytes = getOffset();
+		stats.freeBytes = getAvailableMemory();
+		stats.largestFreeBlock = stats.freeBytes;
+		stats.totalBytes = m_maxSize;
+		return stats;
+	}
+
+	// whether `p` points into this arena's memory
+	bool owns( const void* p ) const noexcept
+	{
+		const unsigned char* pByte = static_cast<const unsigned char*>( p );
+		return pByte >= m_pData && pByte < m_pData + m_maxSize;
+	}
+
+	char* getStartAddress() const noexcept
+	{
+		return reinterpret_cast<char*>( m_pData );
+	}
+
+	// the bytes handed out so far, capped at the arena's size
+	std::size_t getOffset() const noexcept
+	{
+		const std::size_t offset = m_offset.load( std::memory_order_relaxed );
+		return offset < m_maxSize ?
+			offset :
+			m_maxSize;
+	}
+
+	std::size_t getSize() const noexcept
+	{
+		return m_maxSize;
+	}
+
+	static constexpr std::size_t getAlignment() noexcept
+	{
+		return m_alignment;
+	}
+};
+
+
 //----------------------------------------------------------------------------------------
 // LinearAllocator
 //
@@ -173,11 +408,15 @@ public:
 //			the destructor clears the entire allocated memory chunk
 //				"micro"-deallocations cannot be made
 //			the allocator obtains its memory from an arena
+//			`TArenaTemplate` picks the arena: the single threaded `Arena` by default, or
+//				`ConcurrentArena` to share one arena between threads
 //----------------------------------------------------------------------------------------
-template<typename T, std::size_t alignment = alignof( std::max_align_t )>
+template<typename T,
+	std::size_t alignment = alignof( std::max_align_t ),
+	template<std::size_t> typename TArenaTemplate = Arena>
 class LinearAllocator
 {
-	using TArena = Arena<alignment>;
+	using TArena = TArenaTemplate<alignment>;
 
 	inline static constexpr std::size_t m_alignment = alignment;
 	TArena* m_pArena;
@@ -185,9 +424,15 @@ public:
 	using value_type = T;
 	using pointer = T*;
 
-	//using propagate_on_container_copy_assignment = std::true_type;
-	//using propagate_on_container_move_assignment = std::true_type;
-	//using propagate_on_container_swap = std::true_type;
+	// a container keeps the arena it was constructed with for its whole life, as with
+	//	std::pmr::polymorphic_allocator: assigning from a container on another arena copies or
+	//	moves the elements into this one, so a tree built through std::scoped_allocator_adaptor
+	//	stays in one arena and is freed by resetting it
+	//	swapping containers on different arenas is undefined
+	using propagate_on_container_copy_assignment = std::false_type;
+	using propagate_on_container_move_assignment = std::false_type;
+	using propagate_on_container_swap = std::false_type;
+	using is_always_equal = std::false_type;
 
 	explicit LinearAllocator( TArena* pArena )
 		:
@@ -206,8 +451,9 @@ public:
 
 	}
 
-	template<typename Other, std::size_t OtherAlignment>
-	LinearAllocator( const LinearAllocator<Other, OtherAlignment>& rhs ) noexcept
+	// rebinding keeps the alignment, which is the arena's type
+	template<typename Other>
+	LinearAllocator( const LinearAllocator<Other, alignment, TArenaTemplate>& rhs ) noexcept
 		:
 		m_pArena{rhs.getArena()}
 	{
@@ -220,8 +466,8 @@ public:
 
 	}
 
-	template<typename Other, std::size_t OtherAlignment>
-	LinearAllocator( const LinearAllocator<Other, OtherAlignment>&& rhs ) noexcept
+	template<typename Other>
+	LinearAllocator( const LinearAllocator<Other, alignment, TArenaTemplate>&& rhs ) noexcept
 		:
 		m_pArena{rhs.getArena()}
 	{
@@ -236,12 +482,16 @@ public:
 	template<typename Other, std::size_t OtherAlignment = getAlignment()>
 	struct rebind
 	{
-		using other = LinearAllocator<Other, OtherAlignment>;
+		using other = LinearAllocator<Other, OtherAlignment, TArenaTemplate>;
 	};
 
 	[[nodiscard]]
 	T* allocate( std::size_t count )
 	{
+		if ( count > ~std::size_t{0} / sizeof( T ) )
+		{
+			throw std::bad_alloc{};
+		}
 		return static_cast<T*>( m_pArena->allocate( count * sizeof( T ) ) );
 	}
 
@@ -252,6 +502,17 @@ public:
 			count * sizeof( T ) );
 	}
 
+	// grows or shrinks `p` from `oldCount` to `newCount` elements in place, if it's the arena's
+	//	latest allocation; see `Arena::tryExpand()`
+	bool tryExpand( T* p,
+		const std::size_t oldCount,
+		const std::size_t newCount ) noexcept
+	{
+		return m_pArena->tryExpand( p,
+			oldCount * sizeof( T ),
+			newCount * sizeof( T ) );
+	}
+
 	TArena* getArena() const noexcept
 	{
 		return m_pArena;
@@ -261,18 +522,52 @@ public:
 	{
 		return m_pArena->getAvailableMemory();
 	}
+
+	AllocatorStats getStats() const noexcept
+	{
+		return m_pArena->getStats();
+	}
 };
 
-template<typename T, std::size_t TAlignment, typename Other, std::size_t OtherAlignment>
-inline bool operator==( const LinearAllocator<T, TAlignment>& lhs,
-	const LinearAllocator<Other, OtherAlignment>& rhs ) noexcept
+template<typename T, typename Other, std::size_t TAlignment, template<std::size_t> typename TArenaTemplate>
+inline bool operator==( const LinearAllocator<T, TAlignment, TArenaTemplate>& lhs,
+	const LinearAllocator<Other, TAlignment, TArenaTemplate>& rhs ) noexcept
 {
 	return lhs.getArena() == rhs.getArena();
 }
 
-template<typename T, std::size_t TAlignment, typename Other, std::size_t OtherAlignment>
-inline bool operator!=( const LinearAllocator<T, TAlignment>& lhs,
-	const LinearAllocator<Other, OtherAlignment>& rhs ) noexcept
+template<typename T, typename Other, std::size_t TAlignment, template<std::size_t> typename TArenaTemplate>
+inline bool operator!=( const LinearAllocator<T, TAlignment, TArenaTemplate>& lhs,
+	const LinearAllocator<Other, TAlignment, TArenaTemplate>& rhs ) noexcept
 {
 	return lhs.getArena() != rhs.getArena();
 }
+
+// allocators of different alignments or arena kinds never share an arena
+template<typename T,
+	std::size_t TAlignment,
+	template<std::size_t> typename TArenaTemplate,
+	typename Other,
+	std::size_t OtherAlignment,
+	template<std::size_t> typename TOtherArenaTemplate>
+inline bool operator==( const LinearAllocator<T, TAlignment, TArenaTemplate>&,
+	const LinearAllocator<Other, OtherAlignment, TOtherArenaTemplate>& ) noexcept
+{
+	return false;
+}
+
+template<typename T,
+	std::size_t TAlignment,
+	template<std::size_t> typename TArenaTemplate,
+	typename Other,
+	std::size_t OtherAlignment,
+	template<std::size_t> typename TOtherArenaTemplate>
+inline bool operator!=( const LinearAllocator<T, TAlignment, TArenaTemplate>&,
+	const LinearAllocator<Other, OtherAlignment, TOtherArenaTemplate>& ) noexcept
+{
+	return true;
+}
+
+// a LinearAllocator over a `ConcurrentArena`, for containers on different threads sharing one arena
+template<typename T, std::size_t alignment = alignof( std::max_align_t )>
+using ConcurrentLinearAllocator = LinearAllocator<T, alignment, ConcurrentArena>;
@@ -0,0 +1,71 @@
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory_resource>
+#include <string>
+#include <vector>
+#include "../LinearAllocator/linear_allocator.h"
+#include "memory_resources.h"
+
+
+// one function body for every strategy: pmr containers have the same type whatever their resource
+static void fillContainers( std::pmr::memory_resource* pResource )
+{
+	std::pmr::vector<int> vec{pResource};
+	for ( int i = 0; i < 100; ++i )
+	{
+		vec.push_back( i );
+	}
+
+	std::pmr::map<std::pmr::string, int> map{pResource};
+	map["foo"] = 10;
+	map["fooooooooooooooooooooooooooooooooooooooooo"] = 20;
+	map["Loyal servant to the true emperor, Marcus Aurelius."] = 30;
+
+	for ( const auto& [key, value] : map )
+	{
+		std::cout << key
+			<< ' '
+			<< value
+			<< '\n';
+	}
+}
+
+static void printStats( const char* name,
+	const AllocatorStats& stats )
+{
+	std::cout << name
+		<< ": requested "
+		<< stats.requestedBytes
+		<< " B, free "
+		<< stats.freeBytes
+		<< " B of "
+		<< stats.totalBytes
+		<< " B\n";
+}
+
+int main()
+{
+	// tracking -> arena -> pools -> new/delete
+	PoolResource<16, 64, 256> pools{64};
+	Arena<16> arena{4096};
+	ArenaResource<Arena<16>> arenaResource{&arena, &pools};
+	TrackingResource tracking{&arenaResource};
+
+	fillContainers( &tracking );
+	std::cout << "allocations still live: "
+		<< tracking.getAllocations()
+		<< ", peak bytes: "
+		<< tracking.getPeakBytes()
+		<< '\n';
+	printStats( "arena",
+		arenaResource.getStats() );
+	printStats( "pools",
+		pools.getStats() );
+
+	// same code, system heap
+	fillContainers( std::pmr::new_delete_resource() );
+
+	std::system( "pause" );
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,342 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <tuple>
+#include <utility>
+#include "../allocator_stats.h"
+#include "../ObjectPool/object_pool.h"
+
+
+//======================================================================
+// \file	memory_resources.h
+//
+// \brief	std::pmr::memory_resource adapters for this library's allocators.
+//			`std::pmr::vector<T>`, `std::pmr::string`, `std::pmr::map<K, V>` etc. have the same
+//				type whatever resource they use, so the allocation strategy can be picked at runtime.
+//			Every resource chains to an upstream resource, used for what it can't serve itself
+//				(exhausted, oversized or overaligned requests); upstreams default to
+//				`std::pmr::get_default_resource()` and can be other resources from this file.
+//			Resources don't own the memory they wrap and, just like the wrapped allocators,
+//				aren't thread safe unless the wrapped allocator is.
+//======================================================================
+
+
+//======================================================================
+// \class	ArenaResource
+//
+// \brief	serves requests from an `Arena`, `SArena` or `SArenaTS`
+//			requests aligned beyond the arena's alignment, or that no longer fit, go upstream
+//			deallocation is forwarded to whoever handed out the pointer
+//======================================================================
+template<typename TArena>
+class ArenaResource final
+	: public std::pmr::memory_resource
+{
+	TArena* m_pArena;
+	std::pmr::memory_resource* m_pUpstream;
+public:
+	explicit ArenaResource( TArena* pArena,
+		std::pmr::memory_resource* pUpstream = std::pmr::get_default_resource() ) noexcept
+		:
+		m_pArena{pArena},
+		m_pUpstream{pUpstream}
+	{
+
+	}
+
+	ArenaResource( const ArenaResource& rhs ) = delete;
+	ArenaResource& operator=( const ArenaResource& rhs ) = delete;
+
+	TArena* getArena() const noexcept
+	{
+		return m_pArena;
+	}
+
+	std::pmr::memory_resource* getUpstream() const noexcept
+	{
+		return m_pUpstream;
+	}
+
+	AllocatorStats getStats() const noexcept
+	{
+		return m_pArena->getStats();
+	}
+private:
+	bool owns( const void* p ) const noexcept
+	{
+		const auto address = reinterpret_cast<std::size_t>( p );
+		return address >= reinterpret_cast<std::size_t>( m_pArena->getStartAddress() )
+			&& address < m_pArena->getEndAddress();
+	}
+
+	void* do_allocate( std::size_t bytes,
+		std::size_t alignment ) override
+	{
+		if ( alignment <= TArena::getAlignment() && m_pArena->getAvailableMemory() >= bytes )
+		{
+			try
+			{
+				return m_pArena->allocate( bytes );
+			}
+			catch ( const std::bad_alloc& )
+			{
+				// alignment padding and headers didn't fit; the arena took nothing, fall through
+			}
+		}
+		return m_pUpstream->allocate( bytes,
+			alignment );
+	}
+
+	void do_deallocate( void* p,
+		std::size_t bytes,
+		std::size_t alignment ) override
+	{
+		if ( owns( p ) )
+		{
+			m_pArena->deallocate( p,
+				bytes );
+			return;
+		}
+		m_pUpstream->deallocate( p,
+			bytes,
+			alignment );
+	}
+
+	bool do_is_equal( const std::pmr::memory_resource& rhs ) const noexcept override
+	{
+		return this == &rhs;
+	}
+};
+
+
+//======================================================================
+// \class	PoolResource
+//
+// \brief	size classes backed by one `ObjectPool` each, `slotsPerClass` slots per class
+//			a request is served by the smallest class that fits it; requests bigger than the
+//				largest class, aligned beyond `alignof( std::max_align_t )`, or whose class
+//				is exhausted go upstream
+//======================================================================
+template<std::size_t... slotSizes>
+class PoolResource final
+	: public std::pmr::memory_resource
+{
+	static_assert( sizeof...( slotSizes ) > 0,
+		"PoolResource needs at least one size class." );
+
+	template<std::size_t size>
+	struct alignas( std::max_align_t ) Slot final
+	{
+		unsigned char bytes[size];
+	};
+
+	std::tuple<ObjectPool<Slot<slotSizes>>...> m_pools;
+	std::pmr::memory_resource* m_pUpstream;
+public:
+	explicit PoolResource( const std::size_t slotsPerClass,
+		std::pmr::memory_resource* pUpstream = std::pmr::get_default_resource() )
+		:
+		m_pools{ObjectPool<Slot<slotSizes>>{slotsPerClass}...},
+		m_pUpstream{pUpstream}
+	{
+
+	}
+
+	PoolResource( const PoolResource& rhs ) = delete;
+	PoolResource& operator=( const PoolResource& rhs ) = delete;
+
+	std::pmr::memory_resource* getUpstream() const noexcept
+	{
+		return m_pUpstream;
+	}
+
+	// the sum over all size classes
+	AllocatorStats getStats() const noexcept
+	{
+		AllocatorStats stats;
+		std::apply( [&stats] ( const auto&... pools )
+			{
+				( addStats( stats, pools.getStats() ), ... );
+			},
+			m_pools );
+		// slots of different classes can't be merged, so only the largest class's free slot counts
+		stats.largestFreeBlock = getLargestFreeSlot<sizeof...( slotSizes ) - 1>();
+		return stats;
+	}
+private:
+	static void addStats( AllocatorStats& stats,
+		const AllocatorStats& poolStats ) noexcept
+	{
+		stats.requestedBytes += poolStats.requestedBytes;
+		stats.paddingBytes += poolStats.paddingBytes;
+		stats.headerBytes += poolStats.headerBytes;
+		stats.freeBytes += poolStats.freeBytes;
+		stats.totalBytes += poolStats.totalBytes;
+	}
+
+	template<std::size_t index>
+	std::size_t getLargestFreeSlot() const noexcept
+	{
+		const auto& pool = std::get<index>( m_pools );
+		if ( !pool.isExhausted() )
+		{
+			return sizeof( typename std::tuple_element_t<index, decltype( m_pools )>::value_type );
+		}
+		if constexpr ( index > 0 )
+		{
+			return getLargestFreeSlot<index - 1>();
+		}
+		return 0;
+	}
+
+	template<std::size_t index = 0>
+	void* allocateFromPools( const std::size_t bytes )
+	{
+		if constexpr ( index < sizeof...( slotSizes ) )
+		{
+			auto& pool = std::get<index>( m_pools );
+			using TSlot = typename std::tuple_element_t<index, decltype( m_pools )>::value_type;
+			if ( bytes <= sizeof( TSlot ) && !pool.isExhausted() )
+			{
+				return pool.allocate();
+			}
+			return allocateFromPools<index + 1>( bytes );
+		}
+		return nullptr;
+	}
+
+	template<std::size_t index = 0>
+	bool deallocateToPools( void* p )
+	{
+		if constexpr ( index < sizeof...( slotSizes ) )
+		{
+			auto& pool = std::get<index>( m_pools );
+			using TSlot = typename std::tuple_element_t<index, decltype( m_pools )>::value_type;
+			if ( pool.owns( p ) )
+			{
+				pool.deallocate( static_cast<TSlot*>( p ) );
+				return true;
+			}
+			return deallocateToPools<index + 1>( p );
+		}
+		return false;
+	}
+
+	void* do_allocate( std::size_t bytes,
+		std::size_t alignment ) override
+	{
+		if ( alignment <= alignof( std::max_align_t ) )
+		{
+			if ( void* p = allocateFromPools( bytes ) )
+			{
+				return p;
+			}
+		}
+		return m_pUpstream->allocate( bytes,
+			alignment );
+	}
+
+	void do_deallocate( void* p,
+		std::size_t bytes,
+		std::size_t alignment ) override
+	{
+		if ( !deallocateToPools( p ) )
+		{
+			m_pUpstream->deallocate( p,
+				bytes,
+				alignment );
+		}
+	}
+
+	bool do_is_equal( const std::pmr::memory_resource& rhs ) const noexcept override
+	{
+		return this == &rhs;
+	}
+};
+
+
+//======================================================================
+// \class	TrackingResource
+//
+// \brief	the `TrackingAlignedAllocator` counters as a resource decorator
+//			every request is forwarded upstream and accounted for, so it can be chained in
+//				front of any other resource to observe it
+//======================================================================
+class TrackingResource final
+	: public std::pmr::memory_resource
+{
+	std::pmr::memory_resource* m_pUpstream;
+	std::size_t m_nAllocations;
+	std::size_t m_requestedBytes;
+	std::size_t m_peakBytes;
+public:
+	explicit TrackingResource( std::pmr::memory_resource* pUpstream = std::pmr::get_default_resource() ) noexcept
+		:
+		m_pUpstream{pUpstream},
+		m_nAllocations{0},
+		m_requestedBytes{0},
+		m_peakBytes{0}
+	{
+
+	}
+
+	TrackingResource( const TrackingResource& rhs ) = delete;
+	TrackingResource& operator=( const TrackingResource& rhs ) = delete;
+
+	std::pmr::memory_resource* getUpstream() const noexcept
+	{
+		return m_pUpstream;
+	}
+
+	// live allocations
+	std::size_t getAllocations() const noexcept
+	{
+		return m_nAllocations;
+	}
+
+	// the most bytes that were live at once
+	std::size_t getPeakBytes() const noexcept
+	{
+		return m_peakBytes;
+	}
+
+	// the upstream's free space and bookkeeping are unknown here and reported as 0
+	AllocatorStats getStats() const noexcept
+	{
+		AllocatorStats stats;
+		stats.requestedBytes = m_requestedBytes;
+		return stats;
+	}
+private:
+	void* do_allocate( std::size_t bytes,
+		std::size_t alignment ) override
+	{
+		void* p = m_pUpstream->allocate( bytes,
+			alignment );
+		++m_nAllocations;
+		m_requestedBytes += bytes;
+		if ( m_requestedBytes > m_peakBytes )
+		{
+			m_peakBytes = m_requestedBytes;
+		}
+		return p;
+	}
+
+	void do_deallocate( void* p,
+		std::size_t bytes,
+		std::size_t alignment ) override
+	{
+		m_pUpstream->deallocate( p,
+			bytes,
+			alignment );
+		--m_nAllocations;
+		m_requestedBytes -= bytes;
+	}
+
+	bool do_is_equal( const std::pmr::memory_resource& rhs ) const noexcept override
+	{
+		return this == &rhs;
+	}
+};
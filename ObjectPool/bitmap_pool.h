@@ -0,0 +1,312 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#if defined __AVX2__
+#	include <immintrin.h>
+#endif
+#include "../allocator_stats.h"
+#include "../allocator_utils.h"
+#include "../memory_budget.h"
+
+
+//=============================================================
+// \class	BitmapPool
+//
+// \brief	Pool Allocator with its free slots in a bitmap instead of `ObjectPool`'s list
+//			a freed object is never written to and an allocation never reads the slot it hands
+//				out, so neither touches a cold object; the bitmap, one bit per slot, stays cached
+//			allocation takes the lowest free slot, so the live objects stay packed at the start
+//				of the pool: the search starts at the lowest word with a free bit and takes its
+//				least significant set bit; built with AVX2 it skips full words 256 bits at a time
+//			with `cacheLinePadded` every slot starts on its own `cacheLineSize` boundary and
+//				is rounded up to it, as in `ObjectPool`
+//			created against a `MemoryBudget`, its slots and bitmap are charged to the budget for
+//				its lifetime
+//=============================================================
+template<typename T, bool cacheLinePadded = false>
+class BitmapPool final
+{
+	static constexpr std::size_t m_slotAlignment = cacheLinePadded && cacheLineSize > alignof( T ) ?
+		cacheLineSize :
+		alignof( T );
+
+	struct alignas( m_slotAlignment ) Object
+	{
+		std::aligned_storage_t<sizeof( T ), alignof( T )> m_storage;
+	};
+
+	static constexpr std::size_t m_bitsPerWord = 64;
+	// words the AVX2 search tests at once; the bitmap is padded to a multiple of them
+	static constexpr std::size_t m_wordsPerScan = 4;
+
+	std::unique_ptr<Object[]> m_pool;
+	// a set bit marks a free slot; the bits past the last slot stay clear
+	std::unique_ptr<std::uint64_t[]> m_freeBits;
+	std::size_t m_nObjs;
+	std::size_t m_nWords;
+	// every word below this one is full
+	std::size_t m_firstFreeWord = 0;
+	std::size_t m_nLive = 0;
+	MemoryBudget* m_pBudget = nullptr;
+public:
+	using value_type = T;
+	using pointer = T*;
+
+	// constructor creates the pool given its size
+	// throws std::bad_alloc if `pBudget` (optional) can't take the slots and the bitmap
+	explicit BitmapPool( const std::size_t size,
+		MemoryBudget* pBudget = nullptr )
+		:
+		m_pool{},
+		m_freeBits{},
+		m_nObjs{size},
+		m_nWords{calcAlignedSize( ( size + m_bitsPerWord - 1 ) / m_bitsPerWord, m_wordsPerScan )}
+	{
+		chargeBudget( pBudget,
+			getFootprint() );
+		try
+		{
+			m_pool = std::make_unique<Object[]>( size );
+			m_freeBits = std::make_unique<std::uint64_t[]>( m_nWords );
+		}
+		catch ( ... )
+		{
+			releaseBudget( pBudget,
+				getFootprint() );
+			throw;
+		}
+		m_pBudget = pBudget;
+		for ( std::size_t i = 0; i < size / m_bitsPerWord; ++i )
+		{
+			m_freeBits[i] = ~std::uint64_t{0};
+		}
+		if ( size % m_bitsPerWord != 0 )
+		{
+			m_freeBits[size / m_bitsPerWord] = ( std::uint64_t{1} << ( size % m_bitsPerWord ) ) - 1;
+		}
+	}
+
+	~BitmapPool() noexcept
+	{
+		if ( m_pool )
+		{
+			releaseBudget( m_pBudget,
+				getFootprint() );
+		}
+	}
+
+	BitmapPool( const BitmapPool& rhs ) = delete;
+	BitmapPool& operator=( const BitmapPool& rhs ) = delete;
+
+	BitmapPool( BitmapPool&& rhs ) noexcept
+		:
+		m_pool{std::move( rhs.m_pool )},
+		m_freeBits{std::move( rhs.m_freeBits )},
+		m_nObjs{rhs.getSize()},
+		m_nWords{rhs.m_nWords},
+		m_firstFreeWord{rhs.m_firstFreeWord},
+		m_nLive{rhs.m_nLive},
+		m_pBudget{rhs.m_pBudget}
+	{
+		rhs.m_nObjs = 0;
+		rhs.m_nWords = 0;
+		rhs.m_firstFreeWord = 0;
+		rhs.m_nLive = 0;
+		rhs.m_pBudget = nullptr;
+	}
+
+	BitmapPool& operator=( BitmapPool&& rhs ) noexcept
+	{
+		std::swap( m_pool,
+			rhs.m_pool );
+		std::swap( m_freeBits,
+			rhs.m_freeBits );
+		std::swap( m_nObjs,
+			rhs.m_nObjs );
+		std::swap( m_nWords,
+			rhs.m_nWords );
+		std::swap( m_firstFreeWord,
+			rhs.m_firstFreeWord );
+		std::swap( m_nLive,
+			rhs.m_nLive );
+		std::swap( m_pBudget,
+			rhs.m_pBudget );
+
+		return *this;
+	}
+
+	template <typename U>
+	struct rebind
+	{
+		using otherAllocator = BitmapPool<U, cacheLinePadded>;
+	};
+
+	T* address( T& r ) const noexcept
+	{
+		return &r;
+	}
+
+	const T* address( const T& r ) const noexcept
+	{
+		return &r;
+	}
+
+	// the lowest free slot - don't use directly
+	[[nodiscard]]
+	T* allocate()
+	{
+		const std::size_t word = findFreeWord();
+		if ( word == m_nWords )
+		{
+			throw std::bad_alloc{};
+		}
+		m_firstFreeWord = word;
+
+		const std::size_t bit = countTrailingZeros( m_freeBits[word] );
+		m_freeBits[word] &= m_freeBits[word] - 1;
+		++m_nLive;
+
+		return reinterpret_cast<T*>( &m_pool[word * m_bitsPerWord + bit].m_storage );
+	}
+
+	// marks the slot free; the object's memory is not touched - don't use directly
+	void deallocate( T* p,
+		[[maybe_unused]] std::size_t count = 0 ) noexcept
+	{
+		ASSERT( owns( p ),
+			"Pointer not from this BitmapPool!" );
+		const std::size_t index = reinterpret_cast<Object*>( p ) - m_pool.get();
+		const std::size_t word = index / m_bitsPerWord;
+		const std::uint64_t bit = std::uint64_t{1} << ( index % m_bitsPerWord );
+		ASSERT( ( m_freeBits[word] & bit ) == 0,
+			"BitmapPool slot freed twice!" );
+		m_freeBits[word] |= bit;
+		if ( word < m_firstFreeWord )
+		{
+			m_firstFreeWord = word;
+		}
+		--m_nLive;
+	}
+
+	// pass ctor args
+	template<typename... TArgs>
+	[[nodiscard]]
+	T* construct( TArgs... args )
+	{
+		return new ( allocate() ) T{std::forward<TArgs>( args )...};
+	}
+
+	void destroy( T* p ) noexcept
+	{
+		if ( p == nullptr )
+		{
+			return;
+		}
+
+		p->~T();
+		deallocate( p );
+	}
+
+	std::size_t getSize() const noexcept
+	{
+		return m_nObjs;
+	}
+
+	const void* getStartAddress() const noexcept
+	{
+		return m_pool.get();
+	}
+
+	// nullptr if unbudgeted
+	MemoryBudget* getBudget() const noexcept
+	{
+		return m_pBudget;
+	}
+
+	// true when the next `allocate()` would throw
+	bool isExhausted() const noexcept
+	{
+		return m_nLive == m_nObjs;
+	}
+
+	// whether `p` is one of this pool's slots
+	bool owns( const void* p ) const noexcept
+	{
+		const auto first = reinterpret_cast<std::uintptr_t>( m_pool.get() );
+		const auto address = reinterpret_cast<std::uintptr_t>( p );
+		return address >= first && address < first + m_nObjs * sizeof( Object );
+	}
+
+	// the bitmap is bookkeeping outside the slots, counted as header bytes
+	// slot slack (cache line padding) counts as padding, as in `ObjectPool`
+	AllocatorStats getStats() const noexcept
+	{
+		AllocatorStats stats;
+		stats.requestedBytes = m_nLive * sizeof( T );
+		stats.paddingBytes = m_nLive * ( sizeof( Object ) - sizeof( T ) );
+		stats.headerBytes = m_nWords * sizeof( std::uint64_t );
+		stats.freeBytes = ( m_nObjs - m_nLive ) * sizeof( Object );
+		stats.largestFreeBlock = stats.freeBytes;
+		stats.totalBytes = m_nObjs * sizeof( Object );
+		return stats;
+	}
+private:
+	// bytes of the slots and the bitmap
+	std::size_t getFootprint() const noexcept
+	{
+		return m_nObjs * sizeof( Object ) + m_nWords * sizeof( std::uint64_t );
+	}
+
+	// the lowest word with a free bit, or `m_nWords`
+	std::size_t findFreeWord() const noexcept
+	{
+		std::size_t word = m_firstFreeWord;
+#if defined __AVX2__
+		for ( ; word < m_nWords && word % m_wordsPerScan != 0; ++word )
+		{
+			if ( m_freeBits[word] != 0 )
+			{
+				return word;
+			}
+		}
+		for ( ; word < m_nWords; word += m_wordsPerScan )
+		{
+			const __m256i bits = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( &m_freeBits[word] ) );
+			if ( !_mm256_testz_si256( bits,
+				bits ) )
+			{
+				while ( m_freeBits[word] == 0 )
+				{
+					++word;
+				}
+				return word;
+			}
+		}
+#else
+		for ( ; word < m_nWords; ++word )
+		{
+			if ( m_freeBits[word] != 0 )
+			{
+				return word;
+			}
+		}
+#endif
+		return m_nWords;
+	}
+};
+
+template <class T, bool tPadded, class Other, bool otherPadded>
+bool operator==( const BitmapPool<T, tPadded>& lhs,
+	const BitmapPool<Other, otherPadded>& rhs ) noexcept
+{
+	return lhs.getStartAddress() == rhs.getStartAddress();
+}
+
+template <class T, bool tPadded, class Other, bool otherPadded>
+bool operator!=( const BitmapPool<T, tPadded>& lhs,
+	const BitmapPool<Other, otherPadded>& rhs ) noexcept
+{
+	return lhs.getStartAddress() != rhs.getStartAddress();
+}
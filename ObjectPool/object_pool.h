@@ -1,6 +1,10 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
+#include "../allocator_stats.h"
+#include "../allocator_utils.h"
+#include "../memory_budget.h"
 
 
 //=============================================================
@@ -10,11 +14,18 @@
 // \date	3-Oct-19
 //
 // \brief	Pool Allocator
+//			with `cacheLinePadded` every slot starts on its own `cacheLineSize` boundary and
+//				is rounded up to it, so objects handed to different threads never share a cache line
+//			created against a `MemoryBudget`, its slots are charged to the budget for its lifetime
 //=============================================================
-template<typename T>
+template<typename T, bool cacheLinePadded = false>
 class ObjectPool final
 {
-	union Object
+	static constexpr std::size_t m_slotAlignment = cacheLinePadded && cacheLineSize > alignof( T ) ?
+		cacheLineSize :
+		alignof( T );
+
+	union alignas( m_slotAlignment ) Object
 	{
 		std::aligned_storage_t<sizeof( T ), alignof( T )> m_storage;
 		Object* m_pNext;
@@ -23,16 +34,21 @@ class ObjectPool final
 	std::unique_ptr<Object[]> m_pool;
 	Object* m_pNextFree;
 	std::size_t m_nObjs;
+	std::size_t m_nLive = 0;
+	MemoryBudget* m_pBudget = nullptr;
 public:
 	using value_type = T;
 	using pointer = T*;
 
 	// constructor creates the pool given its size
-	explicit ObjectPool( const std::size_t size )
+	// throws std::bad_alloc if `pBudget` (optional) can't take the slots
+	explicit ObjectPool( const std::size_t size,
+		MemoryBudget* pBudget = nullptr )
 		:
-		m_pool{std::make_unique<Object[]>( size )},
+		m_pool{makePool( size, pBudget )},
 		m_pNextFree{nullptr},
-		m_nObjs(size)
+		m_nObjs(size),
+		m_pBudget{pBudget}
 	{
 		for ( int i = 1; i < size; ++i )
 		{
@@ -42,7 +58,14 @@ public:
 		m_pNextFree = &m_pool[0];
 	}
 
-	~ObjectPool() noexcept = default;
+	~ObjectPool() noexcept
+	{
+		if ( m_pool )
+		{
+			releaseBudget( m_pBudget,
+				m_nObjs * sizeof( Object ) );
+		}
+	}
 
 	ObjectPool( const ObjectPool& rhs ) = delete;
 	ObjectPool& operator=( const ObjectPool& rhs ) = delete;
@@ -51,18 +74,28 @@ public:
 		:
 		m_pool{std::move( rhs.m_pool )},
 		m_pNextFree{rhs.m_pNextFree},
-		m_nObjs{rhs.getSize()}
+		m_nObjs{rhs.getSize()},
+		m_nLive{rhs.m_nLive},
+		m_pBudget{rhs.m_pBudget}
 	{
 		rhs.m_pNextFree = nullptr;
+		rhs.m_nLive = 0;
+		rhs.m_pBudget = nullptr;
 	}
 	
+	// `rhs` gets this pool's slots, with their size and budget, to free them
 	ObjectPool& operator=( ObjectPool&& rhs ) noexcept
 	{
-		m_nObjs = rhs.getSize();
+		std::swap( m_nObjs,
+			rhs.m_nObjs );
 		std::swap( m_pool,
 			rhs.m_pool );
+		std::swap( m_pBudget,
+			rhs.m_pBudget );
 		m_pNextFree = rhs.m_pNextFree;
 		rhs.m_pNextFree = nullptr;
+		m_nLive = rhs.m_nLive;
+		rhs.m_nLive = 0;
 
 		return *this;
 	}
@@ -70,7 +103,7 @@ public:
 	template <typename U>
 	struct rebind
 	{
-		using otherAllocator = ObjectPool<U>;
+		using otherAllocator = ObjectPool<U, cacheLinePadded>;
 	};
 
 	T* address( T& r ) const noexcept
@@ -94,6 +127,7 @@ public:
 
 		const auto currentObj = m_pNextFree;
 		m_pNextFree = currentObj->m_pNext;
+		++m_nLive;
 
 		return reinterpret_cast<T*>( &currentObj->m_storage );
 	}
@@ -105,6 +139,7 @@ public:
 		const auto o = reinterpret_cast<Object*>( p );
 		o->m_pNext = m_pNextFree;
 		m_pNextFree = o;
+		--m_nLive;
 	}
 
 	// pass ctor args
@@ -126,22 +161,77 @@ public:
 		deallocate( p );
 	}
 
-	std::size_t getSize() noexcept
+	std::size_t getSize() const noexcept
 	{
 		return m_nObjs;
 	}
+
+	const void* getStartAddress() const noexcept
+	{
+		return m_pool.get();
+	}
+
+	// nullptr if unbudgeted
+	MemoryBudget* getBudget() const noexcept
+	{
+		return m_pBudget;
+	}
+
+	// true when the next `allocate()` would throw
+	bool isExhausted() const noexcept
+	{
+		return m_pNextFree == nullptr;
+	}
+
+	// whether `p` is one of this pool's slots
+	bool owns( const void* p ) const noexcept
+	{
+		const auto first = reinterpret_cast<std::uintptr_t>( m_pool.get() );
+		const auto address = reinterpret_cast<std::uintptr_t>( p );
+		return address >= first && address < first + m_nObjs * sizeof( Object );
+	}
+
+	// a slot is never split, so every free slot can serve any request and there's no external fragmentation
+	// slot slack (`Object` being wider than `T`, eg. T smaller than a pointer or cache line padding) counts as padding
+	AllocatorStats getStats() const noexcept
+	{
+		AllocatorStats stats;
+		stats.requestedBytes = m_nLive * sizeof( T );
+		stats.paddingBytes = m_nLive * ( sizeof( Object ) - sizeof( T ) );
+		stats.freeBytes = ( m_nObjs - m_nLive ) * sizeof( Object );
+		stats.largestFreeBlock = stats.freeBytes;
+		stats.totalBytes = m_nObjs * sizeof( Object );
+		return stats;
+	}
+private:
+	static std::unique_ptr<Object[]> makePool( const std::size_t size,
+		MemoryBudget* pBudget )
+	{
+		chargeBudget( pBudget,
+			size * sizeof( Object ) );
+		try
+		{
+			return std::make_unique<Object[]>( size );
+		}
+		catch ( ... )
+		{
+			releaseBudget( pBudget,
+				size * sizeof( Object ) );
+			throw;
+		}
+	}
 };
 
-template <class T, class Other>
-bool operator==( const ObjectPool<T>& lhs,
-	const ObjectPool<Other>& rhs ) noexcept
+template <class T, bool tPadded, class Other, bool otherPadded>
+bool operator==( const ObjectPool<T, tPadded>& lhs,
+	const ObjectPool<Other, otherPadded>& rhs ) noexcept
 {
 	return lhs.m_pool == rhs.m_pool;
 }
 
-template <class T, class Other>
-bool operator!=( const ObjectPool<T>& lhs,
-	const ObjectPool<Other>& rhs ) noexcept
+template <class T, bool tPadded, class Other, bool otherPadded>
+bool operator!=( const ObjectPool<T, tPadded>& lhs,
+	const ObjectPool<Other, otherPadded>& rhs ) noexcept
 {
 	return lhs.m_pool != rhs.m_pool;
 }
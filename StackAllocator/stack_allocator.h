@@ -1,7 +1,12 @@
 #pragma once
 
+#include <iostream>
+#include <stdexcept>
+#include <type_traits>
+#include "../allocator_stats.h"
 #include "../allocator_utils.h"
 #include "../assertions.h"
+#include "../memory_budget.h"
 
 
 template<std::size_t t_alignment = alignof( std::max_align_t )>
@@ -9,9 +14,14 @@ class SArena
 {
 	static inline constexpr std::size_t m_alignment = t_alignment;
 
-	char* m_pData;
-	char* m_pOffset;
-	std::size_t m_maxSize;
+	// initialized here for the move constructor, which assigns over an empty arena
+	char* m_pData = nullptr;
+	char* m_pOffset = nullptr;
+	std::size_t m_maxSize = 0;
+	std::size_t m_requestedBytes = 0;
+	std::size_t m_paddingBytes = 0;
+	std::size_t m_nAllocations = 0;
+	MemoryBudget* m_pBudget = nullptr;
 
 	struct Header final
 	{
@@ -33,14 +43,17 @@ public:
 	}
 
 	// Attention! DO NOT malloc inside the initializer list.
-	SArena( std::size_t size )
+	// throws std::bad_alloc if `pBudget` (optional) can't take `size` more bytes
+	SArena( std::size_t size,
+		MemoryBudget* pBudget = nullptr )
 		:
-		m_maxSize(size)
+		m_maxSize(size),
+		m_pBudget{pBudget}
 	{
 		ASSERT( m_maxSize > 0,
 			"Invalid size!" );
-		m_pData = (char*)alignedMalloc( m_maxSize,
-			m_alignment );
+		m_pData = (char*)budgetedAlignedMalloc<m_alignment>( m_pBudget,
+			m_maxSize );
 
 		m_pOffset = m_pData;
 		if ( m_pData == nullptr )
@@ -51,10 +64,9 @@ public:
 
 	~SArena()
 	{
-		if ( m_pData )
-		{
-			alignedFree( m_pData );
-		}
+		budgetedAlignedFree<m_alignment>( m_pBudget,
+			m_pData,
+			m_maxSize );
 	}
 
 	SArena( const SArena& rhs ) = delete;
@@ -67,19 +79,27 @@ public:
 
 	SArena& operator=( SArena&& rhs )
 	{
-		if ( m_pData )
-		{
-			alignedFree( m_pData );
-		}
+		budgetedAlignedFree<m_alignment>( m_pBudget,
+			m_pData,
+			m_maxSize );
 
 		m_pData = std::move( rhs.m_pData );
 		m_maxSize = rhs.m_maxSize;
 		m_pOffset = rhs.m_pOffset;
+		m_requestedBytes = rhs.m_requestedBytes;
+		m_paddingBytes = rhs.m_paddingBytes;
+		m_nAllocations = rhs.m_nAllocations;
+		m_pBudget = rhs.m_pBudget;
 
 		// destroy the other one
 		rhs.m_pData = nullptr;
 		rhs.m_maxSize = 0;
 		rhs.m_pOffset = nullptr;
+		rhs.m_requestedBytes = 0;
+		rhs.m_paddingBytes = 0;
+		rhs.m_nAllocations = 0;
+		rhs.m_pBudget = nullptr;
+		return *this;
 	}
 
 	// the `bytes` to allocate - more will be allocated due to alignment padding and Header size
@@ -90,9 +110,8 @@ public:
 		ASSERT( m_pData != nullptr,
 			"m_pData is null!" );
 
-		std::size_t currentAllocationStartAddress = alignForward( (std::size_t) m_pOffset
-			+ sizeof( Header ),
-			m_alignment );
+		std::size_t currentAllocationStartAddress = alignForward<m_alignment>( (std::size_t) m_pOffset
+			+ sizeof( Header ) );
 
 #if defined _DEBUG && !defined NDEBUG
 		std::cout << "allocating "
@@ -102,19 +121,23 @@ public:
 			<< '\n';
 #endif // _DEBUG
 
-		// set the new offset
-		m_pOffset = (char*) ( currentAllocationStartAddress + bytes );
-		// check that we haven't run out of memory
-		if ( m_pOffset <= m_pData + m_maxSize )
-		{
-			( (Header*)
-				( currentAllocationStartAddress - sizeof( Header ) ) )->allocationAddress
-				= currentAllocationStartAddress;
-		}
-		else
+		const std::size_t padding = currentAllocationStartAddress - sizeof( Header )
+			- (std::size_t) m_pOffset;
+		// check that we haven't run out of memory, before the offset moves, so a failed
+		//	allocation leaves the arena as it was
+		if ( currentAllocationStartAddress > getEndAddress()
+			|| bytes > getEndAddress() - currentAllocationStartAddress )
 		{
 			throw std::bad_alloc{};
 		}
+		// set the new offset
+		m_pOffset = (char*) ( currentAllocationStartAddress + bytes );
+		( (Header*)
+			( currentAllocationStartAddress - sizeof( Header ) ) )->allocationAddress
+			= currentAllocationStartAddress;
+		m_requestedBytes += bytes;
+		m_paddingBytes += padding;
+		++m_nAllocations;
 		return reinterpret_cast<void*>( currentAllocationStartAddress );
 	}
 
@@ -138,12 +161,32 @@ public:
 		return;
 	}
 
+	// resizes the allocation at `p` of `oldSize` bytes to `newSize` bytes without moving it
+	//	only possible for the top of the stack; shrinking it hands the bytes back to the arena
+	bool tryExpand( void* p,
+		const std::size_t oldSize,
+		const std::size_t newSize ) noexcept
+	{
+		char* pAllocation = static_cast<char*>( p );
+		if ( pAllocation + oldSize != m_pOffset
+			|| newSize > static_cast<std::size_t>( m_pData + m_maxSize - pAllocation ) )
+		{
+			return false;
+		}
+		m_pOffset = pAllocation + newSize;
+		m_requestedBytes = m_requestedBytes - oldSize + newSize;
+		return true;
+	}
+
 	// reset the arena. All existing allocated memory will be lost
 	void reset()
 	{
 		ASSERT( m_pData != nullptr,
 			"m_pData is null!" );
 		m_pOffset = m_pData;
+		m_requestedBytes = 0;
+		m_paddingBytes = 0;
+		m_nAllocations = 0;
 	}
 
 	std::size_t getAvailableMemory() const noexcept
@@ -151,6 +194,31 @@ public:
 		return getEndAddress() - reinterpret_cast<std::size_t>( m_pOffset );
 	}
 
+	// deallocate() does not hand memory back, so every allocation since the last reset is accounted for
+	// the largest free block is what remains once the next Header and alignment padding are paid for
+	AllocatorStats getStats() const noexcept
+	{
+		AllocatorStats stats;
+		stats.requestedBytes = m_requestedBytes;
+		stats.paddingBytes = m_paddingBytes;
+		stats.headerBytes = m_nAllocations * sizeof( Header );
+		stats.freeBytes = getAvailableMemory();
+		const std::size_t nextStartAddress = alignForward<m_alignment>( (std::size_t) m_pOffset
+			+ sizeof( Header ) );
+		stats.largestFreeBlock = nextStartAddress < getEndAddress() ?
+			getEndAddress() - nextStartAddress :
+			0;
+		stats.totalBytes = m_maxSize;
+		return stats;
+	}
+
+	// whether `p` points into this arena's memory
+	bool owns( const void* p ) const noexcept
+	{
+		const std::size_t address = reinterpret_cast<std::size_t>( p );
+		return address >= reinterpret_cast<std::size_t>( m_pData ) && address < getEndAddress();
+	}
+
 	// GETTERS
 	char* getStartAddress() const noexcept
 	{
@@ -176,6 +244,12 @@ public:
 	{
 		return m_maxSize;
 	}
+
+	// nullptr if unbudgeted
+	MemoryBudget* getBudget() const noexcept
+	{
+		return m_pBudget;
+	}
 };
 
 //======================================================================
@@ -216,11 +290,20 @@ public:
 	using size_type = std::size_t;
 	using difference_type = ptrdiff_t;
 	using pointer = T*;
-	using const_pointer = T* const;
+	using const_pointer = const T*;
 	using reference = T&;
 	using const_reference = const T&;
 
+	// see `LinearAllocator`: containers keep their arena, so nested ones built through
+	//	std::scoped_allocator_adaptor all end up on the outer container's arena
+	using propagate_on_container_copy_assignment = std::false_type;
+	using propagate_on_container_move_assignment = std::false_type;
+	using propagate_on_container_swap = std::false_type;
+	using is_always_equal = std::false_type;
+
 	StackAllocator() noexcept
+		:
+		m_pArena{nullptr}
 	{
 
 	}
@@ -267,7 +350,7 @@ public:
 	}
 
 	template<typename Other>
-	StackAllocator( const StackAllocator<Other>&& rhs ) noexcept
+	StackAllocator( const StackAllocator<Other, t_alignment>&& rhs ) noexcept
 		:
 		m_pArena{rhs.m_pArena}
 	{
@@ -281,6 +364,13 @@ public:
 		using other = StackAllocator<U, t_alignment>;
 	};
 
+	// true if both allocate from the same arena, whatever their value types
+	template<typename U>
+	bool isSameArena( const StackAllocator<U, t_alignment>& rhs ) const noexcept
+	{
+		return m_pArena == rhs.m_pArena;
+	}
+
 	// get the address of a reference
 	T* address( T& x ) const noexcept
 	{
@@ -317,6 +407,19 @@ public:
 		m_pArena->deallocate( plastAllocationAddress );
 	}
 
+	// grows or shrinks `p` from `oldCount` to `newCount` elements in place, if it's the
+	//	latest allocation; see `SArena::tryExpand()`
+	bool tryExpand( T* p,
+		const std::size_t oldCount,
+		const std::size_t newCount ) noexcept
+	{
+		ASSERT( m_pArena != nullptr,
+			"m_pArena is null!" );
+		return m_pArena->tryExpand( p,
+			oldCount * sizeof( T ),
+			newCount * sizeof( T ) );
+	}
+
 	template<typename... TArgs>
 	void construct( T* p,
 		TArgs&&... args ) const
@@ -368,6 +471,11 @@ public:
 		return m_pArena->getAvailableMemory();
 	}
 
+	AllocatorStats getStats() const noexcept
+	{
+		return m_pArena->getStats();
+	}
+
 	constexpr std::size_t getAlignment() const noexcept
 	{
 		return m_pArena->getAlignment();
@@ -399,9 +507,18 @@ public:
 	using size_type = std::size_t;
 	using difference_type = ptrdiff_t;
 	using pointer = void*;
-	using const_pointer = void* const;
+	using const_pointer = const void*;
+
+	// see `LinearAllocator`: containers keep their arena, so nested ones built through
+	//	std::scoped_allocator_adaptor all end up on the outer container's arena
+	using propagate_on_container_copy_assignment = std::false_type;
+	using propagate_on_container_move_assignment = std::false_type;
+	using propagate_on_container_swap = std::false_type;
+	using is_always_equal = std::false_type;
 
 	StackAllocator() noexcept
+		:
+		m_pArena{nullptr}
 	{
 
 	}
@@ -449,7 +566,7 @@ public:
 	}
 
 	template<typename Other>
-	StackAllocator( const StackAllocator<Other>&& rhs ) noexcept
+	StackAllocator( const StackAllocator<Other, t_alignment>&& rhs ) noexcept
 		:
 		m_pArena{rhs.m_pArena}
 	{
@@ -462,6 +579,13 @@ public:
 		using other = StackAllocator<U, t_alignment>;
 	};
 
+	// true if both allocate from the same arena, whatever their value types
+	template<typename U>
+	bool isSameArena( const StackAllocator<U, t_alignment>& rhs ) const noexcept
+	{
+		return m_pArena == rhs.m_pArena;
+	}
+
 	[[nodiscard]]
 	void* allocate( std::size_t count,
 		const void* hint = nullptr )
@@ -526,6 +650,11 @@ public:
 		return m_pArena->getAvailableMemory();
 	}
 
+	AllocatorStats getStats() const noexcept
+	{
+		return m_pArena->getStats();
+	}
+
 	std::size_t getSize() const noexcept
 	{
 		return m_pArena->getMaxSize();
@@ -533,32 +662,32 @@ public:
 };
 
 
-// an other allocator of the same type can deallocate from this one
-template<typename T, std::size_t t_alignment, std::size_t t_otherAlignment>
-inline bool operator==( const StackAllocator<T, t_alignment>&,
-	const StackAllocator<T, t_otherAlignment>&)
+// allocators on the same arena can deallocate each other's memory, whatever their value types
+template<typename T, typename U, std::size_t t_alignment>
+inline bool operator==( const StackAllocator<T, t_alignment>& lhs,
+	const StackAllocator<U, t_alignment>& rhs ) noexcept
 {
-	return true;
+	return lhs.isSameArena( rhs );
 }
 // equivalent statement:
-template<typename T, std::size_t t_alignment, std::size_t t_otherAlignment>
-inline bool operator!=( const StackAllocator<T, t_alignment>&,
-	const StackAllocator<T, t_otherAlignment>& )
+template<typename T, typename U, std::size_t t_alignment>
+inline bool operator!=( const StackAllocator<T, t_alignment>& lhs,
+	const StackAllocator<U, t_alignment>& rhs ) noexcept
 {
-	return false;
+	return !lhs.isSameArena( rhs );
 }
 
-// an other allocator of a different type cannot deallocate from this one
+// an allocator of another alignment or kind cannot deallocate from this one
 template<typename T, std::size_t t_alignment, typename OtherAllocator>
 inline bool operator==( const StackAllocator<T, t_alignment>&,
-	const OtherAllocator&)
+	const OtherAllocator& ) noexcept
 {
 	return false;
 }
 // equivalent statement:
 template<typename T, std::size_t t_alignment, typename OtherAllocator>
 inline bool operator!=( const StackAllocator<T, t_alignment>&,
-	const OtherAllocator& )
+	const OtherAllocator& ) noexcept
 {
 	return true;
 }
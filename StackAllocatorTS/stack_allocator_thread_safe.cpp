@@ -22,7 +22,8 @@ int stressTest()
 {
 	std::cout << "Preliminary" << '\n';
 	// Example usage of StackAllocatorTS
-	StackAllocatorTS<char> alloc(128);
+	SArenaTS<> arena(128);
+	StackAllocatorTS<char> alloc(&arena);
 	using Str = std::basic_string<char, std::char_traits<char>, StackAllocatorTS<char>>;
 
 	std::cout << "sizeof(Str)=" << sizeof(Str) << '\n' << "sizeof(std::string)=" << sizeof(std::string) << '\n';
@@ -44,7 +45,8 @@ int stressTest()
 
 	std::cout << "\nVector" << '\n';
 
-	StackAllocatorTS<GameObject> fooalloc(7000);
+	SArenaTS<> fooArena(7000);
+	StackAllocatorTS<GameObject> fooalloc(&fooArena);
 	std::vector<GameObject, StackAllocatorTS<GameObject>> vec(fooalloc);
 
 	for (int32_t i = 0; i < 100; i++)
@@ -57,7 +59,8 @@ int stressTest()
 
 
 	std::cout << "\nVector with special alignment" << '\n';
-	StackAllocatorTS<GameObject, sizeof(GameObject)> goAlloc{ 10500 };
+	SArenaTS<sizeof(GameObject)> goArena{ 10500 };
+	StackAllocatorTS<GameObject, sizeof(GameObject)> goAlloc{ &goArena };
 	using GameObjectVector = std::vector<GameObject, SA<GameObject, sizeof(GameObject)>>;
 	GameObjectVector govector{ goAlloc };
 	std::cout << std::is_copy_constructible_v<GameObject> << '\n';
@@ -77,7 +80,8 @@ int stressTest()
 
 	using astring = std::basic_string<char, std::char_traits<char>, SA<char>>;
 
-	StackAllocatorTS<astring> la5{ 8192 };
+	SArenaTS<> arena5{ 8192 };
+	StackAllocatorTS<astring> la5{ &arena5 };
 	std::deque<astring, SA<astring>> dq{ la5 };
 	for (int i = 0; i < 6; i++)
 	{
@@ -101,7 +105,8 @@ int stressTest()
 
 	std::cout << "\nStrings" << '\n';
 	using overaligned_string = std::basic_string<char, std::char_traits<char>, SA<char, 32>>;
-	StackAllocatorTS<char, 32> sa{ 2048 };
+	SArenaTS<32> stringArena{ 2048 };
+	StackAllocatorTS<char, 32> sa{ &stringArena };
 	overaligned_string s1{ "Short string", sa };
 	overaligned_string s2{ "My name is Maximus Decimus Meridius.\n"
 				"Commander of the armies of the North.\n"
@@ -134,7 +139,8 @@ int stressTest()
 	std::cout << "\nMap with Scoped Allocator adaptor" << '\n';
 	using mapstring = std::basic_string<char, std::char_traits<char>, SA<char, 16>>;
 	using amap = std::map<mapstring, int, std::less<>, SA<std::pair<mapstring const, int>, 16>>;
-	StackAllocatorTS<void, 16> la1{ 2048 };
+	SArenaTS<16> arena1{ 2048 };
+	StackAllocatorTS<void, 16> la1{ &arena1 };
 
 	std::cout << sizeof(amap) << '\n';
 	std::cout << sizeof(std::map<std::string, int>) << '\n';
@@ -162,7 +168,8 @@ int stressTest()
 	std::cout << "\nMap with StackAllocatorTS bare" << '\n';
 	using smapstring = std::basic_string<char, std::char_traits<char>, StackAllocatorTS<char, 16>>;
 	using samap = std::map<smapstring, int, std::less<>, StackAllocatorTS<std::pair<smapstring const, int>, 16>>;
-	StackAllocatorTS<smapstring, 16> la2{ 2048 };
+	SArenaTS<16> arena2{ 2048 };
+	StackAllocatorTS<smapstring, 16> la2{ &arena2 };
 
 	std::cout << sizeof(samap) << '\n';
 	std::cout << sizeof(std::map<std::string, int>) << '\n';
@@ -187,7 +194,8 @@ int stressTest()
 
 
 	std::cout << "\nIndividual allocations" << '\n';
-	StackAllocatorTS<int, 256> la6(1024);
+	SArenaTS<256> arena6(1024);
+	StackAllocatorTS<int, 256> la6(&arena6);
 	int* pi = la6.allocate(1);
 	new(pi) int{ 4 };
 	std::cout << *pi << '\n';
@@ -200,7 +208,8 @@ int stressTest()
 
 	std::cout << "few allocator tests.." << '\n';
 	{
-		StackAllocatorTS<int, 16> salo{ 1024 };
+		SArenaTS<16> saloArena{ 1024 };
+		StackAllocatorTS<int, 16> salo{ &saloArena };
 		StackAllocatorTS<int, 16> salo2{ salo };
 		//StackAllocatorTS<int, 32> salo3{salo2}; // incompatible!
 		StackAllocatorTS<int, 16> salo4 = std::move(salo);
@@ -209,9 +218,12 @@ int stressTest()
 		// StackAllocatorTS<char, 32> saloc3 = std::move(saloc);	// nope!
 		StackAllocatorTS<void, 16> saloc4 = std::move(saloc);
 		StackAllocatorTS<void, 16> saloc5{ saloc4 };
-		std::cout << (saloc == saloc4) << '\n';			// false!
+		std::cout << (saloc == saloc4) << '\n';			// true: same arena
 		std::cout << (saloc4 == saloc5) << '\n';		// true!
-	}// die!
+		SArenaTS<16> otherArena{ 1024 };
+		StackAllocatorTS<void, 16> other{ &otherArena };
+		std::cout << (other == saloc4) << '\n';		// false!
+	}// die! the arenas go after every allocator using them
 
 	return EXIT_SUCCESS;
 }
@@ -1,19 +1,26 @@
 #pragma once
 
 #include <atomic>
-#include <memory>
+#include <iostream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "../allocator_stats.h"
 #include "../allocator_utils.h"
 #include "../assertions.h"
 
 
 template<std::size_t t_alignment = alignof( std::max_align_t )>
-class SArena
+class SArenaTS
 {
 	static inline constexpr std::size_t m_alignment = t_alignment;
 
 	char* m_pData;
 	std::atomic<char*> m_pOffset;
 	std::size_t m_maxSize;
+	std::atomic<std::size_t> m_requestedBytes{0};
+	std::atomic<std::size_t> m_paddingBytes{0};
+	std::atomic<std::size_t> m_nAllocations{0};
 
 	struct Header final
 	{
@@ -26,7 +33,7 @@ public:
 	}
 
 	// defctor
-	//SArena()
+	//SArenaTS()
 	//	: m_pData{ nullptr },
 	//	m_pOffset{ nullptr },
 	//	m_maxSize{ 0 }
@@ -34,14 +41,13 @@ public:
 	//}
 
 	/// \attention! DO NOT malloc inside the initializer list.
-	SArena( std::size_t size )
+	SArenaTS( std::size_t size )
 		:
 		m_maxSize(size)
 	{
 		ASSERT( m_maxSize > 0,
 			"m_maxSize not enough!" );
-		m_pData = (char*)alignedMalloc( m_maxSize,
-			m_alignment );
+		m_pData = (char*)alignedMalloc<m_alignment>( m_maxSize );
 
 		m_pOffset.store( m_pData );
 		if ( m_pData == nullptr )
@@ -50,36 +56,42 @@ public:
 		}
 	}
 
-	~SArena()
+	~SArenaTS()
 	{
 		if ( m_pData != nullptr )
 		{
-			alignedFree( m_pData );
+			alignedFree<m_alignment>( m_pData );
 		}
 	}
 
-	SArena( const SArena& rhs ) = delete;
-	SArena& operator=( const SArena& rhs ) = delete;
+	SArenaTS( const SArenaTS& rhs ) = delete;
+	SArenaTS& operator=( const SArenaTS& rhs ) = delete;
 
-	SArena( SArena&& rhs )
+	SArenaTS( SArenaTS&& rhs )
 	{// delegate work to the maop
 		*this = std::move( rhs );
 	}
-	SArena& operator=( SArena&& rhs )
+	SArenaTS& operator=( SArenaTS&& rhs )
 	{
 		if ( m_pData != nullptr )
 		{
-			alignedFree( m_pData );
+			alignedFree<m_alignment>( m_pData );
 		}
 
 		m_pData = std::move( rhs.m_pData );
 		m_maxSize = rhs.m_maxSize;
 		m_pOffset.store( rhs.m_pOffset.load( std::memory_order_relaxed ) );
+		m_requestedBytes.store( rhs.m_requestedBytes.load( std::memory_order_relaxed ) );
+		m_paddingBytes.store( rhs.m_paddingBytes.load( std::memory_order_relaxed ) );
+		m_nAllocations.store( rhs.m_nAllocations.load( std::memory_order_relaxed ) );
 
 		// destroy the other one
 		rhs.m_pData = nullptr;
 		rhs.m_maxSize = 0;
 		rhs.m_pOffset.store(nullptr);
+		rhs.m_requestedBytes.store( 0 );
+		rhs.m_paddingBytes.store( 0 );
+		rhs.m_nAllocations.store( 0 );
 
 		return *this;
 	}
@@ -93,9 +105,8 @@ public:
 		ASSERT( m_pData != nullptr,
 			"m_pData is null!" );
 
-		std::size_t currentAllocationStartAddress = alignForward(
-			(std::size_t) m_pOffset.load( std::memory_order_relaxed ) + sizeof( Header ),
-			m_alignment );
+		const std::size_t offset = (std::size_t) m_pOffset.load( std::memory_order_relaxed );
+		std::size_t currentAllocationStartAddress = alignForward<m_alignment>( offset + sizeof( Header ) );
 
 #ifdef _DEBUG
 		std::cout << "allocating "
@@ -104,19 +115,24 @@ public:
 			<< currentAllocationStartAddress << '\n';
 #endif // _DEBUG
 
-		// set the new offset
-		m_pOffset.store( (char*)( currentAllocationStartAddress + bytes ) );
-		// check that we haven't run out of memory
-		if ( m_pOffset.load( std::memory_order_relaxed ) <= m_pData + m_maxSize )
-		{
-			( (Header*)
-				( currentAllocationStartAddress - sizeof( Header ) ) )->allocationAddress
-				= currentAllocationStartAddress;
-		}
-		else
+		// check that we haven't run out of memory, before the offset moves, so a failed
+		//	allocation leaves the arena as it was
+		if ( currentAllocationStartAddress > getEndAddress()
+			|| bytes > getEndAddress() - currentAllocationStartAddress )
 		{
 			throw std::bad_alloc{};
 		}
+		// set the new offset
+		m_pOffset.store( (char*)( currentAllocationStartAddress + bytes ) );
+		( (Header*)
+			( currentAllocationStartAddress - sizeof( Header ) ) )->allocationAddress
+			= currentAllocationStartAddress;
+		m_requestedBytes.fetch_add( bytes,
+			std::memory_order_relaxed );
+		m_paddingBytes.fetch_add( currentAllocationStartAddress - sizeof( Header ) - offset,
+			std::memory_order_relaxed );
+		m_nAllocations.fetch_add( 1,
+			std::memory_order_relaxed );
 		return reinterpret_cast<void*>( currentAllocationStartAddress );
 	}
 
@@ -163,6 +179,9 @@ public:
 		ASSERT( m_pData != nullptr,
 			"m_pData is null!" );
 		m_pOffset.store( m_pData );
+		m_requestedBytes.store( 0 );
+		m_paddingBytes.store( 0 );
+		m_nAllocations.store( 0 );
 	}
 
 	std::size_t getAvailableMemory() const noexcept
@@ -170,6 +189,31 @@ public:
 		return getEndAddress() - reinterpret_cast<std::size_t>( m_pOffset.load( std::memory_order_relaxed ) );
 	}
 
+	// deallocate() does not hand memory back, so every allocation since the last reset is accounted for
+	// the snapshot is not atomic as a whole while other threads keep allocating
+	AllocatorStats getStats() const noexcept
+	{
+		AllocatorStats stats;
+		stats.requestedBytes = m_requestedBytes.load( std::memory_order_relaxed );
+		stats.paddingBytes = m_paddingBytes.load( std::memory_order_relaxed );
+		stats.headerBytes = m_nAllocations.load( std::memory_order_relaxed ) * sizeof( Header );
+		stats.freeBytes = getAvailableMemory();
+		const std::size_t nextStartAddress = alignForward<m_alignment>(
+			(std::size_t) m_pOffset.load( std::memory_order_relaxed ) + sizeof( Header ) );
+		stats.largestFreeBlock = nextStartAddress < getEndAddress() ?
+			getEndAddress() - nextStartAddress :
+			0;
+		stats.totalBytes = m_maxSize;
+		return stats;
+	}
+
+	// whether `p` points into this arena's memory
+	bool owns( const void* p ) const noexcept
+	{
+		const std::size_t address = reinterpret_cast<std::size_t>( p );
+		return address >= reinterpret_cast<std::size_t>( m_pData ) && address < getEndAddress();
+	}
+
 	// GETTERS
 	char* getStartAddress() const noexcept
 	{
@@ -207,7 +251,11 @@ public:
 //		What makes it thread safe?
 //			1. making the top of the stack pool m_pOffset atomic
 //			2. performing any write operations on it atomically
-//			3. having a shared_ptr instead of a raw pointer to the Arena
+//			3. the allocator is only a raw handle to the arena, which the user owns and keeps
+//				alive for as long as any allocator or container uses it
+//				containers copy and rebind their allocator all the time; a shared_ptr would turn
+//				every one of those copies into an atomic increment and decrement on the arena's
+//				control block, one cache line all threads fight over
 //======================================================================
 template<typename T, std::size_t t_alignment = alignof( std::max_align_t )>
 class StackAllocatorTS
@@ -218,26 +266,37 @@ class StackAllocatorTS
 	template<typename U, std::size_t t_otherAlignment>
 	friend class StackAllocatorTS;
 
-	using TSArena = SArena<t_alignment>;
+	using TSArena = SArenaTS<t_alignment>;
 
-	std::shared_ptr<TSArena> m_pArena;
+	TSArena* m_pArena;
 public:
 	using value_type = T;
 	using size_type = std::size_t;
 	using difference_type = ptrdiff_t;
 	using pointer = T * ;
-	using const_pointer = T * const;
+	using const_pointer = const T*;
 	using reference = T & ;
 	using const_reference = const T&;
 
+	// see `LinearAllocator`: containers keep their arena, so nested ones built through
+	//	std::scoped_allocator_adaptor all end up on the outer container's arena
+	using propagate_on_container_copy_assignment = std::false_type;
+	using propagate_on_container_move_assignment = std::false_type;
+	using propagate_on_container_swap = std::false_type;
+	using is_always_equal = std::false_type;
+
 	StackAllocatorTS() noexcept
+		:
+		m_pArena{nullptr}
 	{
 
 	}
 
-	StackAllocatorTS( std::size_t bytes ) noexcept
+	explicit StackAllocatorTS( TSArena* pArena ) noexcept
+		:
+		m_pArena{pArena}
 	{
-		m_pArena = std::make_shared<TSArena>( bytes );
+
 	}
 
 	~StackAllocatorTS()
@@ -277,7 +336,7 @@ public:
 	}
 
 	template<typename Other>
-	StackAllocatorTS( const StackAllocatorTS<Other>&& rhs ) noexcept
+	StackAllocatorTS( const StackAllocatorTS<Other, t_alignment>&& rhs ) noexcept
 		:
 		m_pArena{rhs.m_pArena}
 	{
@@ -290,6 +349,13 @@ public:
 		using other = StackAllocatorTS<U, t_alignment>;
 	};
 
+	// true if both allocate from the same arena, whatever their value types
+	template<typename U>
+	bool isSameArena( const StackAllocatorTS<U, t_alignment>& rhs ) const noexcept
+	{
+		return m_pArena == rhs.m_pArena;
+	}
+
 	T* address( T& x ) const noexcept
 	{
 		return &x;
@@ -376,6 +442,11 @@ public:
 		return m_pArena->getAvailableMemory();
 	}
 
+	AllocatorStats getStats() const noexcept
+	{
+		return m_pArena->getStats();
+	}
+
 	constexpr std::size_t getAlignment() const noexcept
 	{
 		return m_pArena->getAlignment();
@@ -400,24 +471,35 @@ class StackAllocatorTS<void, t_alignment>
 	template<typename U, std::size_t t_otherAlignment>
 	friend class StackAllocatorTS;
 
-	using TSArena = SArena<t_alignment>;
+	using TSArena = SArenaTS<t_alignment>;
 
-	std::shared_ptr<TSArena> m_pArena;
+	TSArena* m_pArena;
 public:
 	using value_type = void;
 	using size_type = std::size_t;
 	using difference_type = ptrdiff_t;
 	using pointer = void*;
-	using const_pointer = void* const;
+	using const_pointer = const void*;
+
+	// see `LinearAllocator`: containers keep their arena, so nested ones built through
+	//	std::scoped_allocator_adaptor all end up on the outer container's arena
+	using propagate_on_container_copy_assignment = std::false_type;
+	using propagate_on_container_move_assignment = std::false_type;
+	using propagate_on_container_swap = std::false_type;
+	using is_always_equal = std::false_type;
 
 	StackAllocatorTS() noexcept
+		:
+		m_pArena{nullptr}
 	{
 
 	}
 
-	StackAllocatorTS( std::size_t bytes ) noexcept
+	explicit StackAllocatorTS( TSArena* pArena ) noexcept
+		:
+		m_pArena{pArena}
 	{
-		m_pArena = std::make_shared<TSArena>( bytes );
+
 	}
 
 	~StackAllocatorTS()
@@ -457,7 +539,7 @@ public:
 	}
 
 	template<typename Other>
-	StackAllocatorTS( const StackAllocatorTS<Other>&& rhs ) noexcept
+	StackAllocatorTS( const StackAllocatorTS<Other, t_alignment>&& rhs ) noexcept
 		:
 		m_pArena{rhs.m_pArena}
 	{
@@ -470,6 +552,13 @@ public:
 		using other = StackAllocatorTS<U, t_alignment>;
 	};
 
+	// true if both allocate from the same arena, whatever their value types
+	template<typename U>
+	bool isSameArena( const StackAllocatorTS<U, t_alignment>& rhs ) const noexcept
+	{
+		return m_pArena == rhs.m_pArena;
+	}
+
 	[[nodiscard]]
 	void* allocate( std::size_t count,
 		const void* hint = nullptr )
@@ -537,6 +626,11 @@ public:
 		return m_pArena->getAvailableMemory();
 	}
 
+	AllocatorStats getStats() const noexcept
+	{
+		return m_pArena->getStats();
+	}
+
 	std::size_t getSize() const noexcept
 	{
 		return m_pArena->getMaxSize();
@@ -544,32 +638,32 @@ public:
 };
 
 
-// an other allocator of the same type can deallocate from this one
-template<typename T, std::size_t t_alignment, std::size_t t_otherAlignment>
-inline bool operator==( const StackAllocatorTS<T, t_alignment>&,
-	const StackAllocatorTS<T, t_otherAlignment>& )
+// allocators on the same arena can deallocate each other's memory, whatever their value types
+template<typename T, typename U, std::size_t t_alignment>
+inline bool operator==( const StackAllocatorTS<T, t_alignment>& lhs,
+	const StackAllocatorTS<U, t_alignment>& rhs ) noexcept
 {
-	return true;
+	return lhs.isSameArena( rhs );
 }
 // equivalent statement:
-template<typename T, std::size_t t_alignment, std::size_t t_otherAlignment>
-inline bool operator!=( const StackAllocatorTS<T, t_alignment>&,
-	const StackAllocatorTS<T, t_otherAlignment>& )
+template<typename T, typename U, std::size_t t_alignment>
+inline bool operator!=( const StackAllocatorTS<T, t_alignment>& lhs,
+	const StackAllocatorTS<U, t_alignment>& rhs ) noexcept
 {
-	return false;
+	return !lhs.isSameArena( rhs );
 }
 
-// an other allocator of a different type cannot deallocate from this one
+// an allocator of another alignment or kind cannot deallocate from this one
 template<typename T, std::size_t t_alignment, typename OtherAllocator>
 inline bool operator==( const StackAllocatorTS<T, t_alignment>&,
-	const OtherAllocator& )
+	const OtherAllocator& ) noexcept
 {
 	return false;
 }
 // equivalent statement:
 template<typename T, std::size_t t_alignment, typename OtherAllocator>
 inline bool operator!=( const StackAllocatorTS<T, t_alignment>&,
-	const OtherAllocator&)
+	const OtherAllocator& ) noexcept
 {
 	return true;
 }
@@ -0,0 +1,91 @@
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include "tlsf_allocator.h"
+
+
+struct alignas( 64 ) CacheLine
+{
+	float values[16];
+};
+
+static void printStats( const char* name,
+	const TlsfHeap& heap )
+{
+	const AllocatorStats stats = heap.getStats();
+	std::cout << name
+		<< ": allocated="
+		<< stats.requestedBytes
+		<< " headers="
+		<< stats.headerBytes
+		<< " free="
+		<< stats.freeBytes
+		<< " largest free block="
+		<< stats.largestFreeBlock
+		<< " external fragmentation="
+		<< stats.getExternalFragmentation()
+		<< '\n';
+}
+
+int main()
+{
+	std::cout << std::boolalpha << '\n';
+
+	TlsfHeap heap{256 * 1024};
+	printStats( "empty",
+		heap );
+
+	// variable sizes, freed in any order; neighbours merge as soon as they're both free
+	std::vector<void*> blocks;
+	for ( std::size_t i = 0; i < 64; ++i )
+	{
+		blocks.push_back( heap.allocate( 16 + i * 40 ) );
+	}
+	for ( std::size_t i = 0; i < blocks.size(); i += 2 )
+	{
+		heap.deallocate( blocks[i] );
+	}
+	printStats( "every other block freed",
+		heap );
+	for ( std::size_t i = 1; i < blocks.size(); i += 2 )
+	{
+		heap.deallocate( blocks[i] );
+	}
+	printStats( "all freed",
+		heap );
+
+	void* pPage = heap.allocateAligned( 1000,
+		4096 );
+	std::cout << "4096 aligned="
+		<< isAligned( pPage, 4096 )
+		<< '\n';
+	heap.deallocate( pPage );
+
+	// std containers, one of them with an over-aligned element type
+	{
+		using tstring = std::basic_string<char, std::char_traits<char>, TlsfAllocator<char>>;
+		TlsfAllocator<char> alloc{&heap};
+		std::vector<CacheLine, TlsfAllocator<CacheLine>> lines{TlsfAllocator<CacheLine>{alloc}};
+		std::map<int, tstring, std::less<>, TlsfAllocator<std::pair<const int, tstring>>> names{TlsfAllocator<std::pair<const int, tstring>>{alloc}};
+		for ( int i = 0; i < 100; ++i )
+		{
+			lines.push_back( CacheLine{} );
+			names.emplace( i,
+				tstring{"a name long enough to need the heap, number " + std::to_string( i ), alloc} );
+		}
+		std::cout << "lines aligned="
+			<< isAligned( lines.data(), alignof( CacheLine ) )
+			<< " names[42]="
+			<< names.at( 42 )
+			<< '\n';
+		printStats( "containers",
+			heap );
+	}
+	printStats( "containers destroyed",
+		heap );
+
+	std::system( "pause" );
+	return 0;
+}
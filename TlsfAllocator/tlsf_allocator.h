@@ -0,0 +1,577 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include "../allocator_stats.h"
+#include "../allocator_utils.h"
+#include "../assertions.h"
+
+
+//======================================================================
+// \class	TlsfHeap
+//
+// \brief	Two-Level Segregated Fit: general allocation with O(1) worst case `allocate()` and
+//				`deallocate()`, for paths that can't afford malloc's occasional long call
+//			free blocks are kept in lists by size class: the first level is the power of 2 the
+//				size falls in, the second splits that range linearly into `m_slCount` classes;
+//				a bitmap per level marks the non-empty lists, so the smallest class that fits a
+//				request is found with two count trailing zeros, never a search
+//			the request is rounded up to the next class boundary first, so any block of that
+//				class fits ("good fit"); the rest of the block is split off and freed
+//			freed blocks merge immediately with free neighbours, found through the header's
+//				previous block pointer and the block size
+//			every block has a 16 byte header; payloads are 16 byte aligned, and
+//				`allocateAligned()` serves larger alignments by splitting off a free gap in front
+//			works in place over one preallocated block, like `Arena`
+//			not thread safe
+//======================================================================
+class TlsfHeap
+{
+	struct Block final
+	{
+		// the block right before this one in memory
+		Block* pPrevPhys;
+		// payload bytes; the lowest bit is set while the block is free
+		std::size_t sizeAndFree;
+		// payload starts here; free blocks keep their list links in it
+		Block* pNextFree;
+		Block* pPrevFree;
+
+		std::size_t getSize() const noexcept
+		{
+			return sizeAndFree & ~std::size_t{1};
+		}
+
+		bool isFree() const noexcept
+		{
+			return ( sizeAndFree & 1 ) != 0;
+		}
+
+		void setSize( const std::size_t size ) noexcept
+		{
+			sizeAndFree = size | ( sizeAndFree & 1 );
+		}
+
+		void setFree( const bool bFree ) noexcept
+		{
+			sizeAndFree = getSize() | static_cast<std::size_t>( bFree );
+		}
+
+		void* getPayload() noexcept
+		{
+			return reinterpret_cast<unsigned char*>( this ) + m_headerSize;
+		}
+
+		Block* getNextPhys() noexcept
+		{
+			return reinterpret_cast<Block*>( reinterpret_cast<unsigned char*>( getPayload() ) + getSize() );
+		}
+	};
+
+	static constexpr std::size_t m_alignment = 16;
+	static constexpr std::size_t m_headerSize = 2 * sizeof( void* );
+	// a free block's payload holds the list links
+	static constexpr std::size_t m_minPayload = 2 * sizeof( void* );
+	static constexpr std::size_t m_minBlockSize = m_headerSize + m_minPayload;
+	static constexpr std::size_t m_slCountLog2 = 5;
+	static constexpr std::size_t m_slCount = std::size_t{1} << m_slCountLog2;
+	// sizes below `m_smallSize` share the first level, in `m_slCount` classes of `m_alignment` bytes
+	static constexpr std::size_t m_flShift = m_slCountLog2 + 4;
+	static constexpr std::size_t m_smallSize = std::size_t{1} << m_flShift;
+	// the largest block is below 2^`m_flMax`
+	static constexpr std::size_t m_flMax = 40;
+	static constexpr std::size_t m_flCount = m_flMax - m_flShift + 1;
+
+	static_assert( m_headerSize <= m_alignment && m_minPayload % m_alignment == 0,
+		"TlsfHeap headers must keep the payloads aligned." );
+
+	unsigned char* m_pData;
+	std::size_t m_size;
+	std::uint64_t m_flBitmap;
+	std::uint32_t m_slBitmaps[m_flCount];
+	Block* m_freeLists[m_flCount][m_slCount];
+	// payload bytes of the allocated blocks
+	std::size_t m_allocatedBytes;
+	std::size_t m_nAllocations;
+	std::size_t m_nFreeBlocks;
+public:
+	explicit TlsfHeap( const std::size_t size )
+		:
+		m_pData{static_cast<unsigned char*>( alignedMalloc<m_alignment>( size ) )},
+		m_size{size & ~( m_alignment - 1 )},
+		m_flBitmap{0},
+		m_slBitmaps{},
+		m_freeLists{},
+		m_allocatedBytes{0},
+		m_nAllocations{0},
+		m_nFreeBlocks{0}
+	{
+		ASSERT( m_size >= m_minBlockSize + m_headerSize,
+			"TlsfHeap too small!" );
+		ASSERT( m_size < ( std::size_t{1} << m_flMax ),
+			"TlsfHeap too large for its size classes!" );
+		reset();
+	}
+
+	~TlsfHeap() noexcept
+	{
+		alignedFree<m_alignment>( m_pData );
+	}
+
+	TlsfHeap( const TlsfHeap& rhs ) = delete;
+	TlsfHeap& operator=( const TlsfHeap& rhs ) = delete;
+
+	// 16 byte aligned; throws std::bad_alloc if no free block is large enough
+	[[nodiscard]]
+	void* allocate( const std::size_t bytes )
+	{
+		const std::size_t size = getAdjustedSize( bytes );
+		Block* pBlock = takeSuitableBlock( size );
+		trimBack( pBlock,
+			size );
+		return markUsed( pBlock );
+	}
+
+	// `alignment` must be a power of 2
+	[[nodiscard]]
+	void* allocateAligned( const std::size_t bytes,
+		const std::size_t alignment )
+	{
+		ASSERT( isPowerOfTwo( alignment ),
+			"Alignment value must be a power of 2." );
+		if ( alignment <= m_alignment )
+		{
+			return allocate( bytes );
+		}
+		if ( alignment > m_size )
+		{
+			throw std::bad_alloc{};
+		}
+		const std::size_t size = getAdjustedSize( bytes );
+		// room for the worst gap in front, which has to be a whole free block
+		//	both terms are at most `m_size`, below 2^`m_flMax`, so the sum can't wrap
+		Block* pBlock = takeSuitableBlock( size + alignment + m_minBlockSize );
+		const std::uintptr_t payload = reinterpret_cast<std::uintptr_t>( pBlock->getPayload() );
+		std::uintptr_t alignedPayload = alignForward( payload,
+			alignment );
+		if ( alignedPayload != payload && alignedPayload - payload < m_minBlockSize )
+		{
+			alignedPayload = alignForward( payload + m_minBlockSize,
+				alignment );
+		}
+		if ( alignedPayload != payload )
+		{
+			pBlock = trimFront( pBlock,
+				alignedPayload - payload );
+		}
+		trimBack( pBlock,
+			size );
+		return markUsed( pBlock );
+	}
+
+	void deallocate( void* p,
+		[[maybe_unused]] std::size_t count = 0 ) noexcept
+	{
+		if ( p == nullptr )
+		{
+			return;
+		}
+		ASSERT( owns( p ),
+			"Pointer not from this TlsfHeap!" );
+		Block* pBlock = getBlock( p );
+		ASSERT( !pBlock->isFree(),
+			"TlsfHeap block freed twice!" );
+		m_allocatedBytes -= pBlock->getSize();
+		--m_nAllocations;
+		pBlock->setFree( true );
+		pBlock = mergePrev( pBlock );
+		pBlock = mergeNext( pBlock );
+		insertFree( pBlock );
+	}
+
+	// the payload bytes of the block `p` points to, at least what was asked for
+	std::size_t getUsableSize( const void* p ) const noexcept
+	{
+		return getBlock( p )->getSize();
+	}
+
+	// frees everything at once: the heap is one free block again
+	void reset() noexcept
+	{
+		m_flBitmap = 0;
+		for ( std::size_t fl = 0; fl < m_flCount; ++fl )
+		{
+			m_slBitmaps[fl] = 0;
+			for ( std::size_t sl = 0; sl < m_slCount; ++sl )
+			{
+				m_freeLists[fl][sl] = nullptr;
+			}
+		}
+		m_allocatedBytes = 0;
+		m_nAllocations = 0;
+		m_nFreeBlocks = 0;
+		Block* pBlock = reinterpret_cast<Block*>( m_pData );
+		pBlock->pPrevPhys = nullptr;
+		pBlock->sizeAndFree = m_size - 2 * m_headerSize;
+		pBlock->setFree( true );
+		// a used, empty block at the end stops merges from running off the heap
+		Block* pSentinel = pBlock->getNextPhys();
+		pSentinel->pPrevPhys = pBlock;
+		pSentinel->sizeAndFree = 0;
+		insertFree( pBlock );
+	}
+
+	// the largest block is found among the free lists of the highest non-empty class
+	//	blocks don't record the size asked for, so the payloads count as requested bytes
+	//	every block has a header, free or not, plus the sentinel's; free bytes are free payloads
+	AllocatorStats getStats() const noexcept
+	{
+		AllocatorStats stats;
+		stats.requestedBytes = m_allocatedBytes;
+		stats.headerBytes = ( m_nAllocations + m_nFreeBlocks + 1 ) * m_headerSize;
+		stats.freeBytes = m_size - m_allocatedBytes - stats.headerBytes;
+		if ( m_flBitmap != 0 )
+		{
+			const std::size_t fl = floorLog2( m_flBitmap );
+			const std::size_t sl = floorLog2( m_slBitmaps[fl] );
+			for ( const Block* pBlock = m_freeLists[fl][sl]; pBlock != nullptr; pBlock = pBlock->pNextFree )
+			{
+				if ( pBlock->getSize() > stats.largestFreeBlock )
+				{
+					stats.largestFreeBlock = pBlock->getSize();
+				}
+			}
+		}
+		stats.totalBytes = m_size;
+		return stats;
+	}
+
+	bool owns( const void* p ) const noexcept
+	{
+		const std::size_t address = reinterpret_cast<std::size_t>( p );
+		return address >= reinterpret_cast<std::size_t>( m_pData )
+			&& address < reinterpret_cast<std::size_t>( m_pData ) + m_size;
+	}
+
+	// GETTERS
+	char* getStartAddress() const noexcept
+	{
+		return reinterpret_cast<char*>( m_pData );
+	}
+
+	std::size_t getSize() const noexcept
+	{
+		return m_size;
+	}
+
+	static constexpr std::size_t getAlignment() noexcept
+	{
+		return m_alignment;
+	}
+
+	static constexpr std::size_t getHeaderSize() noexcept
+	{
+		return m_headerSize;
+	}
+private:
+	// throws std::bad_alloc for more than the heap holds, before rounding up can wrap
+	std::size_t getAdjustedSize( const std::size_t bytes ) const
+	{
+		if ( bytes > m_size )
+		{
+			throw std::bad_alloc{};
+		}
+		const std::size_t size = calcAlignedSize( bytes,
+			m_alignment );
+		return size < m_minPayload ?
+			m_minPayload :
+			size;
+	}
+
+	static Block* getBlock( const void* p ) noexcept
+	{
+		return reinterpret_cast<Block*>( reinterpret_cast<std::uintptr_t>( p ) - m_headerSize );
+	}
+
+	// the class `size` belongs to
+	static void mapping( const std::size_t size,
+		std::size_t& fl,
+		std::size_t& sl ) noexcept
+	{
+		if ( size < m_smallSize )
+		{
+			fl = 0;
+			sl = size / ( m_smallSize / m_slCount );
+		}
+		else
+		{
+			const std::size_t log2 = floorLog2( size );
+			sl = ( size >> ( log2 - m_slCountLog2 ) ) ^ m_slCount;
+			fl = log2 - m_flShift + 1;
+		}
+	}
+
+	// removes and returns a free block of at least `size` bytes
+	//	`size` is rounded up to the next class, so the first block of that class fits
+	Block* takeSuitableBlock( std::size_t size )
+	{
+		if ( size >= m_smallSize )
+		{
+			size += ( std::size_t{1} << ( floorLog2( size ) - m_slCountLog2 ) ) - 1;
+		}
+		std::size_t fl;
+		std::size_t sl;
+		mapping( size,
+			fl,
+			sl );
+		if ( fl >= m_flCount )
+		{
+			throw std::bad_alloc{};
+		}
+		std::uint32_t slMap = m_slBitmaps[fl] & ( ~std::uint32_t{0} << sl );
+		if ( slMap == 0 )
+		{
+			const std::uint64_t flMap = fl + 1 < 64 ?
+				m_flBitmap & ( ~std::uint64_t{0} << ( fl + 1 ) ) :
+				0;
+			if ( flMap == 0 )
+			{
+				throw std::bad_alloc{};
+			}
+			fl = countTrailingZeros( flMap );
+			slMap = m_slBitmaps[fl];
+		}
+		sl = countTrailingZeros( slMap );
+		Block* pBlock = m_freeLists[fl][sl];
+		removeFree( pBlock,
+			fl,
+			sl );
+		return pBlock;
+	}
+
+	void insertFree( Block* pBlock ) noexcept
+	{
+		std::size_t fl;
+		std::size_t sl;
+		mapping( pBlock->getSize(),
+			fl,
+			sl );
+		Block* pHead = m_freeLists[fl][sl];
+		pBlock->pNextFree = pHead;
+		pBlock->pPrevFree = nullptr;
+		if ( pHead != nullptr )
+		{
+			pHead->pPrevFree = pBlock;
+		}
+		m_freeLists[fl][sl] = pBlock;
+		++m_nFreeBlocks;
+		m_flBitmap |= std::uint64_t{1} << fl;
+		m_slBitmaps[fl] |= std::uint32_t{1} << sl;
+	}
+
+	void removeFree( Block* pBlock,
+		const std::size_t fl,
+		const std::size_t sl ) noexcept
+	{
+		if ( pBlock->pPrevFree != nullptr )
+		{
+			pBlock->pPrevFree->pNextFree = pBlock->pNextFree;
+		}
+		else
+		{
+			m_freeLists[fl][sl] = pBlock->pNextFree;
+			if ( pBlock->pNextFree == nullptr )
+			{
+				m_slBitmaps[fl] &= ~( std::uint32_t{1} << sl );
+				if ( m_slBitmaps[fl] == 0 )
+				{
+					m_flBitmap &= ~( std::uint64_t{1} << fl );
+				}
+			}
+		}
+		if ( pBlock->pNextFree != nullptr )
+		{
+			pBlock->pNextFree->pPrevFree = pBlock->pPrevFree;
+		}
+		--m_nFreeBlocks;
+	}
+
+	void removeFree( Block* pBlock ) noexcept
+	{
+		std::size_t fl;
+		std::size_t sl;
+		mapping( pBlock->getSize(),
+			fl,
+			sl );
+		removeFree( pBlock,
+			fl,
+			sl );
+	}
+
+	// splits the bytes past `size` off into a free block, if they make one
+	void trimBack( Block* pBlock,
+		const std::size_t size ) noexcept
+	{
+		if ( pBlock->getSize() < size + m_minBlockSize )
+		{
+			return;
+		}
+		Block* pRest = reinterpret_cast<Block*>( reinterpret_cast<unsigned char*>( pBlock->getPayload() ) + size );
+		pRest->pPrevPhys = pBlock;
+		pRest->sizeAndFree = pBlock->getSize() - size - m_headerSize;
+		pRest->setFree( true );
+		pRest->getNextPhys()->pPrevPhys = pRest;
+		pBlock->setSize( size );
+		// the block after the rest was in use, or the rest would have been part of a larger free block
+		insertFree( pRest );
+	}
+
+	// splits `gap` bytes off the front into a free block and returns the block after them
+	Block* trimFront( Block* pBlock,
+		const std::size_t gap ) noexcept
+	{
+		Block* pAligned = reinterpret_cast<Block*>( reinterpret_cast<unsigned char*>( pBlock ) + gap );
+		pAligned->pPrevPhys = pBlock;
+		pAligned->sizeAndFree = pBlock->getSize() - gap;
+		pAligned->getNextPhys()->pPrevPhys = pAligned;
+		pBlock->setSize( gap - m_headerSize );
+		pBlock->setFree( true );
+		insertFree( pBlock );
+		return pAligned;
+	}
+
+	void* markUsed( Block* pBlock ) noexcept
+	{
+		pBlock->setFree( false );
+		m_allocatedBytes += pBlock->getSize();
+		++m_nAllocations;
+		return pBlock->getPayload();
+	}
+
+	Block* mergePrev( Block* pBlock ) noexcept
+	{
+		Block* pPrev = pBlock->pPrevPhys;
+		if ( pPrev == nullptr || !pPrev->isFree() )
+		{
+			return pBlock;
+		}
+		removeFree( pPrev );
+		pPrev->setSize( pPrev->getSize() + m_headerSize + pBlock->getSize() );
+		pPrev->getNextPhys()->pPrevPhys = pPrev;
+		return pPrev;
+	}
+
+	Block* mergeNext( Block* pBlock ) noexcept
+	{
+		Block* pNext = pBlock->getNextPhys();
+		if ( !pNext->isFree() )
+		{
+			return pBlock;
+		}
+		removeFree( pNext );
+		pBlock->setSize( pBlock->getSize() + m_headerSize + pNext->getSize() );
+		pBlock->getNextPhys()->pPrevPhys = pBlock;
+		return pBlock;
+	}
+};
+
+
+//----------------------------------------------------------------------------------------
+// TlsfAllocator
+//
+// \brief	std allocator over a `TlsfHeap`, which it doesn't own; over-aligned types go
+//				through `TlsfHeap::allocateAligned()`
+//			as with `LinearAllocator`, a container keeps the heap it was constructed with
+//----------------------------------------------------------------------------------------
+template<typename T>
+class TlsfAllocator
+{
+	TlsfHeap* m_pHeap;
+public:
+	using value_type = T;
+	using pointer = T*;
+
+	using propagate_on_container_copy_assignment = std::false_type;
+	using propagate_on_container_move_assignment = std::false_type;
+	using propagate_on_container_swap = std::false_type;
+	using is_always_equal = std::false_type;
+
+	explicit TlsfAllocator( TlsfHeap* pHeap ) noexcept
+		:
+		m_pHeap{pHeap}
+	{
+
+	}
+
+	TlsfAllocator( const TlsfAllocator& rhs ) noexcept
+		:
+		m_pHeap{rhs.getHeap()}
+	{
+
+	}
+
+	template<typename Other>
+	TlsfAllocator( const TlsfAllocator<Other>& rhs ) noexcept
+		:
+		m_pHeap{rhs.getHeap()}
+	{
+
+	}
+
+	template<typename Other>
+	struct rebind
+	{
+		using other = TlsfAllocator<Other>;
+	};
+
+	[[nodiscard]]
+	T* allocate( std::size_t count )
+	{
+		if ( count > ~std::size_t{0} / sizeof( T ) )
+		{
+			throw std::bad_alloc{};
+		}
+		if constexpr ( alignof( T ) > TlsfHeap::getAlignment() )
+		{
+			return static_cast<T*>( m_pHeap->allocateAligned( count * sizeof( T ),
+				alignof( T ) ) );
+		}
+		else
+		{
+			return static_cast<T*>( m_pHeap->allocate( count * sizeof( T ) ) );
+		}
+	}
+
+	void deallocate( T* p,
+		std::size_t count ) noexcept
+	{
+		m_pHeap->deallocate( p,
+			count * sizeof( T ) );
+	}
+
+	TlsfHeap* getHeap() const noexcept
+	{
+		return m_pHeap;
+	}
+
+	AllocatorStats getStats() const noexcept
+	{
+		return m_pHeap->getStats();
+	}
+};
+
+template<typename T, typename Other>
+inline bool operator==( const TlsfAllocator<T>& lhs,
+	const TlsfAllocator<Other>& rhs ) noexcept
+{
+	return lhs.getHeap() == rhs.getHeap();
+}
+
+template<typename T, typename Other>
+inline bool operator!=( const TlsfAllocator<T>& lhs,
+	const TlsfAllocator<Other>& rhs ) noexcept
+{
+	return lhs.getHeap() != rhs.getHeap();
+}
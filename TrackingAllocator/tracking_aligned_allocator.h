@@ -3,6 +3,8 @@
 #include <memory>
 #include <cstddef>
 #include <limits>
+#include <stdexcept>
+#include "../allocator_stats.h"
 #include "../allocator_utils.h"
 #include "../assertions.h"
 
@@ -18,9 +20,11 @@
 //				boundary specified
 //			C++03 + compatible allocator with tracking capability
 //				ie. tracking the amount of allocation calls
+//			with `cacheLinePadded` every allocation starts on a `cacheLineSize` boundary and
+//				is rounded up to it, so separate allocations never share a cache line
 //----------------------------------------------------------------------------------------
-template<typename T, std::size_t alignment = alignof( std::max_align_t )>
-class TrackingAlignedAllocator final
+template<typename T, std::size_t alignment = alignof( std::max_align_t ), bool cacheLinePadded = false>
+class TrackingAlignedAllocator
 {
 	static_assert( isPowerOfTwo( alignment ),
 		"Alignment value must be a power of 2." );
@@ -30,10 +34,10 @@ public:
 	using difference_type = std::ptrdiff_t;
 	// optional (custom) aliases:
 	using void_pointer = void*;
-	using const_void_pointer = void* const;
+	using const_void_pointer = const void*;
 	// the following aliases are deprecated in C++17 and removed in C++20:
 	using pointer = T*;
-	using const_pointer = T* const;
+	using const_pointer = const T*;
 	using reference = T& ;
 	using const_reference = const T&;
 
@@ -43,10 +47,14 @@ public:
 	//using is_always_equal							= std::is_empty<TrackingAlignedAllocator>;
 private:
 	std::size_t m_nAllocations;
+	std::size_t m_requestedBytes;
+	std::size_t m_paddingBytes;
 public:
 	TrackingAlignedAllocator()
 		:
-		m_nAllocations{0}	
+		m_nAllocations{0},
+		m_requestedBytes{0},
+		m_paddingBytes{0}
 	{
 
 	}
@@ -58,57 +66,73 @@ public:
 
 	// \struct Rebinding constructor - required
 	//[[deprecated("rebind is deprecated in C++17 and will be removed in C++20")]]
-	template<typename Other, std::size_t OtherAlignment = alignof( std::max_align_t )>
+	template<typename Other, std::size_t OtherAlignment = alignment>
 	struct rebind
 	{
-		using other = TrackingAlignedAllocator<Other, OtherAlignment>;
+		using other = TrackingAlignedAllocator<Other, OtherAlignment, cacheLinePadded>;
 	};
 	
 	TrackingAlignedAllocator( TrackingAlignedAllocator& rhs ) noexcept
 		:
-		m_nAllocations{rhs.getAllocations()}
+		m_nAllocations{rhs.getAllocations()},
+		m_requestedBytes{rhs.getStats().requestedBytes},
+		m_paddingBytes{rhs.getStats().paddingBytes}
 	{
 
 	}
 
-	template<typename Other, std::size_t OtherAlignment>
+	template<typename Other, std::size_t OtherAlignment, bool otherPadded>
 	TrackingAlignedAllocator( const TrackingAlignedAllocator<Other,
-			OtherAlignment>& rhs ) noexcept
+			OtherAlignment,
+			otherPadded>& rhs ) noexcept
 		:
-		m_nAllocations{rhs.getAllocations()}
+		m_nAllocations{rhs.getAllocations()},
+		m_requestedBytes{rhs.getStats().requestedBytes},
+		m_paddingBytes{rhs.getStats().paddingBytes}
 	{
 
 	}
 
-	template<typename Other, std::size_t OtherAlignment>
+	template<typename Other, std::size_t OtherAlignment, bool otherPadded>
 	TrackingAlignedAllocator& operator=( TrackingAlignedAllocator<Other,
-			OtherAlignment>& rhs ) noexcept
+			OtherAlignment,
+			otherPadded>& rhs ) noexcept
 	{
 		m_nAllocations = rhs.getAllocations();
+		m_requestedBytes = rhs.getStats().requestedBytes;
+		m_paddingBytes = rhs.getStats().paddingBytes;
 		return *this;
 	}
 
 	TrackingAlignedAllocator( TrackingAlignedAllocator&& rhs ) noexcept
 		:
-		m_nAllocations{rhs.getAllocations()}
+		m_nAllocations{rhs.getAllocations()},
+		m_requestedBytes{rhs.getStats().requestedBytes},
+		m_paddingBytes{rhs.getStats().paddingBytes}
 	{
 
 	}
 
-	template<typename Other, std::size_t OtherAlignment>
+	template<typename Other, std::size_t OtherAlignment, bool otherPadded>
 	TrackingAlignedAllocator( TrackingAlignedAllocator<Other,
-			OtherAlignment>&& rhs ) noexcept
+			OtherAlignment,
+			otherPadded>&& rhs ) noexcept
 		:
-		m_nAllocations{rhs.getAllocations()}
+		m_nAllocations{rhs.getAllocations()},
+		m_requestedBytes{rhs.getStats().requestedBytes},
+		m_paddingBytes{rhs.getStats().paddingBytes}
 	{
 
 	}
 
-	template<typename Other, std::size_t OtherAlignment>
+	template<typename Other, std::size_t OtherAlignment, bool otherPadded>
 	TrackingAlignedAllocator& operator=( TrackingAlignedAllocator<Other,
-			OtherAlignment>&& rhs ) noexcept
+			OtherAlignment,
+			otherPadded>&& rhs ) noexcept
 	{
 		m_nAllocations = rhs.getAllocations();
+		m_requestedBytes = rhs.getStats().requestedBytes;
+		m_paddingBytes = rhs.getStats().paddingBytes;
 		return *this;
 	}
 
@@ -122,13 +146,24 @@ public:
 		return &cr;
 	}
 
-	constexpr std::size_t getAlignment() const noexcept
+	static constexpr std::size_t getAlignment() noexcept
 	{
-		return ( alignment > sizeof( void* ) ) ?
-			alignment :
+		constexpr std::size_t blockAlignment = cacheLinePadded && cacheLineSize > alignment ?
+			cacheLineSize :
+			alignment;
+		return ( blockAlignment > sizeof( void* ) ) ?
+			blockAlignment :
 			sizeof( void* );
 	}
 
+	// bytes reserved for a request of `bytes`
+	static constexpr std::size_t getBlockSize( const std::size_t bytes ) noexcept
+	{
+		return cacheLinePadded ?
+			( bytes + cacheLineSize - 1 ) & ~( cacheLineSize - 1 ) :
+			bytes;
+	}
+
 	// allocates count * sizeof(T) bytes aligned to specified alignment - required
 	[[nodiscard]]
 	T* allocate( const std::size_t count )
@@ -145,9 +180,10 @@ public:
  - Invalid argument - Integer Overflow"};
 		}
 		
-		void_pointer p = alignedMalloc( sizeof(T) * count,
-			getAlignment() );
+		void_pointer p = alignedMalloc<getAlignment()>( getBlockSize( sizeof(T) * count ) );
 		++m_nAllocations;
+		m_requestedBytes += sizeof(T) * count;
+		m_paddingBytes += getSlack( p, sizeof(T) * count );
 		return static_cast<T*>( p );
 	}
 
@@ -160,11 +196,21 @@ public:
 
 	// `p` must be a value returned by an earlier call to `allocate` that has not been
 	//	invalidated by an intervening call to `deallocate` - required
+	//	std containers pass the `n` given to `allocate`; without it the stats can't be updated
 	void deallocate( T* const p,
-		[[maybe_unused]] const std::size_t n = 0 )
+		const std::size_t n = 0 )
 	{
 		--m_nAllocations;
-		alignedFree( p );
+		if ( n != 0 )
+		{
+			m_requestedBytes -= sizeof(T) * n;
+			m_paddingBytes -= getSlack( p, sizeof(T) * n );
+			alignedFree( p,
+				getBlockSize( sizeof(T) * n ),
+				getAlignment() );
+			return;
+		}
+		alignedFree<getAlignment()>( p );
 	}
 
 	// `args` are the constructor arguments for the object of type `U`
@@ -208,19 +254,46 @@ public:
 	{
 		return m_nAllocations;
 	}
+
+	// live allocations made through this allocator object; the memory comes from the system heap
+	//	so its free space and bookkeeping headers are unknown here and reported as 0
+	AllocatorStats getStats() const noexcept
+	{
+		AllocatorStats stats;
+		stats.requestedBytes = m_requestedBytes;
+		stats.paddingBytes = m_paddingBytes;
+		return stats;
+	}
+private:
+	// bytes reserved past the request: cache line rounding, and whatever more the system
+	//	allocator reserved, where the platform reports it
+	std::size_t getSlack( void* p,
+		const std::size_t bytes ) const noexcept
+	{
+		const std::size_t usable = alignedUsableSize( p,
+			getAlignment() );
+		const std::size_t reserved = usable > getBlockSize( bytes ) ?
+			usable :
+			getBlockSize( bytes );
+		return reserved - bytes;
+	}
 };
 
 // compares two allocator objects
-template<typename T, std::size_t alignment1, typename Other, std::size_t alignment2>
-inline bool operator==( const TrackingAlignedAllocator<T, alignment1>&,
-	const TrackingAlignedAllocator<Other, alignment2>& ) noexcept
+//	`alignedFree` picks the deallocation function by the alignment, and the sized free expects
+//	the padded block size, so only allocators with the same block alignment and padding can
+//	free each other's memory
+template<typename T, std::size_t alignment1, bool padded1, typename Other, std::size_t alignment2, bool padded2>
+inline bool operator==( const TrackingAlignedAllocator<T, alignment1, padded1>&,
+	const TrackingAlignedAllocator<Other, alignment2, padded2>& ) noexcept
 {
-	return true;
+	return TrackingAlignedAllocator<T, alignment1, padded1>::getAlignment() == TrackingAlignedAllocator<Other, alignment2, padded2>::getAlignment()
+		&& padded1 == padded2;
 }
 
-template<typename T, std::size_t alignment1, typename Other, std::size_t alignment2>
-inline bool operator!=( const TrackingAlignedAllocator<T, alignment1>&,
-	const TrackingAlignedAllocator<Other, alignment2>& ) noexcept
+template<typename T, std::size_t alignment1, bool padded1, typename Other, std::size_t alignment2, bool padded2>
+inline bool operator!=( const TrackingAlignedAllocator<T, alignment1, padded1>& lhs,
+	const TrackingAlignedAllocator<Other, alignment2, padded2>& rhs ) noexcept
 {
-	return false;
+	return !( lhs == rhs );
 }
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+
+
+//======================================================================
+// \struct	AllocatorStats
+//
+// \brief	Memory efficiency snapshot returned by every allocator's `getStats()`.
+//			requestedBytes		bytes the clients asked for, of allocations still accounted for
+//			paddingBytes		alignment slack spent in front of/after those allocations
+//			headerBytes			per-allocation bookkeeping (eg. SArena::Header)
+//			freeBytes			bytes still available to be handed out
+//			largestFreeBlock	largest contiguous free extent a single request can use
+//									fixed-size slot pools report all of freeBytes
+//			totalBytes			capacity of the allocator's backing memory; 0 if unbounded
+//======================================================================
+struct AllocatorStats final
+{
+	std::size_t requestedBytes = 0;
+	std::size_t paddingBytes = 0;
+	std::size_t headerBytes = 0;
+	std::size_t freeBytes = 0;
+	std::size_t largestFreeBlock = 0;
+	std::size_t totalBytes = 0;
+
+	std::size_t getUsedBytes() const noexcept
+	{
+		return requestedBytes + paddingBytes + headerBytes;
+	}
+
+	// fraction of the used memory that the clients did not ask for
+	double getInternalFragmentation() const noexcept
+	{
+		const std::size_t used = getUsedBytes();
+		return used == 0 ?
+			0.0 :
+			static_cast<double>( paddingBytes + headerBytes ) / static_cast<double>( used );
+	}
+
+	// fraction of the free memory that can't be handed out in a single allocation
+	double getExternalFragmentation() const noexcept
+	{
+		return freeBytes == 0 ?
+			0.0 :
+			1.0 - static_cast<double>( largestFreeBlock ) / static_cast<double>( freeBytes );
+	}
+};
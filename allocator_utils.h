@@ -1,104 +1,158 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#if defined(_MSC_VER) || defined(_WIN32) || defined(__GLIBC__) || defined(__linux__)
+#	include <malloc.h>
+#elif defined(__APPLE__) && defined(__MACH__)
+#	include <malloc/malloc.h>
+#endif
 #include "assertions.h"
 
 
+// Header only: every function is inline, constexpr or a template, so this header can be
+//	included from any number of translation units and each call site gets the body to inline.
+
+
 constexpr bool isPowerOfTwo( const std::size_t value ) noexcept
 {
 	return ( value != 0 && ( value & ( value - 1 ) ) == 0 );
 }
 
-//  check whether the address is aligned to `alignment` boundary
-bool isAligned( const volatile void *p,
+// minimum distance between two objects written by different threads to avoid false sharing
+#if defined __cpp_lib_hardware_interference_size
+#	if defined __GNUC__ && !defined __clang__
+// it's a tuning hint that may differ between -mtune targets; that's fine, it's not part of any ABI here
+#		pragma GCC diagnostic push
+#		pragma GCC diagnostic ignored "-Winterference-size"
+#	endif
+inline constexpr std::size_t cacheLineSize = std::hardware_destructive_interference_size;
+#	if defined __GNUC__ && !defined __clang__
+#		pragma GCC diagnostic pop
+#	endif
+#else
+inline constexpr std::size_t cacheLineSize = 64;
+#endif
+
+//  check whether the address is aligned to `alignment` boundary, which must be a power of 2
+inline bool isAligned( const volatile void *p,
 	std::size_t alignment )
 {
-	return ( reinterpret_cast<std::uintptr_t>( p ) % alignment ) == 0;
+	return ( reinterpret_cast<std::uintptr_t>( p ) & ( alignment - 1 ) ) == 0;
 }
 
-bool isAligned( std::uintptr_t pi,
-	std::size_t alignment )
+constexpr bool isAligned( std::uintptr_t pi,
+	std::size_t alignment ) noexcept
 {
-	return ( pi % alignment ) == 0;
+	return ( pi & ( alignment - 1 ) ) == 0;
 }
 
 //===================================================
 //	\function	alignForward
 //	\brief  align pointer forward with given alignment
+//			`alignment` must be a power of 2; 0 leaves the address as is
+//			branch free: an add and a mask
 //	\date	2022/02/20 20:34
 template<typename T>
 T* alignForward( T* p,
 	std::size_t alignment ) noexcept
 {
-	if ( alignment == 0 )
-	{
-		return p;
-	}
-	const std::uintptr_t ip = reinterpret_cast<std::uintptr_t>( p );
-	if ( ip % alignment == 0 )
-	{
-		return p;
-	}
-	return reinterpret_cast<T*>( ( ip + ( alignment - 1 ) ) & ~( alignment - 1 ) );
-	// or: (ip + alignment - 1) / alignment * alignment;
+	const std::uintptr_t mask = alignment - ( alignment != 0 );
+	return reinterpret_cast<T*>( ( reinterpret_cast<std::uintptr_t>( p ) + mask ) & ~mask );
 }
 
-std::uintptr_t alignForward( std::uintptr_t ip,
+constexpr std::uintptr_t alignForward( std::uintptr_t ip,
 	std::size_t alignment ) noexcept
 {
-	if ( alignment == 0 )
+	const std::uintptr_t mask = alignment - ( alignment != 0 );
+	return ( ip + mask ) & ~mask;
+}
+
+// the alignment known at compile time folds into the add and mask immediates
+//	eg. alignForward<16>( offset ) compiles to `add 15; and -16`
+template<std::size_t alignment>
+constexpr std::uintptr_t alignForward( const std::uintptr_t ip ) noexcept
+{
+	static_assert( isPowerOfTwo( alignment ),
+		"Alignment value must be a power of 2." );
+	return ( ip + ( alignment - 1 ) ) & ~std::uintptr_t{alignment - 1};
+}
+
+template<std::size_t alignment, typename T>
+T* alignForward( T* p ) noexcept
+{
+	return reinterpret_cast<T*>( alignForward<alignment>( reinterpret_cast<std::uintptr_t>( p ) ) );
+}
+
+// rounds `size` up to a multiple of `alignment`, which must be a power of 2
+constexpr std::size_t calcAlignedSize( const std::size_t size,
+	const std::size_t alignment ) noexcept
+{
+	return ( size + ( alignment - 1 ) ) & ~( alignment - 1 );
+}
+
+// index of the most significant set bit ie. floor( log2( value ) ); `value` must not be 0
+constexpr std::size_t floorLog2( std::size_t value ) noexcept
+{
+#if defined __GNUC__ || defined __clang__
+	return sizeof( unsigned long long ) * 8 - 1 - __builtin_clzll( value );
+#else
+	std::size_t log2 = 0;
+	while ( value >>= 1 )
 	{
-		return ip;
+		++log2;
 	}
-	if ( ip % alignment == 0 )
+	return log2;
+#endif
+}
+
+// index of the least significant set bit; `value` must not be 0
+constexpr std::size_t countTrailingZeros( std::uint64_t value ) noexcept
+{
+#if defined __GNUC__ || defined __clang__
+	return static_cast<std::size_t>( __builtin_ctzll( value ) );
+#else
+	std::size_t count = 0;
+	while ( ( value & 1 ) == 0 )
 	{
-		return ip;
+		value >>= 1;
+		++count;
 	}
-	return ( ip + ( alignment - 1 ) ) & ~( alignment - 1 );
-	// or: (ip + alignment - 1) / alignment * alignment;
+	return count;
+#endif
 }
 
-// calculates alignment in bits supposedly
-std::size_t calcAlignedSize( std::size_t size,
-	std::size_t alignment )
+// padding bytes needed to align address p forward given the power of 2 alignment; 0 if already aligned
+constexpr std::size_t getForwardPadding( const std::size_t p,
+	const std::size_t alignment ) noexcept
 {
-	return size + ( size % ( alignment / 8 ) );
+	return ( 0 - p ) & ( alignment - 1 );
 }
 
-// calculate padding bytes needed to align address p forward given the alignment
-const std::size_t getForwardPadding( const std::size_t p,
-	const std::size_t alignment )
+template<std::size_t alignment>
+constexpr std::size_t getForwardPadding( const std::size_t p ) noexcept
 {
-	const std::size_t mult = ( p / alignment ) + 1;
-	const std::size_t alignedAddress = mult * alignment;
-	const std::size_t padding = alignedAddress - p;
-	return padding;
+	static_assert( isPowerOfTwo( alignment ),
+		"Alignment value must be a power of 2." );
+	return ( 0 - p ) & ( alignment - 1 );
 }
 
-const std::size_t getForwardPaddingWithHeader( const std::size_t p,
+// the smallest padding that aligns p forward and leaves room for a header of `headerSize` bytes in front
+constexpr std::size_t getForwardPaddingWithHeader( const std::size_t p,
 	const std::size_t alignment,
-	const std::size_t headerSize )
+	const std::size_t headerSize ) noexcept
 {
-	std::size_t padding = getForwardPadding( p,
+	return headerSize + getForwardPadding( p + headerSize,
 		alignment );
-	std::size_t neededSpace = headerSize;
-
-	if ( padding < neededSpace )
-	{
-		// Header does not fit - Calculate m_pNext aligned address that header fits
-		neededSpace -= padding;
+}
 
-		// How many alignments I need to fit the header        
-		if ( neededSpace % alignment > 0 )
-		{
-			padding += alignment * ( 1 + ( neededSpace / alignment ) );
-		}
-		else
-		{
-			padding += alignment * ( neededSpace / alignment );
-		}
-	}
-	return padding;
+template<std::size_t alignment>
+constexpr std::size_t getForwardPaddingWithHeader( const std::size_t p,
+	const std::size_t headerSize ) noexcept
+{
+	return headerSize + getForwardPadding<alignment>( p + headerSize );
 }
 
 template<typename T>
@@ -113,65 +167,220 @@ T* alignPtr( const T *ptr,
 	return alignedPtr;
 }
 
-// allocate `bytes` + `bytesForAlignment` required given requested `alignment` value
-// store malloced address in `pmem`
-// compute aligned address `palignedMem` by adding the `bytesForAdjustment` to malloced `pmem` address
-// TODO: doesn't work properly
-void* _alignedMalloc( std::size_t bytes,
+// alignments `malloc` already guarantees
+inline constexpr std::size_t mallocAlignment = alignof( std::max_align_t );
+// alignments up to a page go to the platform's aligned allocator; past it they're served by
+//	`_alignedMalloc`, which doesn't depend on how the platform copes with huge alignments
+inline constexpr std::size_t maxNativeAlignment = 4096;
+
+// over-allocate-and-stash-header aligned allocation, for any power of 2 `alignment`
+//	reserves `alignment` bytes more than asked for, aligns forward past a pointer sized header
+//	and stores the address malloc returned in that header, right in front of the aligned block
+//	malloc returns multiples of sizeof( void* ) so header and padding never exceed `alignment`
+inline void* _alignedMalloc( std::size_t bytes,
 	std::size_t alignment )
 {
-	ASSERT( false,
-		"Never should have come here!" );
-	void *pmem = nullptr;
-	std::size_t bytesForAlignment = alignment - 1 + sizeof(void*);
-	if ( ( pmem = static_cast<void*>( ::operator new( bytes + bytesForAlignment ) ) ) == nullptr )
+	ASSERT( isPowerOfTwo( alignment ),
+		"Alignment value must be a power of 2." );
+	if ( alignment < sizeof( void* ) )
+	{
+		alignment = sizeof( void* );
+	}
+	if ( bytes > std::size_t( -1 ) - alignment )
+	{
+		throw std::bad_alloc{};
+	}
+	void* pRaw = std::malloc( bytes + alignment );
+	if ( pRaw == nullptr )
+	{
+		throw std::bad_alloc{};
+	}
+	const std::uintptr_t raw = reinterpret_cast<std::uintptr_t>( pRaw );
+	void** pAligned = reinterpret_cast<void**>( raw + getForwardPaddingWithHeader( raw,
+		alignment,
+		sizeof( void* ) ) );
+	pAligned[-1] = pRaw;
+	return pAligned;
+}
+
+inline void _alignedFree( void *p ) noexcept
+{
+	if ( p != nullptr )
+	{
+		std::free( static_cast<void**>( p )[-1] );
+	}
+}
+
+// the platform's aligned allocator; `alignment` must be a power of 2 multiple of sizeof( void* )
+inline void* _nativeAlignedMalloc( std::size_t bytes,
+	std::size_t alignment ) noexcept
+{
+#if defined(_MSC_VER) || defined(_WIN32) || defined(_WIN64)
+	return _aligned_malloc( bytes,
+		alignment );
+#else
+	// aligned_alloc wants the size to be a multiple of the alignment; a size that wraps when
+	//	rounded up can't be served
+	if ( bytes > std::size_t( -1 ) - alignment )
 	{
 		return nullptr;
 	}
-	// round-up / align address forward
-	std::size_t bytesForAdjustment = ( bytesForAlignment ) & ~( alignment - 1 );
-	void** palignedMem = reinterpret_cast<void**>( reinterpret_cast<std::size_t>( pmem )
-		+ bytesForAdjustment );
-	palignedMem[-1] = pmem;
-	return palignedMem;
+	return std::aligned_alloc( alignment,
+		calcAlignedSize( bytes, alignment ) );
+#endif
 }
 
-void _alignedFree( void *p ) noexcept
+inline void _nativeAlignedFree( void *p ) noexcept
 {
-	ASSERT( false,
-		"Never should have come here!" );
-	::operator delete( static_cast<void**>( p )[-1] );
+#if defined(_MSC_VER) || defined(_WIN32) || defined(_WIN64)
+	_aligned_free( p );
+#else
+	std::free( p );
+#endif
 }
 
-void* alignedMalloc( std::size_t count,
+//===================================================
+//	\function	alignedMalloc
+//	\brief  allocates `count` bytes aligned to `alignment`, a power of 2; throws std::bad_alloc
+//			dispatches on the alignment:
+//				up to `mallocAlignment`		plain malloc, no alignment work at all
+//				up to `maxNativeAlignment`	the platform's aligned_alloc / _aligned_malloc
+//				beyond						`_alignedMalloc`'s over-allocation
+//			release with `alignedFree` passing the same alignment, so it can pick the
+//				matching deallocation function
+//			the `alignedMalloc<alignment>` overload picks the path at compile time
+//	\date	2022/02/20 20:34
+inline void* alignedMalloc( std::size_t count,
 	std::size_t alignment )
 {
+	ASSERT( isPowerOfTwo( alignment ),
+		"Alignment value must be a power of 2." );
 	void* p;
-#if defined(_MSC_VER) || defined(_WIN32) || defined(_WIN64)
-	p = _aligned_malloc( count,
-		alignment );
-	if ( p == nullptr )
+	if ( alignment <= mallocAlignment )
 	{
-		throw std::bad_alloc();
+		p = std::malloc( count );
 	}
-#elif defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))
-	if ( posix_memalign( &p, alignment, count ) )
+	else if ( alignment <= maxNativeAlignment )
 	{
-		throw std::bad_alloc();	// p = 0
+		p = _nativeAlignedMalloc( count,
+			alignment );
+	}
+	else
+	{
+		return _alignedMalloc( count,
+			alignment );
+	}
+	if ( p == nullptr )
+	{
+		throw std::bad_alloc{};
 	}
-#endif
 	ASSERT( isAligned( p, alignment ),
 		"Memory not properly aligned!" );
 	return p;
-};	//  The address of the allocated memory (returned by p) will be a multiple of alignment, which must be a power of two and a multiple of sizeof(void *)
+}
+
+template<std::size_t alignment>
+void* alignedMalloc( const std::size_t count )
+{
+	static_assert( isPowerOfTwo( alignment ),
+		"Alignment value must be a power of 2." );
+	void* p;
+	if constexpr ( alignment <= mallocAlignment )
+	{
+		p = std::malloc( count );
+	}
+	else if constexpr ( alignment <= maxNativeAlignment )
+	{
+		p = _nativeAlignedMalloc( count,
+			alignment );
+	}
+	else
+	{
+		return _alignedMalloc( count,
+			alignment );
+	}
+	if ( p == nullptr )
+	{
+		throw std::bad_alloc{};
+	}
+	return p;
+}
+
+// `alignment` must be the one `p` was allocated with
+inline void alignedFree( void *p,
+	std::size_t alignment ) noexcept
+{
+	if ( alignment <= mallocAlignment )
+	{
+		std::free( p );
+	}
+	else if ( alignment <= maxNativeAlignment )
+	{
+		_nativeAlignedFree( p );
+	}
+	else
+	{
+		_alignedFree( p );
+	}
+}
 
+template<std::size_t alignment>
 void alignedFree( void *p ) noexcept
 {
+	if constexpr ( alignment <= mallocAlignment )
+	{
+		std::free( p );
+	}
+	else if constexpr ( alignment <= maxNativeAlignment )
+	{
+		_nativeAlignedFree( p );
+	}
+	else
+	{
+		_alignedFree( p );
+	}
+}
+
+// bytes actually reserved by `alignedMalloc` for `p`, which may exceed the requested count
+//	returns 0 where the platform can't tell
+inline std::size_t alignedUsableSize( void *p,
+	[[maybe_unused]] std::size_t alignment ) noexcept
+{
+	if ( p == nullptr )
+	{
+		return 0;
+	}
+	void* pBlock = p;
+	if ( alignment > maxNativeAlignment )
+	{
+		pBlock = static_cast<void**>( p )[-1];
+	}
+	const std::size_t offset = static_cast<unsigned char*>( p ) - static_cast<unsigned char*>( pBlock );
+	std::size_t usable;
 #if defined(_MSC_VER) || defined(_WIN32) || defined(_WIN64)
-	_aligned_free( p );
-#elif defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))
-	free( p );
+	usable = alignment > mallocAlignment && alignment <= maxNativeAlignment ?
+		_aligned_msize( p, alignment, 0 ) :
+		_msize( pBlock );
+#elif defined(__GLIBC__) || defined(__linux__)
+	usable = malloc_usable_size( pBlock );
+#elif defined(__APPLE__) && defined(__MACH__)
+	usable = malloc_size( pBlock );
+#else
+	return 0;
 #endif
+	return usable - offset;
+}
+
+// sized free: `count` is the one given to `alignedMalloc`
+//	the system allocators behind it take no size, so it's only checked against the block in debug builds
+inline void alignedFree( void *p,
+	[[maybe_unused]] std::size_t count,
+	std::size_t alignment ) noexcept
+{
+	ASSERT( p == nullptr || alignedUsableSize( p, alignment ) == 0 || alignedUsableSize( p, alignment ) >= count,
+		"alignedFree() size mismatch!" );
+	alignedFree( p,
+		alignment );
 }
 
 // INTEL:
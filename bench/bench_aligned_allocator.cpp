@@ -0,0 +1,270 @@
+#include <functional>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "bench_common.h"
+#if defined __AVX__ || defined __SSE2__ || defined _M_X64
+#	include <immintrin.h>
+#endif
+#include "minimal_aligned_allocator_cpp11.h"
+#include "tracking_aligned_allocator.h"
+
+
+template<typename T>
+using TAA16 = TrackingAlignedAllocator<T, 16>;
+
+template<typename T>
+using TAA64 = TrackingAlignedAllocator<T, 64>;
+
+// one per `alignedMalloc` path: AlignedAllocator<char> is plain malloc, these are
+//	aligned_alloc and the over-allocating header scheme
+template<typename T>
+using AA64 = AlignedAllocator<T, 64>;
+
+template<typename T>
+using AA8K = AlignedAllocator<T, 8192>;
+
+template<typename Alloc>
+static void BM_Aligned_AllocateFixed( benchmark::State& state )
+{
+	const std::size_t bytes = static_cast<std::size_t>( state.range( 0 ) );
+	Alloc alloc;
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( std::size_t i = 0; i < batchSize; ++i )
+		{
+			char* p = alloc.allocate( bytes );
+			benchmark::DoNotOptimize( p );
+			alloc.deallocate( p, bytes );
+		}
+	}
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK_TEMPLATE( BM_Aligned_AllocateFixed, AlignedAllocator<char> ) ALLOCATORS_FIXED_SIZES;
+BENCHMARK_TEMPLATE( BM_Aligned_AllocateFixed, AA64<char> ) ALLOCATORS_FIXED_SIZES;
+BENCHMARK_TEMPLATE( BM_Aligned_AllocateFixed, AA8K<char> ) ALLOCATORS_FIXED_SIZES;
+BENCHMARK_TEMPLATE( BM_Aligned_AllocateFixed, TAA16<char> ) ALLOCATORS_FIXED_SIZES;
+BENCHMARK_TEMPLATE( BM_Aligned_AllocateFixed, TAA64<char> ) ALLOCATORS_FIXED_SIZES;
+
+// the whole batch is live at once, then freed
+template<typename Alloc>
+static void BM_Aligned_AllocateMixed( benchmark::State& state )
+{
+	const auto& sizes = getMixedSizes();
+	Alloc alloc;
+	std::vector<char*> ptrs( batchSize );
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( std::size_t i = 0; i < batchSize; ++i )
+		{
+			ptrs[i] = alloc.allocate( sizes[i] );
+		}
+		benchmark::DoNotOptimize( ptrs.data() );
+		for ( std::size_t i = 0; i < batchSize; ++i )
+		{
+			alloc.deallocate( ptrs[i], sizes[i] );
+		}
+	}
+	if constexpr ( std::is_same_v<Alloc, TAA16<char>> || std::is_same_v<Alloc, TAA64<char>> )
+	{
+		for ( std::size_t i = 0; i < batchSize; ++i )
+		{
+			ptrs[i] = alloc.allocate( sizes[i] );
+		}
+		reportStats( state,
+			alloc.getStats() );
+		for ( std::size_t i = 0; i < batchSize; ++i )
+		{
+			alloc.deallocate( ptrs[i], sizes[i] );
+		}
+	}
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK_TEMPLATE( BM_Aligned_AllocateMixed, AlignedAllocator<char> );
+BENCHMARK_TEMPLATE( BM_Aligned_AllocateMixed, TAA16<char> );
+BENCHMARK_TEMPLATE( BM_Aligned_AllocateMixed, TAA64<char> );
+
+template<template<typename> class Alloc>
+static void BM_Aligned_VectorGrowth( benchmark::State& state )
+{
+	const std::size_t count = static_cast<std::size_t>( state.range( 0 ) );
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		std::vector<int, Alloc<int>> vec;
+		for ( std::size_t i = 0; i < count; ++i )
+		{
+			vec.push_back( static_cast<int>( i ) );
+		}
+		benchmark::DoNotOptimize( vec.data() );
+	}
+	state.SetItemsProcessed( state.iterations() * count );
+}
+BENCHMARK_TEMPLATE( BM_Aligned_VectorGrowth, AlignedAllocator ) ALLOCATORS_CONTAINER_SIZES;
+BENCHMARK_TEMPLATE( BM_Aligned_VectorGrowth, TAA16 ) ALLOCATORS_CONTAINER_SIZES;
+BENCHMARK_TEMPLATE( BM_Aligned_VectorGrowth, TAA64 ) ALLOCATORS_CONTAINER_SIZES;
+
+template<template<typename> class Alloc>
+static void BM_Aligned_MapInsert( benchmark::State& state )
+{
+	using Map = std::map<int, int, std::less<int>, Alloc<std::pair<const int, int>>>;
+	const std::size_t count = static_cast<std::size_t>( state.range( 0 ) );
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		Map map;
+		for ( std::size_t i = 0; i < count; ++i )
+		{
+			map.emplace( getKey( i ), static_cast<int>( i ) );
+		}
+		benchmark::DoNotOptimize( map.size() );
+	}
+	state.SetItemsProcessed( state.iterations() * count );
+}
+BENCHMARK_TEMPLATE( BM_Aligned_MapInsert, AlignedAllocator ) ALLOCATORS_CONTAINER_SIZES;
+BENCHMARK_TEMPLATE( BM_Aligned_MapInsert, TAA16 ) ALLOCATORS_CONTAINER_SIZES;
+BENCHMARK_TEMPLATE( BM_Aligned_MapInsert, TAA64 ) ALLOCATORS_CONTAINER_SIZES;
+
+template<template<typename> class Alloc>
+static void BM_Aligned_StringChurn( benchmark::State& state )
+{
+	using Str = std::basic_string<char, std::char_traits<char>, Alloc<char>>;
+	const std::size_t count = static_cast<std::size_t>( state.range( 0 ) );
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		std::vector<Str, Alloc<Str>> strings;
+		strings.reserve( count );
+		for ( std::size_t i = 0; i < count; ++i )
+		{
+			strings.emplace_back( churnText.substr( 0, getChurnLength( i ) ) );
+			strings.back() += churnText.substr( 0, getChurnLength( i + 1 ) );
+		}
+		benchmark::DoNotOptimize( strings.data() );
+	}
+	state.SetItemsProcessed( state.iterations() * count );
+}
+BENCHMARK_TEMPLATE( BM_Aligned_StringChurn, AlignedAllocator ) ALLOCATORS_CONTAINER_SIZES;
+BENCHMARK_TEMPLATE( BM_Aligned_StringChurn, TAA16 ) ALLOCATORS_CONTAINER_SIZES;
+BENCHMARK_TEMPLATE( BM_Aligned_StringChurn, TAA64 ) ALLOCATORS_CONTAINER_SIZES;
+
+// both allocators forward to the system aligned allocation routine; this measures its contention
+template<typename Alloc>
+static void BM_Aligned_ThreadScaling( benchmark::State& state )
+{
+	const auto& sizes = getMixedSizes();
+	Alloc alloc;
+	std::vector<char*> ptrs( batchSize );
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( std::size_t i = 0; i < batchSize; ++i )
+		{
+			ptrs[i] = alloc.allocate( sizes[i] );
+		}
+		benchmark::DoNotOptimize( ptrs.data() );
+		for ( std::size_t i = 0; i < batchSize; ++i )
+		{
+			alloc.deallocate( ptrs[i], sizes[i] );
+		}
+	}
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK_TEMPLATE( BM_Aligned_ThreadScaling, AlignedAllocator<char> ) ALLOCATORS_THREAD_RANGE;
+BENCHMARK_TEMPLATE( BM_Aligned_ThreadScaling, TAA64<char> ) ALLOCATORS_THREAD_RANGE;
+
+#if defined __AVX__ || defined __SSE2__ || defined _M_X64
+// widest vectors the benchmark is compiled for; configure with ALLOCATORS_BENCH_NATIVE=ON to get AVX
+#	if defined __AVX__
+using TVec = __m256;
+constexpr std::size_t vecFloats = 8;
+static TVec vecZero() noexcept
+{
+	return _mm256_setzero_ps();
+}
+static TVec vecLoad( const float* p ) noexcept
+{
+	return _mm256_load_ps( p );
+}
+static TVec vecLoadu( const float* p ) noexcept
+{
+	return _mm256_loadu_ps( p );
+}
+static TVec vecAdd( TVec a, TVec b ) noexcept
+{
+	return _mm256_add_ps( a, b );
+}
+#	else
+using TVec = __m128;
+constexpr std::size_t vecFloats = 4;
+static TVec vecZero() noexcept
+{
+	return _mm_setzero_ps();
+}
+static TVec vecLoad( const float* p ) noexcept
+{
+	return _mm_load_ps( p );
+}
+static TVec vecLoadu( const float* p ) noexcept
+{
+	return _mm_loadu_ps( p );
+}
+static TVec vecAdd( TVec a, TVec b ) noexcept
+{
+	return _mm_add_ps( a, b );
+}
+#	endif
+
+enum class LoadKind
+{
+	Aligned,				// aligned load instructions on aligned_vector data
+	UnalignedOnAligned,		// unaligned load instructions, same aligned data
+	Misaligned				// unaligned loads one float off the boundary; some straddle cache lines
+};
+
+// sums a buffer of range(0) bytes with 4 independent accumulators
+template<LoadKind kind>
+static void BM_Aligned_LoadThroughput( benchmark::State& state )
+{
+	const std::size_t nFloats = static_cast<std::size_t>( state.range( 0 ) ) / sizeof( float );
+	aligned_vector<float, 64> data( nFloats + vecFloats, 1.0f );
+	const float* p = data.data() + ( kind == LoadKind::Misaligned ? 1 : 0 );
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		TVec acc0 = vecZero();
+		TVec acc1 = vecZero();
+		TVec acc2 = vecZero();
+		TVec acc3 = vecZero();
+		for ( std::size_t i = 0; i + 4 * vecFloats <= nFloats; i += 4 * vecFloats )
+		{
+			if constexpr ( kind == LoadKind::Aligned )
+			{
+				acc0 = vecAdd( acc0, vecLoad( p + i ) );
+				acc1 = vecAdd( acc1, vecLoad( p + i + vecFloats ) );
+				acc2 = vecAdd( acc2, vecLoad( p + i + 2 * vecFloats ) );
+				acc3 = vecAdd( acc3, vecLoad( p + i + 3 * vecFloats ) );
+			}
+			else
+			{
+				acc0 = vecAdd( acc0, vecLoadu( p + i ) );
+				acc1 = vecAdd( acc1, vecLoadu( p + i + vecFloats ) );
+				acc2 = vecAdd( acc2, vecLoadu( p + i + 2 * vecFloats ) );
+				acc3 = vecAdd( acc3, vecLoadu( p + i + 3 * vecFloats ) );
+			}
+		}
+		TVec sum = vecAdd( vecAdd( acc0, acc1 ), vecAdd( acc2, acc3 ) );
+		benchmark::DoNotOptimize( sum );
+	}
+	state.SetBytesProcessed( state.iterations() * state.range( 0 ) );
+}
+// from L1 resident to main memory
+BENCHMARK_TEMPLATE( BM_Aligned_LoadThroughput, LoadKind::Aligned )->RangeMultiplier( 16 )->Range( 4 << 10, 16 << 20 );
+BENCHMARK_TEMPLATE( BM_Aligned_LoadThroughput, LoadKind::UnalignedOnAligned )->RangeMultiplier( 16 )->Range( 4 << 10, 16 << 20 );
+BENCHMARK_TEMPLATE( BM_Aligned_LoadThroughput, LoadKind::Misaligned )->RangeMultiplier( 16 )->Range( 4 << 10, 16 << 20 );
+#endif // SIMD
+
+BENCHMARK_MAIN();
@@ -0,0 +1,143 @@
+#include <array>
+#include <cstdint>
+#include "bench_common.h"
+#include "linear_allocator.h"
+
+
+// the alignment helpers on the Arena/SArena allocate path and Arena::allocate itself
+//	with perf counters on, `instructions` per item is the instruction count of one call
+//	the out of line copies below are there for reading the generated code:
+//		objdump -d --no-show-raw-insn -C bench_alignment | grep -A12 '<alignForward16'
+
+#if defined _MSC_VER
+#	define ALLOCATORS_NOINLINE __declspec( noinline )
+#else
+#	define ALLOCATORS_NOINLINE __attribute__( ( noinline ) )
+#endif
+
+// the modulo and branch version alignForward had before
+static std::uintptr_t alignForwardModulo( std::uintptr_t ip,
+	std::size_t alignment ) noexcept
+{
+	if ( alignment == 0 )
+	{
+		return ip;
+	}
+	if ( ip % alignment == 0 )
+	{
+		return ip;
+	}
+	return ( ip + ( alignment - 1 ) ) & ~( alignment - 1 );
+}
+
+ALLOCATORS_NOINLINE std::uintptr_t alignForward16( std::uintptr_t ip ) noexcept
+{
+	return alignForward<16>( ip );
+}
+
+ALLOCATORS_NOINLINE void* arenaAllocate16( Arena<16>& arena,
+	std::size_t bytes )
+{
+	return arena.allocate( bytes );
+}
+
+// unaligned offsets, so neither the branchy nor the branch free version gets an easy ride
+static const std::array<std::uintptr_t, batchSize>& getOffsets()
+{
+	static const std::array<std::uintptr_t, batchSize> offsets = []
+		{
+			std::array<std::uintptr_t, batchSize> offsets{};
+			const auto& sizes = getMixedSizes();
+			for ( std::size_t i = 0; i < batchSize; ++i )
+			{
+				offsets[i] = sizes[i] * 7 + i;
+			}
+			return offsets;
+		}();
+	return offsets;
+}
+
+// the alignment is a runtime value for the first two, as it is for the non template overloads
+static void BM_AlignForward_Modulo( benchmark::State& state )
+{
+	const auto& offsets = getOffsets();
+	std::size_t alignment = 16;
+	benchmark::DoNotOptimize( alignment );
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( const std::uintptr_t offset : offsets )
+		{
+			benchmark::DoNotOptimize( alignForwardModulo( offset, alignment ) );
+		}
+	}
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK( BM_AlignForward_Modulo );
+
+static void BM_AlignForward_Mask( benchmark::State& state )
+{
+	const auto& offsets = getOffsets();
+	std::size_t alignment = 16;
+	benchmark::DoNotOptimize( alignment );
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( const std::uintptr_t offset : offsets )
+		{
+			benchmark::DoNotOptimize( alignForward( offset, alignment ) );
+		}
+	}
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK( BM_AlignForward_Mask );
+
+static void BM_AlignForward_Template( benchmark::State& state )
+{
+	const auto& offsets = getOffsets();
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( const std::uintptr_t offset : offsets )
+		{
+			benchmark::DoNotOptimize( alignForward<16>( offset ) );
+		}
+	}
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK( BM_AlignForward_Template );
+
+static void BM_GetForwardPadding_Template( benchmark::State& state )
+{
+	const auto& offsets = getOffsets();
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( const std::uintptr_t offset : offsets )
+		{
+			benchmark::DoNotOptimize( getForwardPadding<16>( offset ) );
+		}
+	}
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK( BM_GetForwardPadding_Template );
+
+// one allocation per iteration; the rare reset when the arena fills up is amortized away
+static void BM_Arena_AllocateFastPath( benchmark::State& state )
+{
+	const std::size_t bytes = static_cast<std::size_t>( state.range( 0 ) );
+	Arena<16> arena{1 << 20};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		if ( arena.getAvailableMemory() < bytes )
+		{
+			arena.reset();
+		}
+		benchmark::DoNotOptimize( arenaAllocate16( arena, bytes ) );
+	}
+	state.SetItemsProcessed( state.iterations() );
+}
+BENCHMARK( BM_Arena_AllocateFastPath )->Arg( 8 )->Arg( 24 )->Arg( 100 );
+
+BENCHMARK_MAIN();
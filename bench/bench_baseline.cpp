@@ -0,0 +1,140 @@
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include "bench_common.h"
+
+
+// reference numbers for the system allocator; every allocator benchmark is compared against these
+
+static void BM_Malloc_AllocateFixed( benchmark::State& state )
+{
+	const std::size_t bytes = static_cast<std::size_t>( state.range( 0 ) );
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( std::size_t i = 0; i < batchSize; ++i )
+		{
+			void* p = std::malloc( bytes );
+			benchmark::DoNotOptimize( p );
+			std::free( p );
+		}
+	}
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK( BM_Malloc_AllocateFixed ) ALLOCATORS_FIXED_SIZES;
+
+static void BM_New_AllocateFixed( benchmark::State& state )
+{
+	const std::size_t bytes = static_cast<std::size_t>( state.range( 0 ) );
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( std::size_t i = 0; i < batchSize; ++i )
+		{
+			char* p = new char[bytes];
+			benchmark::DoNotOptimize( p );
+			delete[] p;
+		}
+	}
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK( BM_New_AllocateFixed ) ALLOCATORS_FIXED_SIZES;
+
+static void BM_Malloc_AllocateMixed( benchmark::State& state )
+{
+	const auto& sizes = getMixedSizes();
+	std::vector<void*> ptrs( batchSize );
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( std::size_t i = 0; i < batchSize; ++i )
+		{
+			ptrs[i] = std::malloc( sizes[i] );
+		}
+		benchmark::DoNotOptimize( ptrs.data() );
+		for ( void* p : ptrs )
+		{
+			std::free( p );
+		}
+	}
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK( BM_Malloc_AllocateMixed );
+
+static void BM_StdAllocator_VectorGrowth( benchmark::State& state )
+{
+	const std::size_t count = static_cast<std::size_t>( state.range( 0 ) );
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		std::vector<int> vec;
+		for ( std::size_t i = 0; i < count; ++i )
+		{
+			vec.push_back( static_cast<int>( i ) );
+		}
+		benchmark::DoNotOptimize( vec.data() );
+	}
+	state.SetItemsProcessed( state.iterations() * count );
+}
+BENCHMARK( BM_StdAllocator_VectorGrowth ) ALLOCATORS_CONTAINER_SIZES;
+
+static void BM_StdAllocator_MapInsert( benchmark::State& state )
+{
+	const std::size_t count = static_cast<std::size_t>( state.range( 0 ) );
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		std::map<int, int> map;
+		for ( std::size_t i = 0; i < count; ++i )
+		{
+			map.emplace( getKey( i ), static_cast<int>( i ) );
+		}
+		benchmark::DoNotOptimize( map.size() );
+	}
+	state.SetItemsProcessed( state.iterations() * count );
+}
+BENCHMARK( BM_StdAllocator_MapInsert ) ALLOCATORS_CONTAINER_SIZES;
+
+static void BM_StdAllocator_StringChurn( benchmark::State& state )
+{
+	const std::size_t count = static_cast<std::size_t>( state.range( 0 ) );
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		std::vector<std::string> strings;
+		strings.reserve( count );
+		for ( std::size_t i = 0; i < count; ++i )
+		{
+			strings.emplace_back( churnText.substr( 0, getChurnLength( i ) ) );
+			strings.back() += churnText.substr( 0, getChurnLength( i + 1 ) );
+		}
+		benchmark::DoNotOptimize( strings.data() );
+	}
+	state.SetItemsProcessed( state.iterations() * count );
+}
+BENCHMARK( BM_StdAllocator_StringChurn ) ALLOCATORS_CONTAINER_SIZES;
+
+static void BM_Malloc_ThreadScaling( benchmark::State& state )
+{
+	const auto& sizes = getMixedSizes();
+	std::vector<void*> ptrs( batchSize );
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( std::size_t i = 0; i < batchSize; ++i )
+		{
+			ptrs[i] = std::malloc( sizes[i] );
+		}
+		benchmark::DoNotOptimize( ptrs.data() );
+		for ( void* p : ptrs )
+		{
+			std::free( p );
+		}
+	}
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK( BM_Malloc_ThreadScaling ) ALLOCATORS_THREAD_RANGE;
+
+BENCHMARK_MAIN();
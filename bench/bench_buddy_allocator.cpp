@@ -0,0 +1,232 @@
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <vector>
+#include "bench_common.h"
+#include "buddy_allocator.h"
+#include "object_pool.h"
+
+
+using THeap = BuddyHeap<>;
+
+template<std::size_t size>
+struct Blob
+{
+	unsigned char bytes[size];
+};
+
+// a heap with room for a batch of `bytes` blocks, whatever they round up to
+static std::size_t getHeapSize( const std::size_t bytes ) noexcept
+{
+	return 2 * batchSize * THeap::getAllocationSize( bytes );
+}
+
+// the order a batch is freed in: scrambled, so neither allocator sees LIFO or FIFO frees
+static const std::array<std::size_t, batchSize>& getScrambledOrder()
+{
+	static const std::array<std::size_t, batchSize> order = []
+		{
+			std::array<std::size_t, batchSize> order{};
+			for ( std::size_t i = 0; i < batchSize; ++i )
+			{
+				order[i] = i;
+			}
+			std::shuffle( order.begin(),
+				order.end(),
+				std::mt19937{1453} );
+			return order;
+		}();
+	return order;
+}
+
+// a batch of equal blocks, freed out of order; every free merges buddies back up
+static void BM_Buddy_AllocateBatch( benchmark::State& state )
+{
+	const std::size_t bytes = static_cast<std::size_t>( state.range( 0 ) );
+	THeap heap{getHeapSize( bytes )};
+	std::array<void*, batchSize> blocks{};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( auto& p : blocks )
+		{
+			p = heap.allocate( bytes );
+		}
+		benchmark::DoNotOptimize( blocks.data() );
+		for ( const std::size_t i : getScrambledOrder() )
+		{
+			heap.deallocate( blocks[i],
+				bytes );
+		}
+	}
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK( BM_Buddy_AllocateBatch ) ALLOCATORS_FIXED_SIZES;
+
+static void BM_Malloc_AllocateBatch( benchmark::State& state )
+{
+	const std::size_t bytes = static_cast<std::size_t>( state.range( 0 ) );
+	std::array<void*, batchSize> blocks{};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( auto& p : blocks )
+		{
+			p = std::malloc( bytes );
+		}
+		benchmark::DoNotOptimize( blocks.data() );
+		for ( const std::size_t i : getScrambledOrder() )
+		{
+			std::free( blocks[i] );
+		}
+	}
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK( BM_Malloc_AllocateBatch ) ALLOCATORS_FIXED_SIZES;
+
+// the fixed size upper bound; a pool only serves its one size
+template<typename T>
+static void BM_ObjectPool_AllocateBatch( benchmark::State& state )
+{
+	ObjectPool<T> pool{batchSize};
+	std::array<T*, batchSize> objs{};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( auto& p : objs )
+		{
+			p = pool.allocate();
+		}
+		benchmark::DoNotOptimize( objs.data() );
+		for ( const std::size_t i : getScrambledOrder() )
+		{
+			pool.deallocate( objs[i] );
+		}
+	}
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK_TEMPLATE( BM_ObjectPool_AllocateBatch, Blob<64> );
+BENCHMARK_TEMPLATE( BM_ObjectPool_AllocateBatch, Blob<1024> );
+
+// the mixed sizes of the other allocator benchmarks, freed out of order
+static void BM_Buddy_AllocateMixed( benchmark::State& state )
+{
+	const auto& sizes = getMixedSizes();
+	THeap heap{getHeapSize( maxMixedSize )};
+	std::array<void*, batchSize> blocks{};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( std::size_t i = 0; i < batchSize; ++i )
+		{
+			blocks[i] = heap.allocate( sizes[i] );
+		}
+		benchmark::DoNotOptimize( blocks.data() );
+		for ( const std::size_t i : getScrambledOrder() )
+		{
+			heap.deallocate( blocks[i],
+				sizes[i] );
+		}
+	}
+	for ( std::size_t i = 0; i < batchSize; ++i )
+	{
+		blocks[i] = heap.allocate( sizes[i] );
+	}
+	reportStats( state,
+		heap.getStats() );
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK( BM_Buddy_AllocateMixed );
+
+static void BM_Malloc_AllocateMixed( benchmark::State& state )
+{
+	const auto& sizes = getMixedSizes();
+	std::array<void*, batchSize> blocks{};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( std::size_t i = 0; i < batchSize; ++i )
+		{
+			blocks[i] = std::malloc( sizes[i] );
+		}
+		benchmark::DoNotOptimize( blocks.data() );
+		for ( const std::size_t i : getScrambledOrder() )
+		{
+			std::free( blocks[i] );
+		}
+	}
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK( BM_Malloc_AllocateMixed );
+
+// long running churn in a heap kept about 3/4 full: each step frees a random live block
+//	and allocates the next mixed size; the counters show how fragmented the heap ends up
+//	and how many requests failed although enough bytes were free
+static void BM_Buddy_Fragmentation( benchmark::State& state )
+{
+	const auto& sizes = getMixedSizes();
+	THeap heap{getHeapSize( maxMixedSize )};
+	struct Block final
+	{
+		void* p;
+		std::size_t bytes;
+	};
+	std::vector<Block> live;
+	std::mt19937 rng{1453};
+	std::size_t step = 0;
+	std::size_t nFailed = 0;
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( std::size_t i = 0; i < batchSize; ++i, ++step )
+		{
+			if ( !live.empty() && 4 * heap.getStats().getUsedBytes() > 3 * heap.getSize() )
+			{
+				const std::size_t victim = rng() % live.size();
+				heap.deallocate( live[victim].p,
+					live[victim].bytes );
+				live[victim] = live.back();
+				live.pop_back();
+			}
+			const std::size_t bytes = sizes[step % batchSize];
+			try
+			{
+				live.push_back( Block{heap.allocate( bytes ), bytes} );
+			}
+			catch ( const std::bad_alloc& )
+			{
+				++nFailed;
+			}
+		}
+	}
+	reportStats( state,
+		heap.getStats() );
+	state.counters["failed_allocations"] = static_cast<double>( nFailed );
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK( BM_Buddy_Fragmentation );
+
+// node based containers through BuddyAllocator, which frees every node for reuse
+static void BM_BuddyAllocator_MapInsert( benchmark::State& state )
+{
+	using Node = std::pair<const int, int>;
+	const std::size_t count = static_cast<std::size_t>( state.range( 0 ) );
+	THeap heap{count * 256};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		std::map<int, int, std::less<int>, BuddyAllocator<Node>> map{BuddyAllocator<Node>{&heap}};
+		for ( std::size_t i = 0; i < count; ++i )
+		{
+			map.emplace( getKey( i ),
+				static_cast<int>( i ) );
+		}
+		benchmark::DoNotOptimize( map );
+	}
+	state.SetItemsProcessed( state.iterations() * count );
+}
+BENCHMARK( BM_BuddyAllocator_MapInsert ) ALLOCATORS_CONTAINER_SIZES;
+
+BENCHMARK_MAIN();
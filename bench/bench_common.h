@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <benchmark/benchmark.h>
+#include "perf_counters.h"
+#include "../allocator_stats.h"
+
+
+//======================================================================
+// workload parameters shared by every allocator benchmark executable
+//
+// each allocator is benchmarked from its own executable, so one allocator's leftovers
+//	(a fragmented malloc heap, pages it kept committed) never skew another's numbers,
+//	and a build such as bench_baseline_global_new can replace the global operator new
+//======================================================================
+
+// allocations performed per benchmark iteration before the allocator is reset/freed
+inline constexpr std::size_t batchSize = 1024;
+inline constexpr int maxBenchThreads = 16;
+inline constexpr std::size_t minMixedSize = 8;
+inline constexpr std::size_t maxMixedSize = 1024;
+
+// deterministic pseudo-random request sizes in [minMixedSize, maxMixedSize]
+//	biased towards small sizes, as real allocation traces are
+inline const std::array<std::size_t, batchSize>& getMixedSizes() noexcept
+{
+	static const std::array<std::size_t, batchSize> sizes = []
+	{
+		std::array<std::size_t, batchSize> arr{};
+		std::uint32_t x = 0x9E3779B9u;
+		for ( auto& s : arr )
+		{
+			x ^= x << 13;
+			x ^= x >> 17;
+			x ^= x << 5;
+			// squaring a uniform [0,1) value skews the distribution to the low end
+			const std::uint64_t r = x % 1024u;
+			s = minMixedSize + ( r * r * ( maxMixedSize - minMixedSize ) ) / ( 1023u * 1023u );
+		}
+		return arr;
+	}();
+	return sizes;
+}
+
+// bytes an arena needs to serve one batch of mixed sizes,
+//	given the alignment and per-allocation header overhead
+inline std::size_t getMixedSizesFootprint( const std::size_t alignment,
+	const std::size_t headerSize = 0 ) noexcept
+{
+	std::size_t total = 0;
+	for ( const std::size_t s : getMixedSizes() )
+	{
+		total += s + headerSize + alignment;
+	}
+	return total;
+}
+
+// deterministic pseudo-random keys for the map insertion workloads
+inline int getKey( const std::size_t i ) noexcept
+{
+	return static_cast<int>( ( i * 2654435761u ) % 1000003u );
+}
+
+// text the string churn workloads construct from; always exceeds the SSO buffer
+inline constexpr std::string_view churnText = "My name is Maximus Decimus Meridius. "
+	"Commander of the armies of the North. "
+	"General of the Phoelix legions. "
+	"Loyal servant to the true emperor, Marcus Aurelius.";
+
+inline std::size_t getChurnLength( const std::size_t i ) noexcept
+{
+	return 16 + ( i * 7 ) % ( churnText.size() - 16 );
+}
+
+// memory efficiency of the allocator after one batch, next to its timings
+inline void reportStats( benchmark::State& state,
+	const AllocatorStats& stats )
+{
+	state.counters["requested_bytes"] = static_cast<double>( stats.requestedBytes );
+	state.counters["padding_bytes"] = static_cast<double>( stats.paddingBytes );
+	state.counters["header_bytes"] = static_cast<double>( stats.headerBytes );
+	state.counters["internal_frag"] = stats.getInternalFragmentation();
+	state.counters["external_frag"] = stats.getExternalFragmentation();
+}
+
+#define ALLOCATORS_FIXED_SIZES ->RangeMultiplier( 4 )->Range( 8, 4096 )
+#define ALLOCATORS_CONTAINER_SIZES ->RangeMultiplier( 8 )->Range( 64, 4096 )
+#define ALLOCATORS_THREAD_RANGE ->ThreadRange( 1, maxBenchThreads )->UseRealTime()
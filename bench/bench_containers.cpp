@@ -0,0 +1,308 @@
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "bench_common.h"
+#include "linear_allocator.h"
+#include "chunked_vector.h"
+#include "expanding_vector.h"
+#include "flat_map.h"
+#include "small_vector.h"
+#include "string_builder.h"
+#include "string_interner.h"
+
+
+// the arena native containers against the node based std::map and std::vector on the same
+//	LinearAllocator, as in linear_allocator.cpp
+
+using TArena = Arena<>;
+
+template<typename T>
+using LA = LinearAllocator<T>;
+
+using StdMap = std::map<int, int, std::less<int>, LA<std::pair<const int, int>>>;
+using FlatIntMap = FlatMap<int, int, std::less<int>, LA<std::pair<int, int>>>;
+
+// same workload as BM_LinearAllocator_MapInsert
+static void BM_StdMap_Insert( benchmark::State& state )
+{
+	const std::size_t count = static_cast<std::size_t>( state.range( 0 ) );
+	TArena arena{count * 128 + 4096};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		{
+			StdMap map( LA<std::pair<const int, int>>{&arena} );
+			for ( std::size_t i = 0; i < count; ++i )
+			{
+				map.emplace( getKey( i ), static_cast<int>( i ) );
+			}
+			benchmark::DoNotOptimize( map.size() );
+		}
+		state.counters["arena_bytes"] = static_cast<double>( arena.getOffset() );
+		arena.reset();
+	}
+	state.SetItemsProcessed( state.iterations() * count );
+}
+BENCHMARK( BM_StdMap_Insert ) ALLOCATORS_CONTAINER_SIZES;
+
+// element by element; every insert shifts the elements after it
+static void BM_FlatMap_Insert( benchmark::State& state )
+{
+	const std::size_t count = static_cast<std::size_t>( state.range( 0 ) );
+	TArena arena{count * sizeof( std::pair<int, int> ) + 4096};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		{
+			FlatIntMap map{std::less<int>{}, LA<std::pair<int, int>>{&arena}};
+			map.reserve( count );
+			for ( std::size_t i = 0; i < count; ++i )
+			{
+				map.emplace( getKey( i ), static_cast<int>( i ) );
+			}
+			benchmark::DoNotOptimize( map.size() );
+		}
+		state.counters["arena_bytes"] = static_cast<double>( arena.getOffset() );
+		arena.reset();
+	}
+	state.SetItemsProcessed( state.iterations() * count );
+}
+BENCHMARK( BM_FlatMap_Insert ) ALLOCATORS_CONTAINER_SIZES;
+
+// append everything, then sort once
+static void BM_FlatMap_InsertRange( benchmark::State& state )
+{
+	const std::size_t count = static_cast<std::size_t>( state.range( 0 ) );
+	std::vector<std::pair<int, int>> entries;
+	for ( std::size_t i = 0; i < count; ++i )
+	{
+		entries.emplace_back( getKey( i ), static_cast<int>( i ) );
+	}
+	TArena arena{count * sizeof( std::pair<int, int> ) + 4096};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		{
+			FlatIntMap map{std::less<int>{}, LA<std::pair<int, int>>{&arena}};
+			map.reserve( count );
+			map.insert( entries.begin(),
+				entries.end() );
+			benchmark::DoNotOptimize( map.size() );
+		}
+		arena.reset();
+	}
+	state.SetItemsProcessed( state.iterations() * count );
+}
+BENCHMARK( BM_FlatMap_InsertRange ) ALLOCATORS_CONTAINER_SIZES;
+
+template<typename TMap>
+static void BM_Map_Lookup( benchmark::State& state )
+{
+	const std::size_t count = static_cast<std::size_t>( state.range( 0 ) );
+	TArena arena{count * 128 + 4096};
+	TMap map( LA<typename TMap::value_type>{&arena} );
+	for ( std::size_t i = 0; i < count; ++i )
+	{
+		map.emplace( getKey( i ), static_cast<int>( i ) );
+	}
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		int sum = 0;
+		// half the keys are present; they are looked up in a different order than they were
+		//	inserted, else std::map would walk its arena allocated nodes front to back
+		for ( std::size_t i = 0; i < 2 * count; ++i )
+		{
+			const auto it = map.find( getKey( ( i * 7919 ) % ( 2 * count ) ) );
+			if ( it != map.end() )
+			{
+				sum += it->second;
+			}
+		}
+		benchmark::DoNotOptimize( sum );
+	}
+	state.SetItemsProcessed( state.iterations() * 2 * count );
+}
+BENCHMARK_TEMPLATE( BM_Map_Lookup, StdMap ) ALLOCATORS_CONTAINER_SIZES;
+BENCHMARK_TEMPLATE( BM_Map_Lookup, FlatIntMap ) ALLOCATORS_CONTAINER_SIZES;
+
+// arena_bytes: std::vector leaves every outgrown buffer behind in the arena
+template<typename TVector>
+static void BM_Sequence_Append( benchmark::State& state )
+{
+	const std::size_t count = static_cast<std::size_t>( state.range( 0 ) );
+	TArena arena{count * 4 * sizeof( int ) + 64 * TArena::getAlignment()};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		{
+			TVector vec( LA<int>{&arena} );
+			for ( std::size_t i = 0; i < count; ++i )
+			{
+				vec.push_back( static_cast<int>( i ) );
+			}
+			benchmark::DoNotOptimize( &vec.back() );
+		}
+		state.counters["arena_bytes"] = static_cast<double>( arena.getOffset() );
+		arena.reset();
+	}
+	state.SetItemsProcessed( state.iterations() * count );
+}
+BENCHMARK_TEMPLATE( BM_Sequence_Append, std::vector<int, LA<int>> ) ALLOCATORS_CONTAINER_SIZES;
+BENCHMARK_TEMPLATE( BM_Sequence_Append, ChunkedVector<int, 16, LA<int>> ) ALLOCATORS_CONTAINER_SIZES;
+BENCHMARK_TEMPLATE( BM_Sequence_Append, ExpandingVector<int, LA<int>> ) ALLOCATORS_CONTAINER_SIZES;
+
+template<typename TVector>
+static void BM_Sequence_Iterate( benchmark::State& state )
+{
+	const std::size_t count = static_cast<std::size_t>( state.range( 0 ) );
+	TArena arena{count * 4 * sizeof( int ) + 64 * TArena::getAlignment()};
+	TVector vec( LA<int>{&arena} );
+	for ( std::size_t i = 0; i < count; ++i )
+	{
+		vec.push_back( static_cast<int>( i ) );
+	}
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		long long sum = 0;
+		for ( const int value : vec )
+		{
+			sum += value;
+		}
+		benchmark::DoNotOptimize( sum );
+	}
+	state.SetItemsProcessed( state.iterations() * count );
+}
+BENCHMARK_TEMPLATE( BM_Sequence_Iterate, std::vector<int, LA<int>> ) ALLOCATORS_CONTAINER_SIZES;
+BENCHMARK_TEMPLATE( BM_Sequence_Iterate, ChunkedVector<int, 16, LA<int>> ) ALLOCATORS_CONTAINER_SIZES;
+
+// one string built from many pieces, as when formatting a log line or a path
+template<typename TString>
+static void BM_String_Append( benchmark::State& state )
+{
+	const std::size_t count = static_cast<std::size_t>( state.range( 0 ) );
+	TArena arena{count * 4 * churnText.size() + 4096};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		{
+			TString str( LA<char>{&arena} );
+			for ( std::size_t i = 0; i < count; ++i )
+			{
+				str += churnText.substr( 0, getChurnLength( i ) );
+			}
+			benchmark::DoNotOptimize( str.data() );
+		}
+		state.counters["arena_bytes"] = static_cast<double>( arena.getOffset() );
+		arena.reset();
+	}
+	state.SetItemsProcessed( state.iterations() * count );
+}
+BENCHMARK_TEMPLATE( BM_String_Append, std::basic_string<char, std::char_traits<char>, LA<char>> ) ALLOCATORS_CONTAINER_SIZES;
+BENCHMARK_TEMPLATE( BM_String_Append, ExpandingString<LA<char>> ) ALLOCATORS_CONTAINER_SIZES;
+
+// many short lists of 1 to 16 elements, most of which fit the inline capacity
+template<typename TVector>
+static void BM_ShortLists( benchmark::State& state )
+{
+	TArena arena{batchSize * 16 * 4 * sizeof( int ) + 64 * TArena::getAlignment()};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( std::size_t list = 0; list < batchSize; ++list )
+		{
+			TVector vec( LA<int>{&arena} );
+			const std::size_t length = 1 + ( list * 7 ) % 16;
+			for ( std::size_t i = 0; i < length; ++i )
+			{
+				vec.push_back( static_cast<int>( i ) );
+			}
+			benchmark::DoNotOptimize( vec.data() );
+		}
+		state.counters["arena_bytes"] = static_cast<double>( arena.getOffset() );
+		arena.reset();
+	}
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK_TEMPLATE( BM_ShortLists, std::vector<int, LA<int>> );
+BENCHMARK_TEMPLATE( BM_ShortLists, SmallVector<int, 8, LA<int>> );
+
+// symbol tables: `count` lookups over count / 8 distinct names, as when tokenizing source
+static std::vector<std::string> getSymbols( const std::size_t count )
+{
+	std::vector<std::string> symbols;
+	symbols.reserve( count );
+	for ( std::size_t i = 0; i < count; ++i )
+	{
+		const std::size_t symbol = ( i * 7919 ) % ( count / 8 + 1 );
+		symbols.push_back( std::string{churnText.substr( 0, getChurnLength( symbol ) )} + std::to_string( symbol ) );
+	}
+	return symbols;
+}
+
+static void BM_Intern_UnorderedSet( benchmark::State& state )
+{
+	const std::size_t count = static_cast<std::size_t>( state.range( 0 ) );
+	const std::vector<std::string> symbols = getSymbols( count );
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		std::unordered_set<std::string> set;
+		for ( const std::string& symbol : symbols )
+		{
+			benchmark::DoNotOptimize( set.insert( symbol ).first->data() );
+		}
+	}
+	state.SetItemsProcessed( state.iterations() * count );
+}
+BENCHMARK( BM_Intern_UnorderedSet ) ALLOCATORS_CONTAINER_SIZES;
+
+// arena_bytes: each distinct name once, packed
+static void BM_Intern_StringInterner( benchmark::State& state )
+{
+	const std::size_t count = static_cast<std::size_t>( state.range( 0 ) );
+	const std::vector<std::string> symbols = getSymbols( count );
+	Arena<1> arena{count * 64 + 4096};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		{
+			StringInterner<Arena<1>> interner{&arena};
+			for ( const std::string& symbol : symbols )
+			{
+				benchmark::DoNotOptimize( interner.getId( symbol ) );
+			}
+		}
+		state.counters["arena_bytes"] = static_cast<double>( arena.getOffset() );
+		arena.reset();
+	}
+	state.SetItemsProcessed( state.iterations() * count );
+}
+BENCHMARK( BM_Intern_StringInterner ) ALLOCATORS_CONTAINER_SIZES;
+
+// the pieces of BM_String_Append, finished into a null terminated string
+static void BM_StringBuilder_Append( benchmark::State& state )
+{
+	const std::size_t count = static_cast<std::size_t>( state.range( 0 ) );
+	Arena<1> arena{count * 4 * churnText.size() + 4096};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		StringBuilder<Arena<1>> builder{&arena};
+		for ( std::size_t i = 0; i < count; ++i )
+		{
+			builder += churnText.substr( 0, getChurnLength( i ) );
+		}
+		benchmark::DoNotOptimize( builder.finish().data() );
+		state.counters["arena_bytes"] = static_cast<double>( arena.getOffset() );
+		arena.reset();
+	}
+	state.SetItemsProcessed( state.iterations() * count );
+}
+BENCHMARK( BM_StringBuilder_Append ) ALLOCATORS_CONTAINER_SIZES;
+
+BENCHMARK_MAIN();
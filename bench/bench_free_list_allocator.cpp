@@ -0,0 +1,257 @@
+#include <cstdlib>
+#include <list>
+#include <map>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "bench_common.h"
+#include "free_list_allocator.h"
+
+
+inline constexpr std::size_t freeListArenaSize = 4 * 1024 * 1024;
+// live blocks of the randomised churn, about 1/4 of the arena at the mixed sizes
+inline constexpr std::size_t nChurnBlocks = 2048;
+
+struct MallocPolicy final
+{
+	void* allocate( const std::size_t bytes )
+	{
+		return std::malloc( bytes );
+	}
+
+	void deallocate( void* p ) noexcept
+	{
+		std::free( p );
+	}
+};
+
+template<FitPolicy fitPolicy>
+struct FreeListPolicy final
+{
+	FreeListArena<fitPolicy> arena{freeListArenaSize};
+
+	void* allocate( const std::size_t bytes )
+	{
+		return arena.allocate( bytes );
+	}
+
+	void deallocate( void* p ) noexcept
+	{
+		arena.deallocate( p );
+	}
+};
+
+template<typename TPolicy>
+static void reportFreeList( benchmark::State&,
+	const TPolicy& )
+{
+
+}
+
+template<FitPolicy fitPolicy>
+static void reportFreeList( benchmark::State& state,
+	const FreeListPolicy<fitPolicy>& policy )
+{
+	reportStats( state,
+		policy.arena.getStats() );
+	state.counters["free_blocks"] = static_cast<double>( policy.arena.getFreeBlockCount() );
+}
+
+// randomised: each step frees a random live block and allocates the next mixed size in its
+//	place, so holes open all over the arena
+template<typename TPolicy>
+static void BM_RandomChurn( benchmark::State& state )
+{
+	TPolicy policy;
+	const auto& sizes = getMixedSizes();
+	std::vector<void*> live(nChurnBlocks);
+	std::size_t step = 0;
+	for ( void*& p : live )
+	{
+		p = policy.allocate( sizes[step++ % batchSize] );
+	}
+	std::mt19937 rng{1453};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( std::size_t i = 0; i < batchSize; ++i, ++step )
+		{
+			void*& p = live[rng() % nChurnBlocks];
+			policy.deallocate( p );
+			p = policy.allocate( sizes[step % batchSize] );
+			benchmark::DoNotOptimize( p );
+		}
+	}
+	reportFreeList( state,
+		policy );
+	for ( void* p : live )
+	{
+		policy.deallocate( p );
+	}
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK_TEMPLATE( BM_RandomChurn, FreeListPolicy<FitPolicy::FirstFit> );
+BENCHMARK_TEMPLATE( BM_RandomChurn, FreeListPolicy<FitPolicy::NextFit> );
+BENCHMARK_TEMPLATE( BM_RandomChurn, FreeListPolicy<FitPolicy::BestFit> );
+BENCHMARK_TEMPLATE( BM_RandomChurn, MallocPolicy );
+
+// trace driven: the allocations and frees of a real container workload, recorded once and
+//	replayed on every allocator
+struct TraceEvent final
+{
+	std::uint32_t id;
+	// 0 frees block `id`
+	std::uint32_t bytes;
+};
+
+struct Trace final
+{
+	std::vector<TraceEvent> events;
+	std::unordered_map<void*, std::uint32_t> liveIds;
+	std::uint32_t nIds = 0;
+};
+
+static Trace& getRecordingTrace()
+{
+	static Trace trace;
+	return trace;
+}
+
+template<typename T>
+struct RecordingAllocator
+{
+	using value_type = T;
+
+	RecordingAllocator() noexcept = default;
+
+	template<typename Other>
+	RecordingAllocator( const RecordingAllocator<Other>& ) noexcept
+	{
+
+	}
+
+	T* allocate( const std::size_t count )
+	{
+		T* p = static_cast<T*>( std::malloc( count * sizeof( T ) ) );
+		Trace& trace = getRecordingTrace();
+		trace.liveIds[p] = trace.nIds;
+		trace.events.push_back( TraceEvent{trace.nIds++, static_cast<std::uint32_t>( count * sizeof( T ) )} );
+		return p;
+	}
+
+	void deallocate( T* p,
+		std::size_t ) noexcept
+	{
+		Trace& trace = getRecordingTrace();
+		const auto it = trace.liveIds.find( p );
+		trace.events.push_back( TraceEvent{it->second, 0} );
+		trace.liveIds.erase( it );
+		std::free( p );
+	}
+};
+
+template<typename T, typename Other>
+bool operator==( const RecordingAllocator<T>&,
+	const RecordingAllocator<Other>& ) noexcept
+{
+	return true;
+}
+
+template<typename T, typename Other>
+bool operator!=( const RecordingAllocator<T>&,
+	const RecordingAllocator<Other>& ) noexcept
+{
+	return false;
+}
+
+// a symbol table and a work queue: strings, map nodes and vectors of all sizes, created and
+//	destroyed in the order the program logic dictates rather than LIFO
+static const Trace& getTrace()
+{
+	static const Trace& trace = []() -> const Trace&
+		{
+			using rstring = std::basic_string<char, std::char_traits<char>, RecordingAllocator<char>>;
+			using rvector = std::vector<int, RecordingAllocator<int>>;
+			{
+				std::map<rstring, rvector, std::less<>, RecordingAllocator<std::pair<const rstring, rvector>>> symbols;
+				std::list<rstring, RecordingAllocator<rstring>> queue;
+				for ( std::size_t i = 0; i < 4 * batchSize; ++i )
+				{
+					rstring key{churnText.substr( 0, getChurnLength( i ) )};
+					key += std::to_string( getKey( i ) % 512 ).c_str();
+					rvector& uses = symbols[key];
+					uses.push_back( static_cast<int>( i ) );
+					queue.emplace_back( churnText.substr( 0, getChurnLength( i * 3 ) ) );
+					if ( queue.size() > 64 )
+					{
+						queue.pop_front();
+					}
+					if ( i % 7 == 0 )
+					{
+						symbols.erase( symbols.begin() );
+					}
+				}
+			}
+			return getRecordingTrace();
+		}();
+	return trace;
+}
+
+template<typename TPolicy>
+static void replay( TPolicy& policy,
+	std::vector<void*>& blocks,
+	const TraceEvent* pBegin,
+	const TraceEvent* pEnd )
+{
+	for ( const TraceEvent* pEvent = pBegin; pEvent != pEnd; ++pEvent )
+	{
+		if ( pEvent->bytes != 0 )
+		{
+			blocks[pEvent->id] = policy.allocate( pEvent->bytes );
+		}
+		else
+		{
+			policy.deallocate( blocks[pEvent->id] );
+		}
+	}
+}
+
+template<typename TPolicy>
+static void BM_TraceReplay( benchmark::State& state )
+{
+	const Trace& trace = getTrace();
+	const TraceEvent* pBegin = trace.events.data();
+	const TraceEvent* pMiddle = pBegin + trace.events.size() / 2;
+	const TraceEvent* pEnd = pBegin + trace.events.size();
+	TPolicy policy;
+	std::vector<void*> blocks(trace.nIds);
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		replay( policy,
+			blocks,
+			pBegin,
+			pEnd );
+		benchmark::DoNotOptimize( blocks.data() );
+	}
+	// every block is freed by the end of the trace; report the layout halfway through instead
+	replay( policy,
+		blocks,
+		pBegin,
+		pMiddle );
+	reportFreeList( state,
+		policy );
+	replay( policy,
+		blocks,
+		pMiddle,
+		pEnd );
+	state.counters["events"] = static_cast<double>( trace.events.size() );
+	state.SetItemsProcessed( state.iterations() * trace.events.size() );
+}
+BENCHMARK_TEMPLATE( BM_TraceReplay, FreeListPolicy<FitPolicy::FirstFit> );
+BENCHMARK_TEMPLATE( BM_TraceReplay, FreeListPolicy<FitPolicy::NextFit> );
+BENCHMARK_TEMPLATE( BM_TraceReplay, FreeListPolicy<FitPolicy::BestFit> );
+BENCHMARK_TEMPLATE( BM_TraceReplay, MallocPolicy );
+
+BENCHMARK_MAIN();
@@ -0,0 +1,200 @@
+#include <array>
+#include <cmath>
+#include <new>
+#include <random>
+#include <vector>
+#if defined(_MSC_VER) || defined(_WIN32) || defined(_WIN64)
+#	ifndef NOMINMAX
+#		define NOMINMAX
+#	endif
+#	include <windows.h>
+#else
+#	include <sys/mman.h>
+#endif
+#include "bench_common.h"
+#include "large_block_allocator.h"
+
+
+inline constexpr std::size_t minLargeSize = 4 * 1024;
+inline constexpr std::size_t maxLargeSize = 64 * 1024 * 1024;
+// buffers the churn keeps around; each step replaces a random one
+inline constexpr std::size_t nLiveBuffers = 32;
+
+// address space only: pages are committed as the heap grows
+struct LargeBlockPolicy final
+{
+	LargeBlockHeap heap{std::size_t{16} * 1024 * 1024 * 1024};
+
+	void* allocate( const std::size_t bytes )
+	{
+		return heap.allocate( bytes );
+	}
+
+	void deallocate( void* p,
+		std::size_t ) noexcept
+	{
+		heap.deallocate( p );
+	}
+};
+
+// the usual way to get large buffers straight from the OS: a mapping per buffer
+struct MmapPolicy final
+{
+	void* allocate( const std::size_t bytes )
+	{
+#if defined(_MSC_VER) || defined(_WIN32) || defined(_WIN64)
+		void* p = VirtualAlloc( nullptr,
+			bytes,
+			MEM_RESERVE | MEM_COMMIT,
+			PAGE_READWRITE );
+		if ( p == nullptr )
+		{
+			throw std::bad_alloc{};
+		}
+#else
+		void* p = mmap( nullptr,
+			bytes,
+			PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS,
+			-1,
+			0 );
+		if ( p == MAP_FAILED )
+		{
+			throw std::bad_alloc{};
+		}
+#endif
+		return p;
+	}
+
+	void deallocate( void* p,
+		[[maybe_unused]] const std::size_t bytes ) noexcept
+	{
+#if defined(_MSC_VER) || defined(_WIN32) || defined(_WIN64)
+		VirtualFree( p,
+			0,
+			MEM_RELEASE );
+#else
+		munmap( p,
+			bytes );
+#endif
+	}
+};
+
+template<typename TPolicy>
+static void reportLargeBlocks( benchmark::State&,
+	const TPolicy& )
+{
+
+}
+
+static void reportLargeBlocks( benchmark::State& state,
+	const LargeBlockPolicy& policy )
+{
+	reportStats( state,
+		policy.heap.getStats() );
+	state.counters["free_blocks"] = static_cast<double>( policy.heap.getFreeBlockCount() );
+	// the part of the heap below the top that is holes
+	state.counters["hole_ratio"] = policy.heap.getTopOffset() == 0 ?
+		0.0 :
+		static_cast<double>( policy.heap.getFreeBlockBytes() ) / static_cast<double>( policy.heap.getTopOffset() );
+	state.counters["committed_bytes"] = static_cast<double>( policy.heap.getCommittedBytes() );
+}
+
+// log-uniform in [minLargeSize, maxLargeSize], so every power of 2 is as likely
+static const std::array<std::size_t, batchSize>& getLargeSizes()
+{
+	static const std::array<std::size_t, batchSize> sizes = []()
+		{
+			std::array<std::size_t, batchSize> sizes{};
+			std::mt19937 rng{1453};
+			std::uniform_real_distribution<double> exponent{std::log2( static_cast<double>( minLargeSize ) ),
+				std::log2( static_cast<double>( maxLargeSize ) )};
+			for ( std::size_t& size : sizes )
+			{
+				size = static_cast<std::size_t>( std::exp2( exponent( rng ) ) );
+			}
+			return sizes;
+		}();
+	return sizes;
+}
+
+// a buffer is written before it's used; either its first byte only or a byte per page,
+//	which is where a fresh mapping pays its page faults
+static void touch( void* p,
+	const std::size_t bytes,
+	const bool bEveryPage ) noexcept
+{
+	unsigned char* pBytes = static_cast<unsigned char*>( p );
+	const std::size_t step = bEveryPage ?
+		4096 :
+		bytes;
+	for ( std::size_t offset = 0; offset < bytes; offset += step )
+	{
+		pBytes[offset] = 1;
+	}
+	benchmark::DoNotOptimize( pBytes );
+}
+
+// one buffer of a fixed size, allocated, written and freed
+template<typename TPolicy>
+static void BM_AllocateFree( benchmark::State& state )
+{
+	const std::size_t bytes = static_cast<std::size_t>( state.range( 0 ) );
+	TPolicy policy;
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		void* p = policy.allocate( bytes );
+		touch( p,
+			bytes,
+			false );
+		policy.deallocate( p,
+			bytes );
+	}
+	state.SetItemsProcessed( state.iterations() );
+}
+BENCHMARK_TEMPLATE( BM_AllocateFree, LargeBlockPolicy )->RangeMultiplier( 16 )->Range( minLargeSize, maxLargeSize );
+BENCHMARK_TEMPLATE( BM_AllocateFree, MmapPolicy )->RangeMultiplier( 16 )->Range( minLargeSize, maxLargeSize );
+
+// `nLiveBuffers` buffers of mixed sizes; each step frees a random one and allocates the next
+//	size in its place; argument 1 writes every page of each new buffer
+template<typename TPolicy>
+static void BM_Churn( benchmark::State& state )
+{
+	const bool bEveryPage = state.range( 0 ) != 0;
+	TPolicy policy;
+	const auto& sizes = getLargeSizes();
+	std::array<void*, nLiveBuffers> buffers{};
+	std::array<std::size_t, nLiveBuffers> bufferSizes{};
+	std::size_t step = 0;
+	for ( std::size_t i = 0; i < nLiveBuffers; ++i, ++step )
+	{
+		bufferSizes[i] = sizes[step];
+		buffers[i] = policy.allocate( bufferSizes[i] );
+	}
+	std::mt19937 rng{1453};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		const std::size_t i = rng() % nLiveBuffers;
+		policy.deallocate( buffers[i],
+			bufferSizes[i] );
+		bufferSizes[i] = sizes[step++ % batchSize];
+		buffers[i] = policy.allocate( bufferSizes[i] );
+		touch( buffers[i],
+			bufferSizes[i],
+			bEveryPage );
+	}
+	reportLargeBlocks( state,
+		policy );
+	for ( std::size_t i = 0; i < nLiveBuffers; ++i )
+	{
+		policy.deallocate( buffers[i],
+			bufferSizes[i] );
+	}
+	state.SetItemsProcessed( state.iterations() );
+}
+BENCHMARK_TEMPLATE( BM_Churn, LargeBlockPolicy )->Arg( 0 )->Arg( 1 );
+BENCHMARK_TEMPLATE( BM_Churn, MmapPolicy )->Arg( 0 )->Arg( 1 );
+
+BENCHMARK_MAIN();
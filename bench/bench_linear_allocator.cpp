@@ -0,0 +1,431 @@
+#include <atomic>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+#include "bench_common.h"
+#include "linear_allocator.h"
+#include "epoch_arenas.h"
+#include "frame_allocator.h"
+
+
+using TArena = Arena<>;
+
+template<typename T>
+using LA = LinearAllocator<T>;
+
+// Arena never frees individual blocks; a batch is "freed" by resetting the arena
+static void BM_Arena_AllocateFixed( benchmark::State& state )
+{
+	const std::size_t bytes = static_cast<std::size_t>( state.range( 0 ) );
+	TArena arena{batchSize * ( bytes + TArena::getAlignment() )};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( std::size_t i = 0; i < batchSize; ++i )
+		{
+			benchmark::DoNotOptimize( arena.allocate( bytes ) );
+		}
+		arena.reset();
+	}
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK( BM_Arena_AllocateFixed ) ALLOCATORS_FIXED_SIZES;
+
+static void BM_Arena_AllocateMixed( benchmark::State& state )
+{
+	const auto& sizes = getMixedSizes();
+	TArena arena{getMixedSizesFootprint( TArena::getAlignment() )};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( const std::size_t bytes : sizes )
+		{
+			benchmark::DoNotOptimize( arena.allocate( bytes ) );
+		}
+		arena.reset();
+	}
+	for ( const std::size_t bytes : sizes )
+	{
+		benchmark::DoNotOptimize( arena.allocate( bytes ) );
+	}
+	reportStats( state,
+		arena.getStats() );
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK( BM_Arena_AllocateMixed );
+
+static void BM_LinearAllocator_VectorGrowth( benchmark::State& state )
+{
+	const std::size_t count = static_cast<std::size_t>( state.range( 0 ) );
+	TArena arena{count * 4 * sizeof( int ) + 64 * TArena::getAlignment()};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		{
+			std::vector<int, LA<int>> vec( LA<int>{&arena} );
+			for ( std::size_t i = 0; i < count; ++i )
+			{
+				vec.push_back( static_cast<int>( i ) );
+			}
+			benchmark::DoNotOptimize( vec.data() );
+		}
+		arena.reset();
+	}
+	state.SetItemsProcessed( state.iterations() * count );
+}
+BENCHMARK( BM_LinearAllocator_VectorGrowth ) ALLOCATORS_CONTAINER_SIZES;
+
+static void BM_LinearAllocator_MapInsert( benchmark::State& state )
+{
+	using Map = std::map<int, int, std::less<int>, LA<std::pair<const int, int>>>;
+	const std::size_t count = static_cast<std::size_t>( state.range( 0 ) );
+	TArena arena{count * 128 + 4096};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		{
+			Map map( LA<std::pair<const int, int>>{&arena} );
+			for ( std::size_t i = 0; i < count; ++i )
+			{
+				map.emplace( getKey( i ), static_cast<int>( i ) );
+			}
+			benchmark::DoNotOptimize( map.size() );
+		}
+		arena.reset();
+	}
+	state.SetItemsProcessed( state.iterations() * count );
+}
+BENCHMARK( BM_LinearAllocator_MapInsert ) ALLOCATORS_CONTAINER_SIZES;
+
+static void BM_LinearAllocator_StringChurn( benchmark::State& state )
+{
+	using Str = std::basic_string<char, std::char_traits<char>, LA<char>>;
+	const std::size_t count = static_cast<std::size_t>( state.range( 0 ) );
+	TArena arena{count * 768 + 4096};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		{
+			LA<char> la{&arena};
+			std::vector<Str, LA<Str>> strings( la );
+			strings.reserve( count );
+			for ( std::size_t i = 0; i < count; ++i )
+			{
+				strings.emplace_back( churnText.substr( 0, getChurnLength( i ) ), la );
+				strings.back() += churnText.substr( 0, getChurnLength( i + 1 ) );
+			}
+			benchmark::DoNotOptimize( strings.data() );
+		}
+		arena.reset();
+	}
+	state.SetItemsProcessed( state.iterations() * count );
+}
+BENCHMARK( BM_LinearAllocator_StringChurn ) ALLOCATORS_CONTAINER_SIZES;
+
+// Arena is single-threaded; each thread owns one, so this measures scaling without sharing
+static void BM_Arena_ThreadScaling( benchmark::State& state )
+{
+	const auto& sizes = getMixedSizes();
+	TArena arena{getMixedSizesFootprint( TArena::getAlignment() )};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( const std::size_t bytes : sizes )
+		{
+			benchmark::DoNotOptimize( arena.allocate( bytes ) );
+		}
+		arena.reset();
+	}
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK( BM_Arena_ThreadScaling ) ALLOCATORS_THREAD_RANGE;
+
+// one arena shared by 1 to 64 threads; each thread allocates `batchSize` blocks of
+//	`sharedBlockSize` bytes per iteration and writes a byte into each, as a real user would
+//	a shared arena can't be reset while other threads use it, so the iteration count is fixed
+//	and the arena, reset before every run, is sized for all of it
+inline constexpr int maxSharedArenaThreads = 64;
+inline constexpr std::size_t sharedBlockSize = 16;
+inline constexpr benchmark::IterationCount sharedArenaIterations = 64;
+inline constexpr std::size_t sharedArenaSize = maxSharedArenaThreads * sharedArenaIterations * batchSize * sharedBlockSize;
+
+#define ALLOCATORS_SHARED_ARENA_THREADS ->ThreadRange( 1, maxSharedArenaThreads )->Iterations( sharedArenaIterations )->UseRealTime()
+
+static ConcurrentArena<16>& getConcurrentArena()
+{
+	static ConcurrentArena<16> arena{sharedArenaSize};
+	return arena;
+}
+
+struct LockedArena final
+{
+	std::mutex mutex;
+	Arena<16> arena{sharedArenaSize};
+};
+
+static LockedArena& getLockedArena()
+{
+	static LockedArena lockedArena;
+	return lockedArena;
+}
+
+static void resetSharedArenas( const benchmark::State& )
+{
+	getConcurrentArena().reset();
+	getLockedArena().arena.reset();
+}
+
+// a single fetch_add per allocation
+static void BM_ConcurrentArena_Shared( benchmark::State& state )
+{
+	ConcurrentArena<16>& arena = getConcurrentArena();
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( std::size_t i = 0; i < batchSize; ++i )
+		{
+			auto* p = static_cast<unsigned char*>( arena.allocate( sharedBlockSize ) );
+			*p = 1;
+			benchmark::DoNotOptimize( p );
+		}
+	}
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK( BM_ConcurrentArena_Shared ) ALLOCATORS_SHARED_ARENA_THREADS->Setup( resetSharedArenas );
+
+// the plain Arena behind a mutex, the obvious way to share it
+static void BM_LockedArena_Shared( benchmark::State& state )
+{
+	LockedArena& lockedArena = getLockedArena();
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( std::size_t i = 0; i < batchSize; ++i )
+		{
+			unsigned char* p;
+			{
+				std::lock_guard<std::mutex> lock{lockedArena.mutex};
+				p = static_cast<unsigned char*>( lockedArena.arena.allocate( sharedBlockSize ) );
+			}
+			*p = 1;
+			benchmark::DoNotOptimize( p );
+		}
+	}
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK( BM_LockedArena_Shared ) ALLOCATORS_SHARED_ARENA_THREADS->Setup( resetSharedArenas );
+
+// the upper bound: an Arena per thread, nothing shared
+static void BM_Arena_PerThread( benchmark::State& state )
+{
+	Arena<16> arena{sharedArenaIterations * batchSize * sharedBlockSize};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( std::size_t i = 0; i < batchSize; ++i )
+		{
+			auto* p = static_cast<unsigned char*>( arena.allocate( sharedBlockSize ) );
+			*p = 1;
+			benchmark::DoNotOptimize( p );
+		}
+	}
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK( BM_Arena_PerThread ) ALLOCATORS_SHARED_ARENA_THREADS;
+
+// containers on different threads filling one arena through `ConcurrentLinearAllocator`
+//	`batchSize` ints per iteration, in vectors of 16 that reserve up front
+static void BM_ConcurrentLinearAllocator_Vectors( benchmark::State& state )
+{
+	using Vector = std::vector<int, ConcurrentLinearAllocator<int, 16>>;
+	ConcurrentLinearAllocator<int, 16> alloc{&getConcurrentArena()};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( std::size_t v = 0; v < batchSize / 16; ++v )
+		{
+			Vector vec( alloc );
+			vec.reserve( 16 );
+			for ( int i = 0; i < 16; ++i )
+			{
+				vec.push_back( i );
+			}
+			benchmark::DoNotOptimize( vec.data() );
+		}
+	}
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK( BM_ConcurrentLinearAllocator_Vectors ) ALLOCATORS_SHARED_ARENA_THREADS->Setup( resetSharedArenas );
+
+// read-mostly table lookups while thread 0 also republishes the table once per iteration
+//	`batchSize` lookups per iteration and thread
+inline constexpr int nTableEntries = 64;
+
+struct LookupTable final
+{
+	int entries[nTableEntries];
+};
+
+static void fillTable( LookupTable& table,
+	const int version ) noexcept
+{
+	for ( int i = 0; i < nTableEntries; ++i )
+	{
+		table.entries[i] = version + i;
+	}
+}
+
+struct EpochTable final
+{
+	EpochArenas<16> epochArenas{16 * 1024, maxSharedArenaThreads};
+	std::atomic<const LookupTable*> pTable{nullptr};
+
+	void publish( const int version )
+	{
+		epochArenas.advance();
+		auto* pNew = static_cast<LookupTable*>( epochArenas.getArena().allocate( sizeof( LookupTable ) ) );
+		fillTable( *pNew,
+			version );
+		pTable.store( pNew,
+			std::memory_order_release );
+	}
+};
+
+static EpochTable& getEpochTable()
+{
+	static EpochTable epochTable;
+	return epochTable;
+}
+
+struct LockedTable final
+{
+	std::shared_mutex mutex;
+	LookupTable table{};
+};
+
+static LockedTable& getLockedTable()
+{
+	static LockedTable lockedTable;
+	return lockedTable;
+}
+
+static void publishTables( const benchmark::State& )
+{
+	getEpochTable().publish( 0 );
+	fillTable( getLockedTable().table,
+		0 );
+}
+
+// a lookup is a store to the reader's slot, the pointer load and a store on the way out
+//	the writer builds each version in the next epoch's arena and never blocks the readers
+static void BM_EpochArenas_Read( benchmark::State& state )
+{
+	EpochTable& epochTable = getEpochTable();
+	const std::size_t slot = epochTable.epochArenas.registerReader();
+	int version = 0;
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		if ( state.thread_index() == 0 )
+		{
+			epochTable.publish( ++version );
+		}
+		for ( std::size_t i = 0; i < batchSize; ++i )
+		{
+			EpochArenas<16>::ReadGuard guard = epochTable.epochArenas.read( slot );
+			const LookupTable* pTable = epochTable.pTable.load( std::memory_order_acquire );
+			benchmark::DoNotOptimize( pTable->entries[i % nTableEntries] );
+		}
+	}
+	epochTable.epochArenas.unregisterReader( slot );
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK( BM_EpochArenas_Read ) ALLOCATORS_SHARED_ARENA_THREADS->Setup( publishTables );
+
+// the same lookups under a std::shared_mutex, with the writer updating the table in place
+static void BM_SharedMutex_Read( benchmark::State& state )
+{
+	LockedTable& lockedTable = getLockedTable();
+	int version = 0;
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		if ( state.thread_index() == 0 )
+		{
+			std::unique_lock<std::shared_mutex> lock{lockedTable.mutex};
+			fillTable( lockedTable.table,
+				++version );
+		}
+		for ( std::size_t i = 0; i < batchSize; ++i )
+		{
+			std::shared_lock<std::shared_mutex> lock{lockedTable.mutex};
+			benchmark::DoNotOptimize( lockedTable.table.entries[i % nTableEntries] );
+		}
+	}
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK( BM_SharedMutex_Read ) ALLOCATORS_SHARED_ARENA_THREADS->Setup( publishTables );
+
+// per-frame objects that live for two frames: `batchSize` 64 byte objects per iteration (frame)
+struct FrameObject final
+{
+	float values[16];
+};
+
+static void BM_FrameAllocator_Frames( benchmark::State& state )
+{
+	FrameAllocator<2> frames{batchSize * sizeof( FrameObject )};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		frames.beginFrame();
+		for ( std::size_t i = 0; i < batchSize; ++i )
+		{
+			FrameAllocator<2>::Ptr<FrameObject> p = frames.create<FrameObject>();
+			p->values[0] = 1.0f;
+			benchmark::DoNotOptimize( p.get() );
+		}
+	}
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK( BM_FrameAllocator_Frames );
+
+// the same objects with new, deleted when their frame is two frames old
+static void BM_NewDelete_Frames( benchmark::State& state )
+{
+	std::vector<FrameObject*> frames[2];
+	frames[0].reserve( batchSize );
+	frames[1].reserve( batchSize );
+	std::size_t frame = 0;
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		std::vector<FrameObject*>& current = frames[++frame % 2];
+		for ( FrameObject* p : current )
+		{
+			delete p;
+		}
+		current.clear();
+		for ( std::size_t i = 0; i < batchSize; ++i )
+		{
+			FrameObject* p = new FrameObject;
+			p->values[0] = 1.0f;
+			benchmark::DoNotOptimize( p );
+			current.push_back( p );
+		}
+	}
+	for ( std::vector<FrameObject*>& objects : frames )
+	{
+		for ( FrameObject* p : objects )
+		{
+			delete p;
+		}
+	}
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK( BM_NewDelete_Frames );
+
+BENCHMARK_MAIN();
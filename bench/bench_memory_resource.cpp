@@ -0,0 +1,181 @@
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <vector>
+#include "bench_common.h"
+#include "linear_allocator.h"
+#include "memory_resources.h"
+
+
+// the strategy is a runtime argument: every benchmark below is a single instantiation
+enum ResourceKind : int
+{
+	NewDelete,
+	ArenaBacked,
+	PoolBacked,
+	Tracking,
+	StdMonotonic,
+	StdUnsynchronizedPool
+};
+
+constexpr std::size_t resourceArenaSize = 16 * 1024 * 1024;
+constexpr std::size_t resourceSlotsPerClass = 4096;
+
+using TResourceArena = Arena<alignof( std::max_align_t )>;
+using TPoolResource = PoolResource<16, 32, 64, 128, 256, 512, 1024>;
+
+// owns the resource of the given kind for the length of one benchmark
+class ResourceFixture final
+{
+	std::unique_ptr<TResourceArena> m_pArena;
+	std::unique_ptr<std::pmr::memory_resource> m_pResource;
+public:
+	explicit ResourceFixture( const int kind )
+	{
+		switch ( kind )
+		{
+		case ArenaBacked:
+			m_pArena = std::make_unique<TResourceArena>( resourceArenaSize );
+			m_pResource = std::make_unique<ArenaResource<TResourceArena>>( m_pArena.get() );
+			break;
+		case PoolBacked:
+			m_pResource = std::make_unique<TPoolResource>( resourceSlotsPerClass );
+			break;
+		case Tracking:
+			m_pResource = std::make_unique<TrackingResource>();
+			break;
+		case StdMonotonic:
+			m_pResource = std::make_unique<std::pmr::monotonic_buffer_resource>( resourceArenaSize );
+			break;
+		case StdUnsynchronizedPool:
+			m_pResource = std::make_unique<std::pmr::unsynchronized_pool_resource>();
+			break;
+		default:
+			break;
+		}
+	}
+
+	std::pmr::memory_resource* get() const noexcept
+	{
+		return m_pResource ?
+			m_pResource.get() :
+			std::pmr::new_delete_resource();
+	}
+
+	// monotonic strategies never give memory back; start each iteration from scratch
+	void recycle() noexcept
+	{
+		if ( m_pArena )
+		{
+			m_pArena->reset();
+		}
+		if ( auto pMonotonic = dynamic_cast<std::pmr::monotonic_buffer_resource*>( m_pResource.get() ) )
+		{
+			pMonotonic->release();
+		}
+	}
+};
+
+static void resourceKinds( benchmark::internal::Benchmark* b )
+{
+	for ( int kind = NewDelete; kind <= StdUnsynchronizedPool; ++kind )
+	{
+		for ( std::int64_t count = 64; count <= 4096; count *= 8 )
+		{
+			b->Args( {kind, count} );
+		}
+	}
+	b->ArgNames( {"resource", "count"} );
+}
+
+static void BM_Pmr_AllocateMixed( benchmark::State& state )
+{
+	const auto& sizes = getMixedSizes();
+	ResourceFixture fixture{static_cast<int>( state.range( 0 ) )};
+	std::pmr::memory_resource* pResource = fixture.get();
+	std::vector<void*> ptrs( batchSize );
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( std::size_t i = 0; i < batchSize; ++i )
+		{
+			ptrs[i] = pResource->allocate( sizes[i] );
+		}
+		benchmark::DoNotOptimize( ptrs.data() );
+		for ( std::size_t i = batchSize; i-- > 0; )
+		{
+			pResource->deallocate( ptrs[i], sizes[i] );
+		}
+		fixture.recycle();
+	}
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK( BM_Pmr_AllocateMixed )->DenseRange( NewDelete, StdUnsynchronizedPool )->ArgName( "resource" );
+
+static void BM_Pmr_VectorGrowth( benchmark::State& state )
+{
+	ResourceFixture fixture{static_cast<int>( state.range( 0 ) )};
+	const std::size_t count = static_cast<std::size_t>( state.range( 1 ) );
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		{
+			std::pmr::vector<int> vec{fixture.get()};
+			for ( std::size_t i = 0; i < count; ++i )
+			{
+				vec.push_back( static_cast<int>( i ) );
+			}
+			benchmark::DoNotOptimize( vec.data() );
+		}
+		fixture.recycle();
+	}
+	state.SetItemsProcessed( state.iterations() * count );
+}
+BENCHMARK( BM_Pmr_VectorGrowth )->Apply( resourceKinds );
+
+static void BM_Pmr_MapInsert( benchmark::State& state )
+{
+	ResourceFixture fixture{static_cast<int>( state.range( 0 ) )};
+	const std::size_t count = static_cast<std::size_t>( state.range( 1 ) );
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		{
+			std::pmr::map<int, int> map{fixture.get()};
+			for ( std::size_t i = 0; i < count; ++i )
+			{
+				map.emplace( getKey( i ), static_cast<int>( i ) );
+			}
+			benchmark::DoNotOptimize( map.size() );
+		}
+		fixture.recycle();
+	}
+	state.SetItemsProcessed( state.iterations() * count );
+}
+BENCHMARK( BM_Pmr_MapInsert )->Apply( resourceKinds );
+
+static void BM_Pmr_StringChurn( benchmark::State& state )
+{
+	ResourceFixture fixture{static_cast<int>( state.range( 0 ) )};
+	const std::size_t count = static_cast<std::size_t>( state.range( 1 ) );
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		{
+			std::pmr::vector<std::pmr::string> strings{fixture.get()};
+			strings.reserve( count );
+			for ( std::size_t i = 0; i < count; ++i )
+			{
+				strings.emplace_back( churnText.substr( 0, getChurnLength( i ) ) );
+				strings.back() += churnText.substr( 0, getChurnLength( i + 1 ) );
+			}
+			benchmark::DoNotOptimize( strings.data() );
+		}
+		fixture.recycle();
+	}
+	state.SetItemsProcessed( state.iterations() * count );
+}
+BENCHMARK( BM_Pmr_StringChurn )->Apply( resourceKinds );
+
+BENCHMARK_MAIN();
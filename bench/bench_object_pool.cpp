@@ -0,0 +1,332 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "bench_common.h"
+#include "bitmap_pool.h"
+#include "object_pool.h"
+
+
+struct GameObject
+{
+	std::int32_t x, y, z;
+	std::int32_t cost;
+};
+
+template<std::size_t size>
+struct Blob
+{
+	unsigned char bytes[size];
+};
+
+// ObjectPool is not an std allocator (`allocate()` takes no count), so instead of
+//	container workloads it is measured on object churn: alloc/free pairs and batches freed out of order
+template<typename T>
+static void BM_ObjectPool_AllocateFree( benchmark::State& state )
+{
+	ObjectPool<T> pool{batchSize};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		T* p = pool.allocate();
+		benchmark::DoNotOptimize( p );
+		pool.deallocate( p );
+	}
+	state.SetItemsProcessed( state.iterations() );
+}
+BENCHMARK_TEMPLATE( BM_ObjectPool_AllocateFree, GameObject );
+BENCHMARK_TEMPLATE( BM_ObjectPool_AllocateFree, Blob<64> );
+BENCHMARK_TEMPLATE( BM_ObjectPool_AllocateFree, Blob<1024> );
+
+template<typename T>
+static void BM_ObjectPool_AllocateBatch( benchmark::State& state )
+{
+	ObjectPool<T> pool{batchSize};
+	std::array<T*, batchSize> objs{};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( auto& p : objs )
+		{
+			p = pool.allocate();
+		}
+		benchmark::DoNotOptimize( objs.data() );
+		for ( auto p : objs )
+		{
+			pool.deallocate( p );
+		}
+	}
+	for ( auto& p : objs )
+	{
+		p = pool.allocate();
+	}
+	reportStats( state,
+		pool.getStats() );
+	for ( auto p : objs )
+	{
+		pool.deallocate( p );
+	}
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK_TEMPLATE( BM_ObjectPool_AllocateBatch, GameObject );
+BENCHMARK_TEMPLATE( BM_ObjectPool_AllocateBatch, Blob<64> );
+BENCHMARK_TEMPLATE( BM_ObjectPool_AllocateBatch, Blob<1024> );
+
+// frees in a scrambled order so that the free list stops being address ordered
+static void BM_ObjectPool_Churn( benchmark::State& state )
+{
+	ObjectPool<GameObject> pool{batchSize};
+	std::array<GameObject*, batchSize> objs{};
+	std::array<std::size_t, batchSize> order{};
+	for ( std::size_t i = 0; i < batchSize; ++i )
+	{
+		order[i] = i;
+	}
+	std::shuffle( order.begin(),
+		order.end(),
+		std::mt19937{1453} );
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( auto& p : objs )
+		{
+			p = pool.construct( 1, 2, 3, 4 );
+		}
+		for ( const std::size_t i : order )
+		{
+			pool.destroy( objs[i] );
+		}
+	}
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK( BM_ObjectPool_Churn );
+
+// the same alloc/free pairs and batches from a BitmapPool
+template<typename T>
+static void BM_BitmapPool_AllocateFree( benchmark::State& state )
+{
+	BitmapPool<T> pool{batchSize};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		T* p = pool.allocate();
+		benchmark::DoNotOptimize( p );
+		pool.deallocate( p );
+	}
+	state.SetItemsProcessed( state.iterations() );
+}
+BENCHMARK_TEMPLATE( BM_BitmapPool_AllocateFree, GameObject );
+BENCHMARK_TEMPLATE( BM_BitmapPool_AllocateFree, Blob<64> );
+BENCHMARK_TEMPLATE( BM_BitmapPool_AllocateFree, Blob<1024> );
+
+template<typename T>
+static void BM_BitmapPool_AllocateBatch( benchmark::State& state )
+{
+	BitmapPool<T> pool{batchSize};
+	std::array<T*, batchSize> objs{};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( auto& p : objs )
+		{
+			p = pool.allocate();
+		}
+		benchmark::DoNotOptimize( objs.data() );
+		for ( auto p : objs )
+		{
+			pool.deallocate( p );
+		}
+	}
+	for ( auto& p : objs )
+	{
+		p = pool.allocate();
+	}
+	reportStats( state,
+		pool.getStats() );
+	for ( auto p : objs )
+	{
+		pool.deallocate( p );
+	}
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK_TEMPLATE( BM_BitmapPool_AllocateBatch, GameObject );
+BENCHMARK_TEMPLATE( BM_BitmapPool_AllocateBatch, Blob<64> );
+BENCHMARK_TEMPLATE( BM_BitmapPool_AllocateBatch, Blob<1024> );
+
+// memory bound: a pool far larger than the caches, half of it live, whose objects are
+//	replaced a batch at a time at random; ObjectPool writes a link into every cold object it
+//	frees and spreads the live ones over the whole pool, BitmapPool refills the lowest slots
+inline constexpr std::size_t largePoolSize = std::size_t{1} << 20;
+inline constexpr std::size_t nLargePoolLive = largePoolSize / 2;
+
+template<typename TPool>
+struct LivePool final
+{
+	TPool pool{largePoolSize};
+	std::vector<GameObject*> live;
+	std::mt19937 rng{1453};
+
+	LivePool()
+	{
+		std::vector<GameObject*> all(largePoolSize);
+		for ( auto& p : all )
+		{
+			p = pool.construct( 1, 2, 3, 4 );
+		}
+		std::shuffle( all.begin(),
+			all.end(),
+			rng );
+		for ( std::size_t i = nLargePoolLive; i < largePoolSize; ++i )
+		{
+			pool.destroy( all[i] );
+		}
+		live.assign( all.begin(),
+			all.begin() + nLargePoolLive );
+	}
+
+	~LivePool() noexcept
+	{
+		for ( GameObject* p : live )
+		{
+			pool.destroy( p );
+		}
+	}
+
+	// `batchSize` distinct random objects are moved to the back of `live` and replaced
+	void replaceBatch()
+	{
+		for ( std::size_t i = 0; i < batchSize; ++i )
+		{
+			const std::size_t back = nLargePoolLive - 1 - i;
+			std::swap( live[rng() % ( back + 1 )],
+				live[back] );
+			pool.destroy( live[back] );
+		}
+		for ( std::size_t i = nLargePoolLive - batchSize; i < nLargePoolLive; ++i )
+		{
+			live[i] = pool.construct( 1, 2, 3, static_cast<std::int32_t>( i ) );
+		}
+	}
+
+	// live objects over the slots up to the highest live one; 1 is perfectly packed
+	double getDensity() const noexcept
+	{
+		const GameObject* pHighest = *std::max_element( live.begin(),
+			live.end() );
+		const std::size_t span = static_cast<std::size_t>( reinterpret_cast<const unsigned char*>( pHighest )
+			- static_cast<const unsigned char*>( pool.getStartAddress() ) ) / sizeof( GameObject ) + 1;
+		return static_cast<double>( live.size() ) / static_cast<double>( span );
+	}
+};
+
+template<typename TPool>
+static void BM_LargePool_Churn( benchmark::State& state )
+{
+	LivePool<TPool> livePool;
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		livePool.replaceBatch();
+	}
+	state.counters["density"] = livePool.getDensity();
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK_TEMPLATE( BM_LargePool_Churn, ObjectPool<GameObject> );
+BENCHMARK_TEMPLATE( BM_LargePool_Churn, BitmapPool<GameObject> );
+
+// a pass over every live object after the churn has settled: the denser the pool, the fewer
+//	cache lines and pages it spans
+template<typename TPool>
+static void BM_LargePool_Traverse( benchmark::State& state )
+{
+	LivePool<TPool> livePool;
+	// long enough for practically every object of the initial shuffle to have been replaced
+	for ( std::size_t i = 0; i < 16 * largePoolSize / batchSize; ++i )
+	{
+		livePool.replaceBatch();
+	}
+	std::sort( livePool.live.begin(),
+		livePool.live.end() );
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		std::int64_t sum = 0;
+		for ( const GameObject* p : livePool.live )
+		{
+			sum += p->cost;
+		}
+		benchmark::DoNotOptimize( sum );
+	}
+	state.counters["density"] = livePool.getDensity();
+	state.SetItemsProcessed( state.iterations() * nLargePoolLive );
+}
+BENCHMARK_TEMPLATE( BM_LargePool_Traverse, ObjectPool<GameObject> );
+BENCHMARK_TEMPLATE( BM_LargePool_Traverse, BitmapPool<GameObject> );
+
+// each thread owns a pool, as in the thread_local pools of object_pool.cpp
+static void BM_ObjectPool_ThreadScaling( benchmark::State& state )
+{
+	ObjectPool<GameObject> pool{batchSize};
+	std::array<GameObject*, batchSize> objs{};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( auto& p : objs )
+		{
+			p = pool.allocate();
+		}
+		benchmark::DoNotOptimize( objs.data() );
+		for ( auto p : objs )
+		{
+			pool.deallocate( p );
+		}
+	}
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK( BM_ObjectPool_ThreadScaling ) ALLOCATORS_THREAD_RANGE;
+
+// one counter per thread, all handed out back to back from one shared pool;
+//	packed slots put several threads' counters on a cache line, padded slots one each
+struct Counter
+{
+	std::atomic<std::uint64_t> value;
+};
+
+template<bool cacheLinePadded>
+static Counter* getThreadCounter( const int threadIndex )
+{
+	static ObjectPool<Counter, cacheLinePadded> pool{maxBenchThreads};
+	static const std::array<Counter*, maxBenchThreads> counters = []
+		{
+			std::array<Counter*, maxBenchThreads> counters{};
+			for ( auto& p : counters )
+			{
+				p = pool.construct( 0u );
+			}
+			return counters;
+		}();
+	return counters[threadIndex];
+}
+
+template<bool cacheLinePadded>
+static void BM_ObjectPool_ThreadCounters( benchmark::State& state )
+{
+	Counter* pCounter = getThreadCounter<cacheLinePadded>( state.thread_index() );
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( std::size_t i = 0; i < batchSize; ++i )
+		{
+			// single writer: a plain load + store, no locked read-modify-write
+			pCounter->value.store( pCounter->value.load( std::memory_order_relaxed ) + 1,
+				std::memory_order_relaxed );
+		}
+	}
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK_TEMPLATE( BM_ObjectPool_ThreadCounters, false ) ALLOCATORS_THREAD_RANGE;
+BENCHMARK_TEMPLATE( BM_ObjectPool_ThreadCounters, true ) ALLOCATORS_THREAD_RANGE;
+
+BENCHMARK_MAIN();
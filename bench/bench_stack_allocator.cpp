@@ -0,0 +1,156 @@
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "bench_common.h"
+#include "stack_allocator.h"
+
+
+using TSArena = SArena<>;
+
+template<typename T>
+using SA = StackAllocator<T>;
+
+// StackAllocator( bytes ) creates an arena it never releases,
+//	so hand out one long-lived allocator per arena size instead of one per benchmark run
+static SA<char> getStackAllocator( const std::size_t bytes )
+{
+	static std::mutex mu;
+	static std::map<std::size_t, SA<char>> allocators;
+	std::lock_guard<std::mutex> lock{mu};
+	auto it = allocators.find( bytes );
+	if ( it == allocators.end() )
+	{
+		it = allocators.emplace( bytes, SA<char>{bytes} ).first;
+	}
+	it->second.reset();
+	return it->second;
+}
+
+static void BM_SArena_AllocateFixed( benchmark::State& state )
+{
+	const std::size_t bytes = static_cast<std::size_t>( state.range( 0 ) );
+	TSArena arena{batchSize * ( bytes + sizeof( std::size_t ) + TSArena::getAlignment() )};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( std::size_t i = 0; i < batchSize; ++i )
+		{
+			benchmark::DoNotOptimize( arena.allocate( bytes ) );
+		}
+		arena.reset();
+	}
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK( BM_SArena_AllocateFixed ) ALLOCATORS_FIXED_SIZES;
+
+static void BM_SArena_AllocateMixed( benchmark::State& state )
+{
+	const auto& sizes = getMixedSizes();
+	TSArena arena{getMixedSizesFootprint( TSArena::getAlignment(), sizeof( std::size_t ) )};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( const std::size_t bytes : sizes )
+		{
+			benchmark::DoNotOptimize( arena.allocate( bytes ) );
+		}
+		arena.reset();
+	}
+	for ( const std::size_t bytes : sizes )
+	{
+		benchmark::DoNotOptimize( arena.allocate( bytes ) );
+	}
+	reportStats( state,
+		arena.getStats() );
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK( BM_SArena_AllocateMixed );
+
+static void BM_StackAllocator_VectorGrowth( benchmark::State& state )
+{
+	const std::size_t count = static_cast<std::size_t>( state.range( 0 ) );
+	SA<int> sa{getStackAllocator( count * 4 * sizeof( int ) + 64 * 2 * TSArena::getAlignment() )};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		{
+			std::vector<int, SA<int>> vec( sa );
+			for ( std::size_t i = 0; i < count; ++i )
+			{
+				vec.push_back( static_cast<int>( i ) );
+			}
+			benchmark::DoNotOptimize( vec.data() );
+		}
+		sa.reset();
+	}
+	state.SetItemsProcessed( state.iterations() * count );
+}
+BENCHMARK( BM_StackAllocator_VectorGrowth ) ALLOCATORS_CONTAINER_SIZES;
+
+static void BM_StackAllocator_MapInsert( benchmark::State& state )
+{
+	using Map = std::map<int, int, std::less<int>, SA<std::pair<const int, int>>>;
+	const std::size_t count = static_cast<std::size_t>( state.range( 0 ) );
+	SA<std::pair<const int, int>> sa{getStackAllocator( count * 128 + 4096 )};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		{
+			Map map( sa );
+			for ( std::size_t i = 0; i < count; ++i )
+			{
+				map.emplace( getKey( i ), static_cast<int>( i ) );
+			}
+			benchmark::DoNotOptimize( map.size() );
+		}
+		sa.reset();
+	}
+	state.SetItemsProcessed( state.iterations() * count );
+}
+BENCHMARK( BM_StackAllocator_MapInsert ) ALLOCATORS_CONTAINER_SIZES;
+
+static void BM_StackAllocator_StringChurn( benchmark::State& state )
+{
+	using Str = std::basic_string<char, std::char_traits<char>, SA<char>>;
+	const std::size_t count = static_cast<std::size_t>( state.range( 0 ) );
+	SA<char> sa{getStackAllocator( count * 768 + 4096 )};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		{
+			std::vector<Str, SA<Str>> strings( sa );
+			strings.reserve( count );
+			for ( std::size_t i = 0; i < count; ++i )
+			{
+				strings.emplace_back( churnText.substr( 0, getChurnLength( i ) ), sa );
+				strings.back() += churnText.substr( 0, getChurnLength( i + 1 ) );
+			}
+			benchmark::DoNotOptimize( strings.data() );
+		}
+		sa.reset();
+	}
+	state.SetItemsProcessed( state.iterations() * count );
+}
+BENCHMARK( BM_StackAllocator_StringChurn ) ALLOCATORS_CONTAINER_SIZES;
+
+// SArena is single-threaded; each thread owns one, so this measures scaling without sharing
+static void BM_SArena_ThreadScaling( benchmark::State& state )
+{
+	const auto& sizes = getMixedSizes();
+	TSArena arena{getMixedSizesFootprint( TSArena::getAlignment(), sizeof( std::size_t ) )};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( const std::size_t bytes : sizes )
+		{
+			benchmark::DoNotOptimize( arena.allocate( bytes ) );
+		}
+		arena.reset();
+	}
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK( BM_SArena_ThreadScaling ) ALLOCATORS_THREAD_RANGE;
+
+BENCHMARK_MAIN();
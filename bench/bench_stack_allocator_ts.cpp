@@ -0,0 +1,243 @@
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "bench_common.h"
+#include "stack_allocator_thread_safe.h"
+
+
+using TSArena = SArenaTS<>;
+
+template<typename T>
+using SA = StackAllocatorTS<T>;
+
+
+static void BM_TSArena_AllocateFixed( benchmark::State& state )
+{
+	const std::size_t bytes = static_cast<std::size_t>( state.range( 0 ) );
+	TSArena arena{batchSize * ( bytes + sizeof( std::size_t ) + TSArena::getAlignment() )};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( std::size_t i = 0; i < batchSize; ++i )
+		{
+			benchmark::DoNotOptimize( arena.allocate( bytes ) );
+		}
+		arena.reset();
+	}
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK( BM_TSArena_AllocateFixed ) ALLOCATORS_FIXED_SIZES;
+
+static void BM_TSArena_AllocateMixed( benchmark::State& state )
+{
+	const auto& sizes = getMixedSizes();
+	TSArena arena{getMixedSizesFootprint( TSArena::getAlignment(), sizeof( std::size_t ) )};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( const std::size_t bytes : sizes )
+		{
+			benchmark::DoNotOptimize( arena.allocate( bytes ) );
+		}
+		arena.reset();
+	}
+	for ( const std::size_t bytes : sizes )
+	{
+		benchmark::DoNotOptimize( arena.allocate( bytes ) );
+	}
+	reportStats( state,
+		arena.getStats() );
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK( BM_TSArena_AllocateMixed );
+
+static void BM_StackAllocatorTS_VectorGrowth( benchmark::State& state )
+{
+	const std::size_t count = static_cast<std::size_t>( state.range( 0 ) );
+	TSArena arena{count * 4 * sizeof( int ) + 64 * 2 * TSArena::getAlignment()};
+	SA<int> sa{&arena};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		{
+			std::vector<int, SA<int>> vec( sa );
+			for ( std::size_t i = 0; i < count; ++i )
+			{
+				vec.push_back( static_cast<int>( i ) );
+			}
+			benchmark::DoNotOptimize( vec.data() );
+		}
+		sa.reset();
+	}
+	state.SetItemsProcessed( state.iterations() * count );
+}
+BENCHMARK( BM_StackAllocatorTS_VectorGrowth ) ALLOCATORS_CONTAINER_SIZES;
+
+static void BM_StackAllocatorTS_MapInsert( benchmark::State& state )
+{
+	using Map = std::map<int, int, std::less<int>, SA<std::pair<const int, int>>>;
+	const std::size_t count = static_cast<std::size_t>( state.range( 0 ) );
+	TSArena arena{count * 128 + 4096};
+	SA<std::pair<const int, int>> sa{&arena};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		{
+			Map map( sa );
+			for ( std::size_t i = 0; i < count; ++i )
+			{
+				map.emplace( getKey( i ), static_cast<int>( i ) );
+			}
+			benchmark::DoNotOptimize( map.size() );
+		}
+		sa.reset();
+	}
+	state.SetItemsProcessed( state.iterations() * count );
+}
+BENCHMARK( BM_StackAllocatorTS_MapInsert ) ALLOCATORS_CONTAINER_SIZES;
+
+static void BM_StackAllocatorTS_StringChurn( benchmark::State& state )
+{
+	using Str = std::basic_string<char, std::char_traits<char>, SA<char>>;
+	const std::size_t count = static_cast<std::size_t>( state.range( 0 ) );
+	TSArena arena{count * 768 + 4096};
+	SA<char> sa{&arena};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		{
+			std::vector<Str, SA<Str>> strings( sa );
+			strings.reserve( count );
+			for ( std::size_t i = 0; i < count; ++i )
+			{
+				strings.emplace_back( churnText.substr( 0, getChurnLength( i ) ), sa );
+				strings.back() += churnText.substr( 0, getChurnLength( i + 1 ) );
+			}
+			benchmark::DoNotOptimize( strings.data() );
+		}
+		sa.reset();
+	}
+	state.SetItemsProcessed( state.iterations() * count );
+}
+BENCHMARK( BM_StackAllocatorTS_StringChurn ) ALLOCATORS_CONTAINER_SIZES;
+
+// SArenaTS::allocate is not a single atomic read-modify-write, so concurrent use of one arena
+//	can hand out overlapping blocks; each thread owns an arena and this measures
+//	the cost of the atomic offset under scaling
+static void BM_StackAllocatorTS_ThreadScaling( benchmark::State& state )
+{
+	const auto& sizes = getMixedSizes();
+	TSArena arena{getMixedSizesFootprint( TSArena::getAlignment(), sizeof( std::size_t ) )};
+	SA<char> sa{&arena};
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( const std::size_t bytes : sizes )
+		{
+			benchmark::DoNotOptimize( sa.allocate( bytes ) );
+		}
+		sa.reset();
+	}
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK( BM_StackAllocatorTS_ThreadScaling ) ALLOCATORS_THREAD_RANGE;
+
+// the arena handle StackAllocatorTS used to have: every copy and rebind of the allocator bumps
+//	the atomic reference count in the arena's control block
+template<typename T>
+class SharedArenaAllocator
+{
+	template<typename U>
+	friend class SharedArenaAllocator;
+
+	std::shared_ptr<TSArena> m_pArena;
+public:
+	using value_type = T;
+
+	explicit SharedArenaAllocator( std::shared_ptr<TSArena> pArena ) noexcept
+		:
+		m_pArena{std::move( pArena )}
+	{
+
+	}
+
+	template<typename U>
+	SharedArenaAllocator( const SharedArenaAllocator<U>& rhs ) noexcept
+		:
+		m_pArena{rhs.m_pArena}
+	{
+
+	}
+
+	T* allocate( std::size_t count )
+	{
+		return static_cast<T*>( m_pArena->allocate( count * sizeof( T ) ) );
+	}
+
+	void deallocate( T* p,
+		std::size_t ) noexcept
+	{
+		m_pArena->deallocate( p );
+	}
+
+	template<typename U>
+	bool operator==( const SharedArenaAllocator<U>& rhs ) const noexcept
+	{
+		return m_pArena == rhs.m_pArena;
+	}
+
+	template<typename U>
+	bool operator!=( const SharedArenaAllocator<U>& rhs ) const noexcept
+	{
+		return m_pArena != rhs.m_pArena;
+	}
+};
+
+// every thread builds empty containers from copies of one allocator, so nothing is allocated
+//	and only the allocator copies are measured: a map, a vector and a string copy and rebind it
+//	several times each, as containers do on construction, moves and node allocation
+//	with the raw handle those copies are plain pointer copies; through a shared_ptr they are
+//	atomic increments and decrements on a cache line that bounces between the threads' cores
+template<typename TAlloc>
+static void BM_AllocatorCopies( benchmark::State& state,
+	const TAlloc& alloc )
+{
+	using TMapAlloc = typename std::allocator_traits<TAlloc>::template rebind_alloc<std::pair<const int, int>>;
+	using TIntAlloc = typename std::allocator_traits<TAlloc>::template rebind_alloc<int>;
+	using TCharAlloc = typename std::allocator_traits<TAlloc>::template rebind_alloc<char>;
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( std::size_t i = 0; i < batchSize; ++i )
+		{
+			std::map<int, int, std::less<int>, TMapAlloc> map( alloc );
+			std::vector<int, TIntAlloc> vec( alloc );
+			std::basic_string<char, std::char_traits<char>, TCharAlloc> str( alloc );
+			benchmark::DoNotOptimize( &map );
+			benchmark::DoNotOptimize( &vec );
+			benchmark::DoNotOptimize( &str );
+		}
+	}
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+
+static void BM_StackAllocatorTS_Copies( benchmark::State& state )
+{
+	static TSArena arena{4096};
+	BM_AllocatorCopies( state,
+		SA<char>{&arena} );
+}
+BENCHMARK( BM_StackAllocatorTS_Copies ) ALLOCATORS_THREAD_RANGE;
+
+static void BM_SharedPtrArena_Copies( benchmark::State& state )
+{
+	static const SharedArenaAllocator<char> alloc{std::make_shared<TSArena>( 4096 )};
+	BM_AllocatorCopies( state,
+		alloc );
+}
+BENCHMARK( BM_SharedPtrArena_Copies ) ALLOCATORS_THREAD_RANGE;
+
+BENCHMARK_MAIN();
@@ -0,0 +1,206 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "bench_common.h"
+#include "tlsf_allocator.h"
+
+
+// live blocks the latency workloads keep around; each step replaces a random one
+inline constexpr std::size_t nLiveBlocks = 4096;
+inline constexpr std::size_t tlsfHeapSize = 32 * 1024 * 1024;
+inline constexpr benchmark::IterationCount latencyIterations = 1024;
+
+// the heap is touched once up front, as a real-time heap would be (or locked with mlock()),
+//	so that page faults don't land in the timed calls
+struct TlsfPolicy final
+{
+	TlsfHeap heap{tlsfHeapSize};
+
+	//	in chunks: a request is rounded up to its size class, so the whole free block isn't one
+	TlsfPolicy()
+	{
+		constexpr std::size_t chunkSize = 1024 * 1024;
+		std::vector<void*> chunks;
+		while ( heap.getStats().largestFreeBlock > 2 * chunkSize )
+		{
+			chunks.push_back( heap.allocate( chunkSize ) );
+			std::memset( chunks.back(),
+				0,
+				chunkSize );
+		}
+		for ( void* p : chunks )
+		{
+			heap.deallocate( p );
+		}
+	}
+
+	void* allocate( const std::size_t bytes )
+	{
+		return heap.allocate( bytes );
+	}
+
+	void deallocate( void* p ) noexcept
+	{
+		heap.deallocate( p );
+	}
+};
+
+struct MallocPolicy final
+{
+	void* allocate( const std::size_t bytes )
+	{
+		return std::malloc( bytes );
+	}
+
+	void deallocate( void* p ) noexcept
+	{
+		std::free( p );
+	}
+};
+
+// the mixed sizes, with every 64th request a large one (up to 64 KiB) so that blocks of
+//	very different sizes sit side by side
+static std::size_t getChurnSize( const std::size_t step ) noexcept
+{
+	return step % 64 == 63 ?
+		4096 + ( step * 2654435761u ) % ( 60 * 1024 ) :
+		getMixedSizes()[step % batchSize];
+}
+
+static void reportLatencies( benchmark::State& state,
+	std::vector<std::uint32_t>& latencies )
+{
+	if ( latencies.empty() )
+	{
+		return;
+	}
+	std::sort( latencies.begin(),
+		latencies.end() );
+	const auto percentile = [&latencies] ( const double fraction )
+		{
+			return static_cast<double>( latencies[static_cast<std::size_t>( fraction * ( latencies.size() - 1 ) )] );
+		};
+	state.counters["p50_ns"] = percentile( 0.5 );
+	state.counters["p99_ns"] = percentile( 0.99 );
+	state.counters["p99.9_ns"] = percentile( 0.999 );
+	state.counters["max_ns"] = static_cast<double>( latencies.back() );
+}
+
+// the latency of every single `allocate()`/`deallocate()` in a long churn over a full live set
+//	each call is timed on its own with steady_clock, whose own cost (tens of ns) is in every
+//	sample of both allocators alike; the percentiles are what matters, max being the
+//	worst case seen
+template<typename TPolicy>
+static void BM_ChurnLatency( benchmark::State& state )
+{
+	using Clock = std::chrono::steady_clock;
+	TPolicy policy;
+	std::array<void*, nLiveBlocks> live{};
+	std::mt19937 rng{1453};
+	std::size_t step = 0;
+	for ( auto& p : live )
+	{
+		p = policy.allocate( getChurnSize( step++ ) );
+	}
+	std::vector<std::uint32_t> latencies;
+	latencies.reserve( 2 * latencyIterations * batchSize );
+	for ( auto _ : state )
+	{
+		for ( std::size_t i = 0; i < batchSize; ++i, ++step )
+		{
+			void*& p = live[rng() % nLiveBlocks];
+			const Clock::time_point start = Clock::now();
+			policy.deallocate( p );
+			const Clock::time_point freed = Clock::now();
+			p = policy.allocate( getChurnSize( step ) );
+			const Clock::time_point allocated = Clock::now();
+			benchmark::DoNotOptimize( p );
+			latencies.push_back( static_cast<std::uint32_t>( std::chrono::duration_cast<std::chrono::nanoseconds>( freed - start ).count() ) );
+			latencies.push_back( static_cast<std::uint32_t>( std::chrono::duration_cast<std::chrono::nanoseconds>( allocated - freed ).count() ) );
+		}
+	}
+	for ( void* p : live )
+	{
+		policy.deallocate( p );
+	}
+	reportLatencies( state,
+		latencies );
+	state.SetItemsProcessed( state.iterations() * batchSize * 2 );
+}
+BENCHMARK_TEMPLATE( BM_ChurnLatency, TlsfPolicy )->Iterations( latencyIterations );
+BENCHMARK_TEMPLATE( BM_ChurnLatency, MallocPolicy )->Iterations( latencyIterations );
+
+// the same churn untimed per call, for throughput
+template<typename TPolicy>
+static void BM_Churn( benchmark::State& state )
+{
+	TPolicy policy;
+	std::array<void*, nLiveBlocks> live{};
+	std::mt19937 rng{1453};
+	std::size_t step = 0;
+	for ( auto& p : live )
+	{
+		p = policy.allocate( getChurnSize( step++ ) );
+	}
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( std::size_t i = 0; i < batchSize; ++i, ++step )
+		{
+			void*& p = live[rng() % nLiveBlocks];
+			policy.deallocate( p );
+			p = policy.allocate( getChurnSize( step ) );
+			benchmark::DoNotOptimize( p );
+		}
+	}
+	for ( void* p : live )
+	{
+		policy.deallocate( p );
+	}
+	state.SetItemsProcessed( state.iterations() * batchSize * 2 );
+}
+BENCHMARK_TEMPLATE( BM_Churn, TlsfPolicy );
+BENCHMARK_TEMPLATE( BM_Churn, MallocPolicy );
+
+// a batch of mixed sizes freed out of order, as in the other allocator benchmarks
+static void BM_Tlsf_AllocateMixed( benchmark::State& state )
+{
+	const auto& sizes = getMixedSizes();
+	TlsfHeap heap{getMixedSizesFootprint( TlsfHeap::getAlignment(), TlsfHeap::getHeaderSize() ) * 2};
+	std::array<void*, batchSize> blocks{};
+	std::array<std::size_t, batchSize> order{};
+	for ( std::size_t i = 0; i < batchSize; ++i )
+	{
+		order[i] = i;
+	}
+	std::shuffle( order.begin(),
+		order.end(),
+		std::mt19937{1453} );
+	PerfCounters perf{state};
+	for ( auto _ : state )
+	{
+		for ( std::size_t i = 0; i < batchSize; ++i )
+		{
+			blocks[i] = heap.allocate( sizes[i] );
+		}
+		benchmark::DoNotOptimize( blocks.data() );
+		for ( const std::size_t i : order )
+		{
+			heap.deallocate( blocks[i] );
+		}
+	}
+	for ( std::size_t i = 0; i < batchSize; ++i )
+	{
+		blocks[i] = heap.allocate( sizes[i] );
+	}
+	reportStats( state,
+		heap.getStats() );
+	state.SetItemsProcessed( state.iterations() * batchSize );
+}
+BENCHMARK( BM_Tlsf_AllocateMixed );
+
+BENCHMARK_MAIN();
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <benchmark/benchmark.h>
+#if defined __linux__
+#	include <linux/perf_event.h>
+#	include <sys/ioctl.h>
+#	include <sys/syscall.h>
+#	include <unistd.h>
+#endif
+
+
+//======================================================================
+// \class	PerfCounters
+//
+// \brief	Hardware performance counters around a benchmark's timed loop.
+//			Construct right before `for ( auto _ : state )`; on destruction
+//				the per-iteration counts are added to `state.counters`
+//				(summed across threads, divided by iterations).
+//			Counters are opened as one perf_event_open group of the calling thread,
+//				user space only. Any counter the kernel/hardware refuses is skipped.
+//				When none is available (non-Linux, VM without a PMU, perf_event_paranoid)
+//				nothing is reported and the benchmark runs as usual.
+//			Set ALLOCATORS_PERF_COUNTERS=0 in the environment to disable collection.
+//======================================================================
+class PerfCounters final
+{
+	struct Event
+	{
+		const char* name;
+		std::uint32_t type;
+		std::uint64_t config;
+	};
+
+#if defined __linux__
+	static constexpr std::uint64_t dTlbReadMiss = PERF_COUNT_HW_CACHE_DTLB
+		| ( PERF_COUNT_HW_CACHE_OP_READ << 8 )
+		| ( PERF_COUNT_HW_CACHE_RESULT_MISS << 16 );
+
+	static constexpr std::array<Event, 4> m_events{{
+		{"cache_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+		{"dtlb_misses", PERF_TYPE_HW_CACHE, dTlbReadMiss},
+		{"branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+		{"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS}
+	}};
+#else
+	static constexpr std::array<Event, 0> m_events{};
+#endif
+
+	static constexpr std::size_t m_maxEvents = 4;
+
+	benchmark::State& m_state;
+	int m_leaderFd = -1;
+	std::size_t m_nOpen = 0;
+	std::array<int, m_maxEvents> m_fds{};
+	// index into m_events of each open counter, in group read order
+	std::array<std::size_t, m_maxEvents> m_eventIndex{};
+public:
+	static bool isEnabled() noexcept
+	{
+		const char* env = std::getenv( "ALLOCATORS_PERF_COUNTERS" );
+		return env == nullptr || std::strcmp( env, "0" ) != 0;
+	}
+
+	explicit PerfCounters( benchmark::State& state ) noexcept
+		:
+		m_state{state}
+	{
+		m_fds.fill( -1 );
+#if defined __linux__
+		if ( !isEnabled() )
+		{
+			return;
+		}
+		for ( std::size_t i = 0; i < m_events.size(); ++i )
+		{
+			perf_event_attr attr;
+			std::memset( &attr, 0, sizeof( attr ) );
+			attr.size = sizeof( attr );
+			attr.type = m_events[i].type;
+			attr.config = m_events[i].config;
+			attr.disabled = m_leaderFd == -1 ? 1 : 0;
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			attr.read_format = PERF_FORMAT_GROUP
+				| PERF_FORMAT_TOTAL_TIME_ENABLED
+				| PERF_FORMAT_TOTAL_TIME_RUNNING;
+			const int fd = static_cast<int>( syscall( SYS_perf_event_open,
+				&attr,
+				0,
+				-1,
+				m_leaderFd,
+				0 ) );
+			if ( fd == -1 )
+			{
+				continue;
+			}
+			if ( m_leaderFd == -1 )
+			{
+				m_leaderFd = fd;
+			}
+			m_fds[m_nOpen] = fd;
+			m_eventIndex[m_nOpen] = i;
+			++m_nOpen;
+		}
+		if ( m_leaderFd != -1 )
+		{
+			ioctl( m_leaderFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP );
+			ioctl( m_leaderFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP );
+		}
+#endif
+	}
+
+	~PerfCounters() noexcept
+	{
+#if defined __linux__
+		if ( m_leaderFd != -1 )
+		{
+			ioctl( m_leaderFd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP );
+			// nr, time_enabled, time_running, values[nr]
+			std::array<std::uint64_t, 3 + m_maxEvents> buf{};
+			if ( read( m_leaderFd, buf.data(), sizeof( buf ) ) > 0 && buf[2] > 0 )
+			{
+				// scale up if the group was multiplexed with other perf users
+				const double scale = static_cast<double>( buf[1] ) / static_cast<double>( buf[2] );
+				for ( std::size_t i = 0; i < buf[0] && i < m_nOpen; ++i )
+				{
+					m_state.counters[m_events[m_eventIndex[i]].name] = benchmark::Counter(
+						static_cast<double>( buf[3 + i] ) * scale,
+						benchmark::Counter::kAvgIterations );
+				}
+			}
+		}
+		for ( std::size_t i = 0; i < m_nOpen; ++i )
+		{
+			close( m_fds[i] );
+		}
+#endif
+	}
+
+	PerfCounters( const PerfCounters& rhs ) = delete;
+	PerfCounters& operator=( const PerfCounters& rhs ) = delete;
+
+	// whether at least one hardware counter is being collected
+	bool isCollecting() const noexcept
+	{
+		return m_nOpen > 0;
+	}
+};
@@ -0,0 +1,265 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include "allocator_utils.h"
+#include "assertions.h"
+
+
+//======================================================================
+// \class	MemoryBudget
+//
+// \brief	a node in a tree of memory budgets, eg. one for the process with a child per
+//				subsystem (render, audio, network)
+//			an `Arena`, `SArena` or `ObjectPool` created against a node charges its backing
+//				memory to that node and all of its ancestors, and refunds it when destroyed; a
+//				charge that would take any of them past its limit fails and charges nothing, so
+//				a runaway subsystem gets std::bad_alloc from its own allocators while the rest
+//				of the process is unaffected
+//			every node's usage covers its whole subtree and is an atomic, so `getUsage()` and
+//				`getPeak()` are O(1) from any thread, and charges may come from any thread; a
+//				charge is a compare-exchange per level, which never lets a node's usage exceed
+//				its limit, not even briefly
+//			building the tree is not thread safe: create the nodes up front; a node must outlive
+//				its children and everything charged to it
+//======================================================================
+class MemoryBudget final
+{
+	const char* m_name;
+	MemoryBudget* m_pParent;
+	MemoryBudget* m_pFirstChild;
+	MemoryBudget* m_pNextSibling;
+	std::atomic<std::size_t> m_limit;
+	std::atomic<std::size_t> m_usage;
+	std::atomic<std::size_t> m_peak;
+	std::atomic<std::size_t> m_nFailedCharges;
+public:
+	static constexpr std::size_t unlimited = ~std::size_t{0};
+
+	// `name` must outlive the node; a child is added to `pParent`'s children
+	explicit MemoryBudget( const char* name,
+		const std::size_t limit = unlimited,
+		MemoryBudget* pParent = nullptr ) noexcept
+		:
+		m_name{name},
+		m_pParent{pParent},
+		m_pFirstChild{nullptr},
+		m_pNextSibling{nullptr},
+		m_limit{limit},
+		m_usage{0},
+		m_peak{0},
+		m_nFailedCharges{0}
+	{
+		if ( m_pParent != nullptr )
+		{
+			m_pNextSibling = m_pParent->m_pFirstChild;
+			m_pParent->m_pFirstChild = this;
+		}
+	}
+
+	~MemoryBudget() noexcept
+	{
+		ASSERT( m_pFirstChild == nullptr,
+			"MemoryBudget destroyed before its children!" );
+		ASSERT( getUsage() == 0,
+			"MemoryBudget destroyed with memory still charged to it!" );
+		if ( m_pParent != nullptr )
+		{
+			MemoryBudget** ppNode = &m_pParent->m_pFirstChild;
+			while ( *ppNode != this )
+			{
+				ppNode = &( *ppNode )->m_pNextSibling;
+			}
+			*ppNode = m_pNextSibling;
+		}
+	}
+
+	MemoryBudget( const MemoryBudget& rhs ) = delete;
+	MemoryBudget& operator=( const MemoryBudget& rhs ) = delete;
+
+	// charges `bytes` to this node and its ancestors, or to none of them if any would go
+	//	past its limit
+	bool tryCharge( const std::size_t bytes ) noexcept
+	{
+		for ( MemoryBudget* pNode = this; pNode != nullptr; pNode = pNode->m_pParent )
+		{
+			if ( !pNode->tryAdd( bytes ) )
+			{
+				for ( MemoryBudget* pCharged = this; pCharged != pNode; pCharged = pCharged->m_pParent )
+				{
+					pCharged->m_usage.fetch_sub( bytes,
+						std::memory_order_relaxed );
+				}
+				m_nFailedCharges.fetch_add( 1,
+					std::memory_order_relaxed );
+				return false;
+			}
+		}
+		// only now, so a charge rolled back never shows in a peak
+		for ( MemoryBudget* pNode = this; pNode != nullptr; pNode = pNode->m_pParent )
+		{
+			pNode->updatePeak();
+		}
+		return true;
+	}
+
+	// throws std::bad_alloc if the charge fails
+	void charge( const std::size_t bytes )
+	{
+		if ( !tryCharge( bytes ) )
+		{
+			throw std::bad_alloc{};
+		}
+	}
+
+	void release( const std::size_t bytes ) noexcept
+	{
+		for ( MemoryBudget* pNode = this; pNode != nullptr; pNode = pNode->m_pParent )
+		{
+			ASSERT( pNode->getUsage() >= bytes,
+				"MemoryBudget released more than was charged!" );
+			pNode->m_usage.fetch_sub( bytes,
+				std::memory_order_relaxed );
+		}
+	}
+
+	// caps the node at run time; memory already charged stays, but no charge takes the
+	//	usage past the new limit
+	void setLimit( const std::size_t limit ) noexcept
+	{
+		m_limit.store( limit,
+			std::memory_order_relaxed );
+	}
+
+	// starts a new peak measurement from the current usage
+	void resetPeak() noexcept
+	{
+		m_peak.store( getUsage(),
+			std::memory_order_relaxed );
+	}
+
+	// GETTERS
+	const char* getName() const noexcept
+	{
+		return m_name;
+	}
+
+	std::size_t getLimit() const noexcept
+	{
+		return m_limit.load( std::memory_order_relaxed );
+	}
+
+	// bytes charged to this node and its subtree
+	std::size_t getUsage() const noexcept
+	{
+		return m_usage.load( std::memory_order_relaxed );
+	}
+
+	std::size_t getPeak() const noexcept
+	{
+		return m_peak.load( std::memory_order_relaxed );
+	}
+
+	// charges made directly against this node that failed, here or at an ancestor
+	std::size_t getFailedCharges() const noexcept
+	{
+		return m_nFailedCharges.load( std::memory_order_relaxed );
+	}
+
+	MemoryBudget* getParent() const noexcept
+	{
+		return m_pParent;
+	}
+
+	// the children, latest first, are `getFirstChild()` and its `getNextSibling()`s
+	MemoryBudget* getFirstChild() const noexcept
+	{
+		return m_pFirstChild;
+	}
+
+	MemoryBudget* getNextSibling() const noexcept
+	{
+		return m_pNextSibling;
+	}
+private:
+	bool tryAdd( const std::size_t bytes ) noexcept
+	{
+		const std::size_t limit = getLimit();
+		std::size_t usage = m_usage.load( std::memory_order_relaxed );
+		do
+		{
+			if ( bytes > limit || usage > limit - bytes )
+			{
+				return false;
+			}
+		} while ( !m_usage.compare_exchange_weak( usage,
+			usage + bytes,
+			std::memory_order_relaxed ) );
+		return true;
+	}
+
+	void updatePeak() noexcept
+	{
+		const std::size_t usage = getUsage();
+		std::size_t peak = m_peak.load( std::memory_order_relaxed );
+		while ( usage > peak
+			&& !m_peak.compare_exchange_weak( peak,
+				usage,
+				std::memory_order_relaxed ) )
+		{
+
+		}
+	}
+};
+
+// the allocators take an optional budget; nullptr charges nothing
+inline void chargeBudget( MemoryBudget* pBudget,
+	const std::size_t bytes )
+{
+	if ( pBudget != nullptr )
+	{
+		pBudget->charge( bytes );
+	}
+}
+
+inline void releaseBudget( MemoryBudget* pBudget,
+	const std::size_t bytes ) noexcept
+{
+	if ( pBudget != nullptr )
+	{
+		pBudget->release( bytes );
+	}
+}
+
+// `alignedMalloc<alignment>()` charged to `pBudget`; the charge is refunded if the allocation throws
+template<std::size_t alignment>
+void* budgetedAlignedMalloc( MemoryBudget* pBudget,
+	const std::size_t bytes )
+{
+	chargeBudget( pBudget,
+		bytes );
+	try
+	{
+		return alignedMalloc<alignment>( bytes );
+	}
+	catch ( ... )
+	{
+		releaseBudget( pBudget,
+			bytes );
+		throw;
+	}
+}
+
+template<std::size_t alignment>
+void budgetedAlignedFree( MemoryBudget* pBudget,
+	void* p,
+	const std::size_t bytes ) noexcept
+{
+	if ( p != nullptr )
+	{
+		alignedFree<alignment>( p );
+		releaseBudget( pBudget,
+			bytes );
+	}
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include "allocator_utils.h"
+
+
+//======================================================================
+// \class	SizeClassFormula
+//
+// \brief	the class index <-> slot size mapping of `SizeClasses`, computed with
+//				shifts and a count leading zeros; no division, no table
+//			classes are `t_alignment` apart up to `t_alignment * t_stepsPerDoubling`,
+//				then `t_stepsPerDoubling` geometric steps per power of 2
+//				eg. <16, 4>: 16 32 48 64 | 80 96 112 128 | 160 192 224 256 | 320 ...
+//			so a slot wastes less than 1 / t_stepsPerDoubling of itself on rounding
+//======================================================================
+template<std::size_t t_alignment, std::size_t t_stepsPerDoubling>
+class SizeClassFormula
+{
+	static_assert( isPowerOfTwo( t_alignment ),
+		"SizeClasses alignment must be a power of 2." );
+	static_assert( isPowerOfTwo( t_stepsPerDoubling ),
+		"SizeClasses steps per doubling must be a power of 2." );
+protected:
+	static constexpr std::size_t m_log2Alignment = floorLog2( t_alignment );
+	static constexpr std::size_t m_log2Steps = floorLog2( t_stepsPerDoubling );
+	// end of the linear region
+	static constexpr std::size_t m_linearMax = t_alignment * t_stepsPerDoubling;
+	static constexpr std::size_t m_log2LinearMax = floorLog2( m_linearMax );
+public:
+	static constexpr std::size_t computeClassIndex( const std::size_t size ) noexcept
+	{
+		if ( size <= m_linearMax )
+		{
+			return size == 0 ?
+				0 :
+				( size - 1 ) >> m_log2Alignment;
+		}
+		const std::size_t log2 = floorLog2( size - 1 );
+		const std::size_t step = ( ( size - 1 - ( std::size_t{1} << log2 ) ) >> ( log2 - m_log2Steps ) ) + 1;
+		return t_stepsPerDoubling - 1 + ( ( log2 - m_log2LinearMax ) << m_log2Steps ) + step;
+	}
+
+	static constexpr std::size_t computeSlotSize( const std::size_t classIndex ) noexcept
+	{
+		if ( classIndex < t_stepsPerDoubling )
+		{
+			return ( classIndex + 1 ) << m_log2Alignment;
+		}
+		const std::size_t k = classIndex - t_stepsPerDoubling;
+		const std::size_t powerOfTwo = std::size_t{1} << ( m_log2LinearMax + ( k >> m_log2Steps ) );
+		return powerOfTwo + ( ( k & ( t_stepsPerDoubling - 1 ) ) + 1 ) * ( powerOfTwo >> m_log2Steps );
+	}
+};
+
+//======================================================================
+// \class	SizeClasses
+//
+// \brief	compile time size class table for pool and arena based allocators
+//			size -> class index -> slot size, every slot size a multiple of `t_alignment`
+//			requests up to `t_maxSize`; eg. <1024, 16, 4> has 20 classes, 16 ... 1024
+//			`getClassIndex()` is a single table load; the inherited `computeClassIndex()`
+//				derives the same index without the table
+//======================================================================
+template<std::size_t t_maxSize,
+	std::size_t t_alignment = alignof( std::max_align_t ),
+	std::size_t t_stepsPerDoubling = 4>
+class SizeClasses final
+	: public SizeClassFormula<t_alignment, t_stepsPerDoubling>
+{
+	using TFormula = SizeClassFormula<t_alignment, t_stepsPerDoubling>;
+	using TFormula::m_log2Alignment;
+
+	static_assert( t_maxSize >= t_alignment,
+		"SizeClasses needs room for at least one class." );
+
+	static constexpr std::size_t m_nClasses = TFormula::computeClassIndex( t_maxSize ) + 1;
+	// one entry per `t_alignment` granule of request size
+	static constexpr std::size_t m_nGranules = ( calcAlignedSize( t_maxSize, t_alignment ) >> m_log2Alignment ) + 1;
+
+	using TClassIndex = std::conditional_t<m_nClasses <= 256, std::uint8_t, std::uint16_t>;
+
+	static constexpr std::array<TClassIndex, m_nGranules> makeClassIndices() noexcept
+	{
+		std::array<TClassIndex, m_nGranules> indices{};
+		for ( std::size_t granule = 0; granule < m_nGranules; ++granule )
+		{
+			indices[granule] = static_cast<TClassIndex>( TFormula::computeClassIndex( granule << m_log2Alignment ) );
+		}
+		return indices;
+	}
+
+	static constexpr std::array<std::size_t, m_nClasses> makeSlotSizes() noexcept
+	{
+		std::array<std::size_t, m_nClasses> sizes{};
+		for ( std::size_t c = 0; c < m_nClasses; ++c )
+		{
+			sizes[c] = TFormula::computeSlotSize( c );
+		}
+		return sizes;
+	}
+
+	static constexpr std::array<TClassIndex, m_nGranules> m_classIndices = makeClassIndices();
+	static constexpr std::array<std::size_t, m_nClasses> m_slotSizes = makeSlotSizes();
+
+	static_assert( m_nClasses <= 65536,
+		"too many size classes; raise the alignment or lower the steps per doubling" );
+public:
+	// `size` must not exceed `getMaxSize()`
+	static constexpr std::size_t getClassIndex( const std::size_t size ) noexcept
+	{
+		return m_classIndices[( size + ( t_alignment - 1 ) ) >> m_log2Alignment];
+	}
+
+	static constexpr std::size_t getSlotSize( const std::size_t classIndex ) noexcept
+	{
+		return m_slotSizes[classIndex];
+	}
+
+	// the slot a request of `size` bytes gets
+	static constexpr std::size_t roundUp( const std::size_t size ) noexcept
+	{
+		return getSlotSize( getClassIndex( size ) );
+	}
+
+	static constexpr std::size_t getClassCount() noexcept
+	{
+		return m_nClasses;
+	}
+
+	static constexpr std::size_t getMaxSize() noexcept
+	{
+		return t_maxSize;
+	}
+
+	static constexpr std::size_t getAlignment() noexcept
+	{
+		return t_alignment;
+	}
+};